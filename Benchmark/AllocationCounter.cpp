@@ -0,0 +1,130 @@
+﻿# include "AllocationCounter.hpp"
+# include <cstdlib>
+# include <fstream>
+# include <new>
+
+namespace
+{
+	std::atomic<uint64> g_numAllocations = 0;
+
+	std::atomic<uint64> g_allocatedBytes = 0;
+
+	[[nodiscard]]
+	void* Allocate(const size_t size, const size_t alignment)
+	{
+		g_numAllocations.fetch_add(1, std::memory_order_relaxed);
+		g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+		void* p = nullptr;
+
+		if (alignment <= alignof(std::max_align_t))
+		{
+			p = std::malloc(Max<size_t>(size, 1));
+		}
+		else
+		{
+			// aligned_alloc のサイズはアライメントの倍数である必要があります。
+			p = std::aligned_alloc(alignment, (((Max<size_t>(size, 1) + alignment - 1) / alignment) * alignment));
+		}
+
+		if (not p)
+		{
+			throw std::bad_alloc{};
+		}
+
+		return p;
+	}
+}
+
+void* operator new(const size_t size)
+{
+	return Allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(const size_t size, const std::align_val_t alignment)
+{
+	return Allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+namespace AllocationCounter
+{
+	uint64 NumAllocations() noexcept
+	{
+		return g_numAllocations.load(std::memory_order_relaxed);
+	}
+
+	uint64 AllocatedBytes() noexcept
+	{
+		return g_allocatedBytes.load(std::memory_order_relaxed);
+	}
+
+	uint64 PeakRSSBytes()
+	{
+		// Linux では /proc/self/status の VmHWM がピーク時の常駐メモリです。
+		std::ifstream status{ "/proc/self/status" };
+		std::string line;
+
+		while (std::getline(status, line))
+		{
+			if (line.starts_with("VmHWM:"))
+			{
+				return (std::strtoull(line.c_str() + 6, nullptr, 10) * 1024);
+			}
+		}
+
+		return 0;
+	}
+
+	bool ResetPeakRSS()
+	{
+		// Linux 4.0 以降では、clear_refs に 5 を書き込むと VmHWM が現在の値に戻ります。
+		std::ofstream clearRefs{ "/proc/self/clear_refs" };
+
+		if (not clearRefs)
+		{
+			return false;
+		}
+
+		clearRefs << "5";
+		return static_cast<bool>(clearRefs);
+	}
+
+	Scope::Scope()
+	{
+		ResetPeakRSS();
+
+		// 記録を戻すための確保を数えないよう、戻した後に開始します。
+		numAllocations = NumAllocations();
+		allocatedBytes = AllocatedBytes();
+	}
+
+	uint64 Scope::allocations() const noexcept
+	{
+		return (NumAllocations() - numAllocations);
+	}
+
+	uint64 Scope::bytes() const noexcept
+	{
+		return (AllocatedBytes() - allocatedBytes);
+	}
+}
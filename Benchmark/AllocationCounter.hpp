@@ -0,0 +1,42 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+
+/// @brief グローバルな operator new を置き換えて、ヒープの確保を数えます。
+namespace AllocationCounter
+{
+	/// @brief 起動してからの operator new の呼び出し回数を返します。
+	[[nodiscard]]
+	uint64 NumAllocations() noexcept;
+
+	/// @brief 起動してから operator new で確保したバイト数の合計を返します。
+	[[nodiscard]]
+	uint64 AllocatedBytes() noexcept;
+
+	/// @brief プロセスのピーク時の常駐メモリ（バイト）を返します。
+	/// @return ピーク時の常駐メモリ。取得できない環境では 0
+	[[nodiscard]]
+	uint64 PeakRSSBytes();
+
+	/// @brief ピーク時の常駐メモリの記録を現在の値に戻します。
+	/// @return 戻せた場合 true, それ以外の場合は false
+	bool ResetPeakRSS();
+
+	/// @brief 区間のヒープの確保とピーク時の常駐メモリです。
+	struct Scope
+	{
+		uint64 numAllocations = 0;
+
+		uint64 allocatedBytes = 0;
+
+		/// @brief 区間を開始します。ピーク時の常駐メモリの記録を戻します。
+		Scope();
+
+		/// @brief 区間の開始から現在までのヒープの確保の回数を返します。
+		[[nodiscard]]
+		uint64 allocations() const noexcept;
+
+		/// @brief 区間の開始から現在までに確保したバイト数を返します。
+		[[nodiscard]]
+		uint64 bytes() const noexcept;
+	};
+}
@@ -0,0 +1,80 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include "IConfig.hpp"
+# include "ConfigSchema.hpp"
+# include "TableConfig.hpp"
+
+/// @brief ベンチマークでパースする config です。points の要素数でファイルのサイズを調整します。
+struct BenchCircle : IConfig
+{
+	static constexpr StringView DataType = U"benchCircle";
+
+	Vec2 center{ 0, 0 };
+
+	double radius = 0.0;
+
+	String name;
+
+	Array<Vec2> points;
+
+	[[nodiscard]]
+	StringView dataType() const override
+	{
+		return DataType;
+	}
+
+	[[nodiscard]]
+	static constexpr auto Schema()
+	{
+		return ConfigSchema{
+			ConfigField{ U"center", &BenchCircle::center },
+			ConfigField{ U"radius", &BenchCircle::radius },
+			ConfigField{ U"name", &BenchCircle::name },
+			ConfigField{ U"points", &BenchCircle::points } };
+	}
+
+	[[nodiscard]]
+	static std::unique_ptr<BenchCircle> Parse(const JSON& json)
+	{
+		return Schema().parse(json);
+	}
+
+	template <class Archive>
+	void SIV3D_SERIALIZE(Archive& archive)
+	{
+		archive(center, radius, name, points);
+	}
+};
+
+/// @brief ベンチマークでパースする表の config です。
+struct BenchCircleTable : IConfig
+{
+	static constexpr StringView DataType = U"benchCircleTable";
+
+	Array<double> x;
+
+	Array<double> y;
+
+	Array<double> radius;
+
+	[[nodiscard]]
+	StringView dataType() const override
+	{
+		return DataType;
+	}
+
+	[[nodiscard]]
+	static constexpr auto Schema()
+	{
+		return TableSchema{
+			TableColumn{ U"x", &BenchCircleTable::x },
+			TableColumn{ U"y", &BenchCircleTable::y },
+			TableColumn{ U"radius", &BenchCircleTable::radius } };
+	}
+
+	template <class Archive>
+	void SIV3D_SERIALIZE(Archive& archive)
+	{
+		archive(x, y, radius);
+	}
+};
@@ -0,0 +1,114 @@
+﻿# include "BenchmarkData.hpp"
+
+namespace
+{
+	/// @brief 数値を`x0, y0, x1, y1, ...`の形式で並べます。
+	[[nodiscard]]
+	static String JoinNumbers(const size_t count, const size_t seed)
+	{
+		String text;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (i != 0)
+			{
+				text += U", ";
+			}
+
+			text += Format((seed + i) * 0.5);
+		}
+
+		return text;
+	}
+
+	/// @brief ファイルに UTF-8 の文字列を書き出します。
+	static bool WriteUTF8(const FilePathView path, const std::string& text)
+	{
+		BinaryWriter writer{ path };
+
+		if (not writer)
+		{
+			return false;
+		}
+
+		writer.write(text.data(), static_cast<int64>(text.size()));
+		return true;
+	}
+}
+
+namespace BenchmarkData
+{
+	JSON MakeTypedValues(const size_t numValues)
+	{
+		return JSON::Parse(UR"({{
+			"int32": {{ "type": "int", "value": 42 }},
+			"double": {{ "type": "double", "value": 3.5 }},
+			"Vec2": {{ "type": "Vec2", "x": 1.5, "y": -2.0 }},
+			"ColorF": {{ "type": "ColorF", "r": 0.1, "g": 0.2, "b": 0.3, "a": 1.0 }},
+			"String": {{ "type": "String", "value": "benchmark" }},
+			"bool": {{ "type": "bool", "value": true }},
+			"Vec2[]": {{ "type": "Vec2[]", "data": [{0}] }},
+			"Vec2[]text": {{ "type": "Vec2[]", "data": "{0}" }}
+		}})"_fmt(JoinNumbers(numValues * 2, 0)));
+	}
+
+	std::string MakeCircleJSON(const size_t index, const size_t valuesPerFile)
+	{
+		return Unicode::ToUTF8(UR"({{
+	"dataType": "benchCircle",
+	"center": {{ "type": "Vec2", "x": {0}, "y": {1} }},
+	"radius": {{ "type": "double", "value": {2} }},
+	"name": {{ "type": "String", "value": "circle{3}" }},
+	"points": {{ "type": "Vec2[]", "data": [{4}] }}
+}})"_fmt((index % 1280), (index % 720), (10 + index % 50), index, JoinNumbers(valuesPerFile * 2, index)));
+	}
+
+	Array<FilePath> WriteCircleFiles(const FilePathView directory, const size_t count, const size_t valuesPerFile, const size_t seed)
+	{
+		Array<FilePath> paths;
+		paths.reserve(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const FilePath path = FileSystem::FullPath(FileSystem::PathAppend(directory, U"circle{:0>6}.json"_fmt(i)));
+
+			if (not WriteUTF8(path, MakeCircleJSON((i + seed), valuesPerFile)))
+			{
+				return{};
+			}
+
+			paths << path;
+		}
+
+		return paths;
+	}
+
+	FilePath WriteCircleTable(const FilePathView directory, const size_t numRows)
+	{
+		std::string text = "dataType,benchCircleTable\nx,y,radius\n";
+		text.reserve(text.size() + numRows * 24);
+
+		for (size_t i = 0; i < numRows; ++i)
+		{
+			text += std::to_string(i % 1280);
+			text += ',';
+			text += std::to_string(i % 720);
+			text += ',';
+			text += std::to_string(10.0 + (i % 50) * 0.25);
+			text += '\n';
+		}
+
+		const FilePath path = FileSystem::FullPath(FileSystem::PathAppend(directory, U"circleTable.csv"));
+		return (WriteUTF8(path, text) ? path : FilePath{});
+	}
+
+	bool ResetDirectory(const FilePathView directory)
+	{
+		if (FileSystem::Exists(directory) && (not FileSystem::Remove(directory)))
+		{
+			return false;
+		}
+
+		return FileSystem::CreateDirectories(directory);
+	}
+}
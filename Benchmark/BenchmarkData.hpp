@@ -0,0 +1,37 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+
+/// @brief ベンチマークの入力を生成します。
+namespace BenchmarkData
+{
+	/// @brief JSONParser::Read* の計測に使う、各型の値を持つ JSON を作成します。
+	/// @param numValues 配列の値の要素数
+	/// @return `int32`, `double`, `Vec2`, `ColorF`, `String`, `bool`, `Vec2[]`（数値の配列）, `Vec2[]text`（数値の文字列）をキーに持つ JSON
+	[[nodiscard]]
+	JSON MakeTypedValues(size_t numValues);
+
+	/// @brief BenchCircle の config ファイルの内容を作成します。
+	/// @param index ファイルの番号です。値を変えるために使います。
+	/// @param valuesPerFile points の要素数
+	/// @return UTF-8 の JSON
+	[[nodiscard]]
+	std::string MakeCircleJSON(size_t index, size_t valuesPerFile);
+
+	/// @brief BenchCircle の config ファイルを書き出します。
+	/// @param directory 書き出すディレクトリ
+	/// @param count ファイルの数
+	/// @param valuesPerFile 1 つのファイルの points の要素数
+	/// @param seed 値を変えるための番号です。同じファイルを書き換える場合に変えます。
+	/// @return 書き出したファイルの絶対パス
+	Array<FilePath> WriteCircleFiles(FilePathView directory, size_t count, size_t valuesPerFile, size_t seed = 0);
+
+	/// @brief BenchCircleTable の CSV ファイルを書き出します。
+	/// @param directory 書き出すディレクトリ
+	/// @param numRows 行数
+	/// @return 書き出したファイルの絶対パス
+	FilePath WriteCircleTable(FilePathView directory, size_t numRows);
+
+	/// @brief ディレクトリを空にします。
+	/// @return 空のディレクトリを用意できた場合 true, それ以外の場合は false
+	bool ResetDirectory(FilePathView directory);
+}
@@ -0,0 +1,192 @@
+﻿# include "BenchmarkRunner.hpp"
+# include <thread>
+
+Optional<BenchmarkOptions> BenchmarkOptions::Parse(const Array<String>& args)
+{
+	BenchmarkOptions options;
+
+	// 先頭はプログラムのパスです。
+	for (size_t i = 1; i < args.size(); ++i)
+	{
+		const String& name = args[i];
+
+		if ((i + 1) == args.size())
+		{
+			Console << U"引数`{}`の値がありません。"_fmt(name);
+			return none;
+		}
+
+		const String& value = args[++i];
+
+		if (name == U"--work")
+		{
+			options.workDirectory = value;
+			continue;
+		}
+		else if (name == U"--out")
+		{
+			options.outputPath = value;
+			continue;
+		}
+		else if (name == U"--filter")
+		{
+			options.filter = value;
+			continue;
+		}
+
+		const Optional<size_t> number = ParseIntOpt<size_t>(value);
+
+		if (not number)
+		{
+			Console << U"引数`{}`の値`{}`は数値ではありません。"_fmt(name, value);
+			return none;
+		}
+
+		if (name == U"--files")
+		{
+			options.numFiles = *number;
+		}
+		else if (name == U"--values")
+		{
+			options.valuesPerFile = *number;
+		}
+		else if (name == U"--rows")
+		{
+			options.numTableRows = *number;
+		}
+		else if (name == U"--events")
+		{
+			options.numEvents = *number;
+		}
+		else if (name == U"--iterations")
+		{
+			options.iterations = Max<size_t>(*number, 1);
+		}
+		else
+		{
+			Console << U"引数`{}`は不明です。"_fmt(name);
+			return none;
+		}
+	}
+
+	return options;
+}
+
+BenchmarkResult& BenchmarkResult::setMetric(const StringView key, const double value)
+{
+	metrics.emplace_back(String{ key }, value);
+	return *this;
+}
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions& options)
+	: m_options{ options } {}
+
+const BenchmarkOptions& BenchmarkRunner::options() const noexcept
+{
+	return m_options;
+}
+
+bool BenchmarkRunner::isEnabled(const StringView name) const noexcept
+{
+	return name.starts_with(m_options.filter);
+}
+
+BenchmarkResult& BenchmarkRunner::addResult(const StringView name, Array<uint64> samplesNanosec, const size_t operationsPerIteration)
+{
+	BenchmarkResult result{ .name = String{ name }, .iterations = samplesNanosec.size(), .operationsPerIteration = operationsPerIteration };
+
+	if (samplesNanosec)
+	{
+		samplesNanosec.sort();
+
+		double sum = 0.0;
+
+		for (const auto sample : samplesNanosec)
+		{
+			sum += static_cast<double>(sample);
+		}
+
+		result.meanNanosec = (sum / samplesNanosec.size());
+		result.medianNanosec = static_cast<double>(samplesNanosec[samplesNanosec.size() / 2]);
+		result.minNanosec = static_cast<double>(samplesNanosec.front());
+		result.maxNanosec = static_cast<double>(samplesNanosec.back());
+		result.p95Nanosec = static_cast<double>(samplesNanosec[Min((samplesNanosec.size() * 95) / 100, (samplesNanosec.size() - 1))]);
+	}
+
+	Console << U"{:<48} median {:>14.1f} ns  ({:.1f} ns/op)"_fmt(result.name, result.medianNanosec, (result.medianNanosec / Max<size_t>(operationsPerIteration, 1)));
+
+	m_results << std::move(result);
+	return m_results.back();
+}
+
+size_t BenchmarkRunner::numResults() const noexcept
+{
+	return m_results.size();
+}
+
+BenchmarkResult& BenchmarkRunner::resultAt(const size_t index)
+{
+	return m_results[index];
+}
+
+void BenchmarkRunner::addFailure(const StringView name, const StringView message)
+{
+	Console << U"{}: 失敗 - {}"_fmt(name, message);
+
+	m_failures.emplace_back(String{ name }, String{ message });
+}
+
+bool BenchmarkRunner::hasFailures() const noexcept
+{
+	return (not m_failures.isEmpty());
+}
+
+JSON BenchmarkRunner::toJSON() const
+{
+	JSON json;
+	json[U"date"] = DateTime::Now().format(U"yyyy-MM-ddTHH:mm:ss");
+	json[U"hardwareConcurrency"] = static_cast<int64>(std::thread::hardware_concurrency());
+
+	json[U"options"][U"files"] = static_cast<int64>(m_options.numFiles);
+	json[U"options"][U"values"] = static_cast<int64>(m_options.valuesPerFile);
+	json[U"options"][U"rows"] = static_cast<int64>(m_options.numTableRows);
+	json[U"options"][U"events"] = static_cast<int64>(m_options.numEvents);
+	json[U"options"][U"iterations"] = static_cast<int64>(m_options.iterations);
+
+	for (const auto& result : m_results)
+	{
+		JSON item;
+		item[U"name"] = result.name;
+		item[U"iterations"] = static_cast<int64>(result.iterations);
+		item[U"operationsPerIteration"] = static_cast<int64>(result.operationsPerIteration);
+		item[U"meanNanosec"] = result.meanNanosec;
+		item[U"medianNanosec"] = result.medianNanosec;
+		item[U"minNanosec"] = result.minNanosec;
+		item[U"maxNanosec"] = result.maxNanosec;
+		item[U"p95Nanosec"] = result.p95Nanosec;
+		item[U"nanosecPerOperation"] = (result.medianNanosec / Max<size_t>(result.operationsPerIteration, 1));
+
+		for (const auto& [key, value] : result.metrics)
+		{
+			item[U"metrics"][key] = value;
+		}
+
+		json[U"results"].push_back(item);
+	}
+
+	for (const auto& [name, message] : m_failures)
+	{
+		JSON item;
+		item[U"name"] = name;
+		item[U"message"] = message;
+
+		json[U"failures"].push_back(item);
+	}
+
+	return json;
+}
+
+bool BenchmarkRunner::save() const
+{
+	return toJSON().save(m_options.outputPath);
+}
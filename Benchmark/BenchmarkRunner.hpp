@@ -0,0 +1,176 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+
+/// @brief ベンチマークの設定です。コマンドライン引数で変更できます。
+struct BenchmarkOptions
+{
+	/// @brief パースする config ファイルの数（--files）
+	size_t numFiles = 1000;
+
+	/// @brief 1 つの config ファイルに含める Vec2 の数（--values）。ファイルのサイズを決めます。
+	size_t valuesPerFile = 16;
+
+	/// @brief 表の行数（--rows）
+	size_t numTableRows = 100000;
+
+	/// @brief DirectoryMonitor に通知するファイルの変更の数（--events）
+	size_t numEvents = 10000;
+
+	/// @brief 各ベンチマークの計測回数（--iterations）
+	size_t iterations = 10;
+
+	/// @brief 入力ファイルを生成するディレクトリ（--work）
+	FilePath workDirectory = U"benchmark_work/";
+
+	/// @brief 結果を書き出す JSON ファイル（--out）
+	FilePath outputPath = U"benchmark_result.json";
+
+	/// @brief 実行するベンチマークの名前の接頭辞（--filter）。空の場合は全て実行します。
+	String filter;
+
+	/// @brief コマンドライン引数から設定を作成します。
+	/// @param args `--files 1000`の形式の引数
+	/// @return 設定。不正な引数がある場合は none
+	[[nodiscard]]
+	static Optional<BenchmarkOptions> Parse(const Array<String>& args);
+};
+
+/// @brief 1 つのベンチマークの結果です。
+struct BenchmarkResult
+{
+	/// @brief ベンチマークの名前
+	String name;
+
+	/// @brief 計測回数
+	size_t iterations = 0;
+
+	/// @brief 1 回の計測で行った操作の数
+	size_t operationsPerIteration = 1;
+
+	/// @brief 1 回の計測にかかった時間の統計（ナノ秒）
+	double meanNanosec = 0.0;
+
+	double medianNanosec = 0.0;
+
+	double minNanosec = 0.0;
+
+	double maxNanosec = 0.0;
+
+	double p95Nanosec = 0.0;
+
+	/// @brief 時間以外の計測値（確保の回数など）
+	Array<std::pair<String, double>> metrics;
+
+	/// @brief 時間以外の計測値を追加します。
+	BenchmarkResult& setMetric(StringView key, double value);
+};
+
+/// @brief ベンチマークを実行し、結果を JSON に書き出します。
+class BenchmarkRunner
+{
+public:
+	explicit BenchmarkRunner(const BenchmarkOptions& options);
+
+	/// @brief ベンチマークの設定を返します。
+	[[nodiscard]]
+	const BenchmarkOptions& options() const noexcept;
+
+	/// @brief ベンチマークを実行するかを返します。
+	/// @param name ベンチマークの名前
+	/// @return filter に一致する場合 true
+	[[nodiscard]]
+	bool isEnabled(StringView name) const noexcept;
+
+	/// @brief 関数を計測回数だけ実行し、1 回ごとの時間を記録します。
+	/// @param name ベンチマークの名前
+	/// @param operationsPerIteration 関数 1 回で行う操作の数です。1 操作あたりの時間の計算に使います。
+	/// @param function 計測する関数
+	/// @return 記録した結果。filter に一致しない場合は nullptr
+	template <class Function>
+	BenchmarkResult* run(StringView name, size_t operationsPerIteration, Function&& function)
+	{
+		if (not isEnabled(name))
+		{
+			return nullptr;
+		}
+
+		// 最初の 1 回はキャッシュを温めるため記録しません。
+		function();
+
+		Array<uint64> samples;
+
+		for (size_t i = 0; i < m_options.iterations; ++i)
+		{
+			samples << Measure(function);
+		}
+
+		return &addResult(name, samples, operationsPerIteration);
+	}
+
+	/// @brief 計測した時間から結果を記録します。
+	/// @param name ベンチマークの名前
+	/// @param samplesNanosec 1 回ごとの時間（ナノ秒）
+	/// @param operationsPerIteration 1 回で行った操作の数
+	/// @return 記録した結果
+	BenchmarkResult& addResult(StringView name, Array<uint64> samplesNanosec, size_t operationsPerIteration = 1);
+
+	/// @brief 記録した結果の数を返します。
+	[[nodiscard]]
+	size_t numResults() const noexcept;
+
+	/// @brief 記録した結果を返します。
+	/// @param index 0 以上 numResults() 未満のインデックス
+	/// @return 結果。後から計測値を加えられます。
+	[[nodiscard]]
+	BenchmarkResult& resultAt(size_t index);
+
+	/// @brief ベンチマークが期待した結果にならなかったことを記録します。
+	/// @param name ベンチマークの名前
+	/// @param message 失敗の内容
+	void addFailure(StringView name, StringView message);
+
+	/// @brief 失敗したベンチマークがあるかを返します。
+	/// @return addFailure() が呼ばれた場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool hasFailures() const noexcept;
+
+	/// @brief 関数の実行にかかった時間を返します。
+	/// @return 時間（ナノ秒）
+	template <class Function>
+	[[nodiscard]]
+	static uint64 Measure(Function&& function)
+	{
+		const uint64 start = Time::GetNanosec();
+		function();
+		return (Time::GetNanosec() - start);
+	}
+
+	/// @brief 全ての結果を JSON に変換します。
+	[[nodiscard]]
+	JSON toJSON() const;
+
+	/// @brief 全ての結果を options().outputPath に書き出します。
+	/// @return 書き出せた場合 true, それ以外の場合は false
+	bool save() const;
+
+private:
+
+	BenchmarkOptions m_options;
+
+	Array<BenchmarkResult> m_results;
+
+	/// @brief 失敗したベンチマークの名前と内容
+	Array<std::pair<String, String>> m_failures;
+};
+
+/// @brief 計測する処理の結果が最適化で取り除かれないようにします。
+template <class Type>
+inline void DoNotOptimize(const Type& value)
+{
+# if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+# else
+	static volatile const void* s_sink;
+	s_sink = &value;
+# endif
+}
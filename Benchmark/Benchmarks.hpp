@@ -0,0 +1,17 @@
+﻿# pragma once
+# include "BenchmarkRunner.hpp"
+
+/// @brief JSONParser::Read* と、ストリームからの Decode を型ごとに計測します。
+void RunJSONParserBenchmarks(BenchmarkRunner& runner);
+
+/// @brief ConfigParser の parseJSON, parseJSONBatch, parseTable を、ファイルの読み込みから config の作成まで計測します。
+void RunConfigParserBenchmarks(BenchmarkRunner& runner);
+
+/// @brief 大量のファイルの変更を通知したときの DirectoryMonitor::update と retrieveChangedFiles を計測します。
+void RunDirectoryMonitorBenchmarks(BenchmarkRunner& runner);
+
+/// @brief GetConfig, ConfigHandle, スナップショットによる config の参照と、publish() のコストを計測します。
+void RunConfigStoreBenchmarks(BenchmarkRunner& runner);
+
+/// @brief 多数のスレッドから通知を追加し、取りこぼしが無いことと、1 フレームで取り出す時間を計測します。
+void RunNotificationBenchmarks(BenchmarkRunner& runner);
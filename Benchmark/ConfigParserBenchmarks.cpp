@@ -0,0 +1,150 @@
+﻿# include "Benchmarks.hpp"
+# include "AllocationCounter.hpp"
+# include "BenchmarkConfigs.hpp"
+# include "BenchmarkData.hpp"
+# include "ConfigParser.hpp"
+
+namespace
+{
+	/// @brief DOM を作る JSON パーサーを登録した ConfigParser を作成します。
+	[[nodiscard]]
+	static std::unique_ptr<ConfigParser> MakeDOMParser()
+	{
+		auto parser = std::make_unique<ConfigParser>();
+		parser->addJSONParser<BenchCircle>();
+		parser->addTableParser<BenchCircleTable>();
+		return parser;
+	}
+
+	/// @brief ストリームパーサーを登録した ConfigParser を作成します。
+	[[nodiscard]]
+	static std::unique_ptr<ConfigParser> MakeStreamParser()
+	{
+		auto parser = std::make_unique<ConfigParser>();
+		parser->addJSONStreamParser<BenchCircle>();
+		return parser;
+	}
+
+	/// @brief 計測ごとに新しい ConfigParser でパースし、時間とヒープの確保の回数を記録します。
+	/// @remark ConfigParser は内容の変わっていないファイルのパースをスキップするため、計測ごとに作り直します。
+	/// @param parse ConfigParser を受け取ってパースし、成功した config の数を返す関数
+	template <class MakeParser, class Parse>
+	static void RunWithFreshParser(BenchmarkRunner& runner, const StringView name, const size_t numOperations, const MakeParser& makeParser, const Parse& parse)
+	{
+		if (not runner.isEnabled(name))
+		{
+			return;
+		}
+
+		const size_t iterations = runner.options().iterations;
+
+		Array<uint64> samples;
+		uint64 numAllocations = 0;
+		uint64 peakRSSBytes = 0;
+		size_t numParsed = 0;
+
+		// 最初の 1 回はキャッシュを温めるため記録しません。
+		for (size_t i = 0; i <= iterations; ++i)
+		{
+			const std::unique_ptr<ConfigParser> parser = makeParser();
+
+			// パース中に溜まった通知を捨てます。
+			System::Update();
+
+			const AllocationCounter::Scope scope;
+			const uint64 time = BenchmarkRunner::Measure([&] { numParsed = parse(*parser); });
+
+			if (i != 0)
+			{
+				samples << time;
+				numAllocations += scope.allocations();
+				peakRSSBytes = Max(peakRSSBytes, AllocationCounter::PeakRSSBytes());
+			}
+		}
+
+		runner.addResult(name, samples, numOperations)
+			.setMetric(U"parsed", static_cast<double>(numParsed))
+			.setMetric(U"allocationsPerIteration", (static_cast<double>(numAllocations) / iterations))
+			.setMetric(U"peakRSSBytes", static_cast<double>(peakRSSBytes));
+	}
+
+	/// @brief ファイルを 1 つずつパースします。
+	[[nodiscard]]
+	static size_t ParseSequentially(ConfigParser& parser, const Array<FilePath>& paths)
+	{
+		size_t numParsed = 0;
+
+		for (const auto& path : paths)
+		{
+			numParsed += static_cast<bool>(parser.parseJSON(path, path));
+		}
+
+		return numParsed;
+	}
+
+	/// @brief ファイルをスレッドプールで並列にパースします。
+	[[nodiscard]]
+	static size_t ParseInBatch(ConfigParser& parser, const Array<FilePath>& paths, ThreadPool& threadPool)
+	{
+		size_t numParsed = 0;
+
+		for (const auto& pConfig : parser.parseJSONBatch(paths, threadPool))
+		{
+			numParsed += static_cast<bool>(pConfig);
+		}
+
+		return numParsed;
+	}
+}
+
+void RunConfigParserBenchmarks(BenchmarkRunner& runner)
+{
+	const BenchmarkOptions& options = runner.options();
+	const FilePath directory = FileSystem::PathAppend(options.workDirectory, U"parser/");
+
+	if (not BenchmarkData::ResetDirectory(directory))
+	{
+		Console << U"ディレクトリ`{}`を用意できませんでした。"_fmt(directory);
+		return;
+	}
+
+	const Array<FilePath> paths = BenchmarkData::WriteCircleFiles(directory, options.numFiles, options.valuesPerFile);
+	const FilePath tablePath = BenchmarkData::WriteCircleTable(directory, options.numTableRows);
+
+	if ((paths.size() != options.numFiles) || tablePath.isEmpty())
+	{
+		Console << U"入力ファイルを書き出せませんでした。";
+		return;
+	}
+
+	RunWithFreshParser(runner, U"ConfigParser/parseJSON/dom", paths.size(), MakeDOMParser,
+		[&](ConfigParser& parser) { return ParseSequentially(parser, paths); });
+
+	RunWithFreshParser(runner, U"ConfigParser/parseJSON/stream", paths.size(), MakeStreamParser,
+		[&](ConfigParser& parser) { return ParseSequentially(parser, paths); });
+
+	// ReloadScheduler の lazy モードで、起動時にパースの代わりに行うデータタイプの読み取りです。
+	RunWithFreshParser(runner, U"ConfigParser/peekDataType", paths.size(), MakeDOMParser,
+		[&](ConfigParser& parser) { return static_cast<size_t>(paths.count_if([&](const FilePath& path) { return parser.peekDataType(path).has_value(); })); });
+
+	// parseJSONBatch は呼び出したスレッドも処理に加わるため、ワーカースレッドは 1 つ少なく作ります。
+	{
+		ThreadPool threadPool{ 3 };
+
+		RunWithFreshParser(runner, U"ConfigParser/parseJSONBatch/4threads", paths.size(), MakeDOMParser,
+			[&](ConfigParser& parser) { return ParseInBatch(parser, paths, threadPool); });
+	}
+
+	{
+		ThreadPool threadPool;
+
+		RunWithFreshParser(runner, U"ConfigParser/parseJSONBatch/{}threads"_fmt(threadPool.numThreads() + 1), paths.size(), MakeDOMParser,
+			[&](ConfigParser& parser) { return ParseInBatch(parser, paths, threadPool); });
+
+		RunWithFreshParser(runner, U"ConfigParser/parseTable/parallel", options.numTableRows, MakeDOMParser,
+			[&](ConfigParser& parser) { return static_cast<size_t>(static_cast<bool>(parser.parseTable(tablePath, tablePath, &threadPool))); });
+	}
+
+	RunWithFreshParser(runner, U"ConfigParser/parseTable/single", options.numTableRows, MakeDOMParser,
+		[&](ConfigParser& parser) { return static_cast<size_t>(static_cast<bool>(parser.parseTable(tablePath, tablePath))); });
+}
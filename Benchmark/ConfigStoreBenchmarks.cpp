@@ -0,0 +1,195 @@
+﻿# include "Benchmarks.hpp"
+# include "AllocationCounter.hpp"
+# include "BenchmarkConfigs.hpp"
+# include "ConfigStore.hpp"
+
+namespace
+{
+	/// @brief 1 回の計測で config を参照する回数
+	constexpr size_t NumLookupsPerIteration = 100000;
+
+	/// @brief config を作成します。
+	[[nodiscard]]
+	static std::unique_ptr<BenchCircle> MakeCircle(const size_t index, const size_t numPoints)
+	{
+		const double value = static_cast<double>(index);
+
+		auto pConfig = std::make_unique<BenchCircle>();
+		pConfig->center = Vec2{ Math::Fmod(value, 1280.0), Math::Fmod(value, 720.0) };
+		pConfig->radius = (10.0 + Math::Fmod(value, 50.0));
+		pConfig->name = U"circle{}"_fmt(index);
+		pConfig->points.resize(numPoints, Vec2{ value, value });
+		return pConfig;
+	}
+
+	/// @brief config を置き換え、publish() にかかる時間とヒープの確保の回数を記録します。
+	/// @param publish publish() またはその比較対象を呼ぶ関数
+	/// @param numReplaced 1 回の計測で置き換える config の数です。計測ごとに半分ずつ重なるようにずらします。
+	/// @return 記録した結果。filter に一致しない場合は nullptr
+	template <class Publish>
+	static BenchmarkResult* RunPublish(BenchmarkRunner& runner, const StringView name, ConfigStore& configs, const Array<String>& keys, const Publish& publish, size_t numReplaced = 0)
+	{
+		if (not runner.isEnabled(name))
+		{
+			return nullptr;
+		}
+
+		const size_t iterations = runner.options().iterations;
+
+		Array<uint64> samples;
+		uint64 numAllocations = 0;
+		uint64 peakRSSBytes = 0;
+		size_t maxArenas = 0;
+
+		if ((numReplaced == 0) || (keys.size() < numReplaced))
+		{
+			numReplaced = keys.size();
+		}
+
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			for (size_t n = 0; n < numReplaced; ++n)
+			{
+				const size_t k = (((i * Max<size_t>((numReplaced / 2), 1)) + n) % keys.size());
+				configs.insertOrAssign(keys[k], MakeCircle((k + i), runner.options().valuesPerFile));
+			}
+
+			const AllocationCounter::Scope scope;
+			samples << BenchmarkRunner::Measure(publish);
+			numAllocations += scope.allocations();
+			peakRSSBytes = Max(peakRSSBytes, AllocationCounter::PeakRSSBytes());
+			maxArenas = Max(maxArenas, configs.numArenas());
+		}
+
+		return &runner.addResult(name, samples, numReplaced)
+			.setMetric(U"allocationsPerIteration", (static_cast<double>(numAllocations) / iterations))
+			.setMetric(U"peakRSSBytes", static_cast<double>(peakRSSBytes))
+			.setMetric(U"maxArenas", static_cast<double>(maxArenas));
+	}
+
+	/// @brief 結果の計測値を返します。
+	/// @return 計測値。無い場合は none
+	[[nodiscard]]
+	static Optional<double> FindMetric(const BenchmarkResult& result, const StringView key)
+	{
+		for (const auto& [metricKey, value] : result.metrics)
+		{
+			if (metricKey == key)
+			{
+				return value;
+			}
+		}
+
+		return none;
+	}
+}
+
+void RunConfigStoreBenchmarks(BenchmarkRunner& runner)
+{
+	const size_t numConfigs = Max<size_t>(runner.options().numFiles, 1);
+
+	ConfigStore configs;
+	configs.addType<BenchCircle>();
+
+	Array<String> keys;
+
+	for (size_t i = 0; i < numConfigs; ++i)
+	{
+		keys << U"config/circle{:0>6}.json"_fmt(i);
+		configs.insertOrAssign(keys.back(), MakeCircle(i, runner.options().valuesPerFile));
+	}
+
+	configs.publish();
+
+	const ConfigHandle<BenchCircle> keyHandle = configs.handle<BenchCircle>(keys.front());
+	const ConfigHandle<BenchCircle> anyHandle = configs.handle<BenchCircle>();
+	const std::shared_ptr<const ConfigSnapshot> snapshot = configs.snapshot();
+
+	runner.run(U"ConfigStore/GetConfig", NumLookupsPerIteration, [&]
+		{
+			for (size_t i = 0; i < NumLookupsPerIteration; ++i)
+			{
+				DoNotOptimize(GetConfig<BenchCircle>(configs));
+			}
+		});
+
+	runner.run(U"ConfigStore/ConfigHandle/key", NumLookupsPerIteration, [&]
+		{
+			for (size_t i = 0; i < NumLookupsPerIteration; ++i)
+			{
+				DoNotOptimize(keyHandle.get());
+			}
+		});
+
+	runner.run(U"ConfigStore/ConfigHandle/any", NumLookupsPerIteration, [&]
+		{
+			for (size_t i = 0; i < NumLookupsPerIteration; ++i)
+			{
+				DoNotOptimize(anyHandle.get());
+			}
+		});
+
+	runner.run(U"ConfigStore/find+get", NumLookupsPerIteration, [&]
+		{
+			for (size_t i = 0; i < NumLookupsPerIteration; ++i)
+			{
+				DoNotOptimize(configs.get<BenchCircle>(configs.find<BenchCircle>(keys[i % numConfigs])));
+			}
+		});
+
+	runner.run(U"ConfigSnapshot/acquire", NumLookupsPerIteration, [&]
+		{
+			for (size_t i = 0; i < NumLookupsPerIteration; ++i)
+			{
+				DoNotOptimize(configs.snapshot());
+			}
+		});
+
+	runner.run(U"ConfigSnapshot/find", NumLookupsPerIteration, [&]
+		{
+			for (size_t i = 0; i < NumLookupsPerIteration; ++i)
+			{
+				DoNotOptimize(snapshot->find<BenchCircle>(keys[i % numConfigs]));
+			}
+		});
+
+	// ConfigStore/publish の結果は、比較対象を計測した後で比を加えるため、インデックスで保持します。
+	const size_t publishResultIndex = runner.numResults();
+	const bool hasPublishResult = (RunPublish(runner, U"ConfigStore/publish", configs, keys, [&] { DoNotOptimize(configs.publish()); }) != nullptr);
+
+	// 一部の config だけを、前回と半分ずつ重なるようにずらしながら置き換えます。古い写しを含む領域が残り続けないことを maxArenas で確認します。
+	RunPublish(runner, U"ConfigStore/publish/partial", configs, keys, [&] { DoNotOptimize(configs.publish()); }, Max<size_t>((numConfigs / 4), 1));
+
+	// 比較のため、config ごとに make_shared でコピーした場合を計測します。
+	const BenchmarkResult* baseline = RunPublish(runner, U"ConfigStore/publish/baseline-make_shared", configs, keys, [&]
+		{
+			Array<std::shared_ptr<const IConfig>> copies;
+			copies.reserve(keys.size());
+
+			configs.forEach<BenchCircle>([&](const BenchCircle& circle)
+				{
+					copies << std::make_shared<const BenchCircle>(circle);
+				});
+
+			DoNotOptimize(copies);
+		});
+
+	// 領域によって省けた確保とメモリの量を、比較対象に対する比で記録します。
+	if (hasPublishResult && baseline)
+	{
+		BenchmarkResult& publishResult = runner.resultAt(publishResultIndex);
+
+		const std::array<StringView, 2> metricKeys{ U"allocationsPerIteration", U"peakRSSBytes" };
+
+		for (const StringView key : metricKeys)
+		{
+			const Optional<double> value = FindMetric(publishResult, key);
+			const Optional<double> baselineValue = FindMetric(*baseline, key);
+
+			if (value && baselineValue && (*baselineValue != 0.0))
+			{
+				publishResult.setMetric(U"{}VsBaseline"_fmt(key), (*value / *baselineValue));
+			}
+		}
+	}
+}
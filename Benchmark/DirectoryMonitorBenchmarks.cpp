@@ -0,0 +1,166 @@
+﻿# include "Benchmarks.hpp"
+# include "BenchmarkData.hpp"
+# include "DirectoryMonitor.hpp"
+
+namespace
+{
+	/// @brief 変更されたファイルを全て受け取るまで update() を呼び続けた結果です。
+	struct DrainResult
+	{
+		/// @brief update() と retrieveChangedFiles() 1 回ごとの時間（ナノ秒）
+		Array<uint64> samples;
+
+		/// @brief 受け取ったファイルの数
+		size_t numRetrieved = 0;
+
+		/// @brief 全て受け取るまでの時間（ミリ秒）
+		uint64 totalMillisec = 0;
+	};
+
+	/// @brief 変更されたファイルを expected 個受け取るまで、1 ミリ秒ごとに update() を呼びます。
+	/// @param timeoutMillisec 受け取りきれなくてもこの時間で打ち切ります。
+	[[nodiscard]]
+	static DrainResult Drain(DirectoryMonitor& monitor, const size_t expected, const uint64 timeoutMillisec)
+	{
+		DrainResult result;
+		const uint64 startMillisec = Time::GetMillisec();
+
+		while ((result.numRetrieved < expected) && ((Time::GetMillisec() - startMillisec) < timeoutMillisec))
+		{
+			result.samples << BenchmarkRunner::Measure([&]
+				{
+					monitor.update();
+					result.numRetrieved += monitor.retrieveChangedFiles().size();
+				});
+
+			System::Sleep(1);
+		}
+
+		result.totalMillisec = (Time::GetMillisec() - startMillisec);
+		return result;
+	}
+
+	/// @brief 変更を通知した後、1 ミリ秒ごとに update() を numFrames 回呼びます。待ち時間の間に何も読み込むものが無いフレームの時間を計測します。
+	[[nodiscard]]
+	static DrainResult Idle(DirectoryMonitor& monitor, const size_t numFrames)
+	{
+		DrainResult result;
+		const uint64 startMillisec = Time::GetMillisec();
+
+		for (size_t i = 0; i < numFrames; ++i)
+		{
+			result.samples << BenchmarkRunner::Measure([&]
+				{
+					monitor.update();
+					result.numRetrieved += monitor.retrieveChangedFiles().size();
+				});
+
+			System::Sleep(1);
+		}
+
+		result.totalMillisec = (Time::GetMillisec() - startMillisec);
+		return result;
+	}
+
+	/// @brief 結果を記録します。
+	static void AddResult(BenchmarkRunner& runner, const StringView name, DrainResult&& result, const size_t expected)
+	{
+		runner.addResult(name, std::move(result.samples))
+			.setMetric(U"expected", static_cast<double>(expected))
+			.setMetric(U"retrieved", static_cast<double>(result.numRetrieved))
+			.setMetric(U"totalMillisec", static_cast<double>(result.totalMillisec));
+	}
+
+	constexpr uint64 TimeoutMillisec = 60000;
+
+	/// @brief 待ち時間の間のフレームを計測するための、計測中に経過しない長さの待ち時間（ミリ秒）
+	constexpr int32 LongCooldownMillisec = 60000;
+
+	/// @brief 待ち時間の間に計測するフレームの数
+	constexpr size_t NumIdleFrames = 1000;
+}
+
+void RunDirectoryMonitorBenchmarks(BenchmarkRunner& runner)
+{
+	if ((not runner.isEnabled(U"DirectoryMonitor/crawl")) && (not runner.isEnabled(U"DirectoryMonitor/storm")) && (not runner.isEnabled(U"DirectoryMonitor/cooldown")))
+	{
+		return;
+	}
+
+	const BenchmarkOptions& options = runner.options();
+	const FilePath directory = FileSystem::PathAppend(options.workDirectory, U"monitor/");
+
+	if (not BenchmarkData::ResetDirectory(directory))
+	{
+		Console << U"ディレクトリ`{}`を用意できませんでした。"_fmt(directory);
+		return;
+	}
+
+	// 内容は問わないため、最小のファイルを書き出します。
+	if (BenchmarkData::WriteCircleFiles(directory, options.numEvents, 0).size() != options.numEvents)
+	{
+		Console << U"入力ファイルを書き出せませんでした。";
+		return;
+	}
+
+	// 通知されたファイルをすぐに受け取れるよう、待ち時間を 0 にします。
+	DirectoryMonitor monitor;
+
+	if (not monitor.init(directory, { U"json" }, 0))
+	{
+		Console << U"ディレクトリ`{}`を監視できませんでした。"_fmt(directory);
+		return;
+	}
+
+	// 起動時の既存のファイルの探索
+	{
+		DrainResult result = Drain(monitor, options.numEvents, TimeoutMillisec);
+
+		if (runner.isEnabled(U"DirectoryMonitor/crawl"))
+		{
+			AddResult(runner, U"DirectoryMonitor/crawl", std::move(result), options.numEvents);
+		}
+	}
+
+	// 全てのファイルを書き換え、変更の通知をまとめて発生させます。
+	if (runner.isEnabled(U"DirectoryMonitor/storm"))
+	{
+		BenchmarkData::WriteCircleFiles(directory, options.numEvents, 0, 1);
+		AddResult(runner, U"DirectoryMonitor/storm", Drain(monitor, options.numEvents, TimeoutMillisec), options.numEvents);
+	}
+
+	// 全てのファイルを書き換えた後、長い待ち時間が経過するまでの毎フレームの update() を計測します。
+	// 待ち時間の間は読み込み可能なファイルが無いため、待っているファイルの数によらず短い時間で終わり、何も返さないはずです。
+	if (runner.isEnabled(U"DirectoryMonitor/cooldown"))
+	{
+		DirectoryMonitor cooldownMonitor;
+
+		if (not cooldownMonitor.init(directory, { U"json" }, LongCooldownMillisec))
+		{
+			Console << U"ディレクトリ`{}`を監視できませんでした。"_fmt(directory);
+			return;
+		}
+
+		// 起動時の探索で見つかったファイルは待ち時間によらずすぐに返されるため、先に受け取っておきます。
+		const DrainResult crawlResult = Drain(cooldownMonitor, options.numEvents, TimeoutMillisec);
+
+		if (crawlResult.numRetrieved != options.numEvents)
+		{
+			runner.addFailure(U"DirectoryMonitor/cooldown", U"起動時の探索で {} 個のうち {} 個しか受け取れませんでした。"_fmt(options.numEvents, crawlResult.numRetrieved));
+			return;
+		}
+
+		BenchmarkData::WriteCircleFiles(directory, options.numEvents, 0, 2);
+
+		DrainResult result = Idle(cooldownMonitor, NumIdleFrames);
+		const size_t numRetrieved = result.numRetrieved;
+		const uint64 totalMillisec = result.totalMillisec;
+
+		AddResult(runner, U"DirectoryMonitor/cooldown", std::move(result), 0);
+
+		if ((numRetrieved != 0) && (totalMillisec < static_cast<uint64>(LongCooldownMillisec)))
+		{
+			runner.addFailure(U"DirectoryMonitor/cooldown", U"待ち時間の間に {} 個のファイルが返されました。"_fmt(numRetrieved));
+		}
+	}
+}
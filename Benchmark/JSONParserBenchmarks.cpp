@@ -0,0 +1,58 @@
+﻿# include "Benchmarks.hpp"
+# include "BenchmarkData.hpp"
+# include "JSONParser.hpp"
+
+namespace
+{
+	/// @brief 1 回の計測で繰り返す回数
+	constexpr size_t NumReadsPerIteration = 10000;
+
+	/// @brief JSONParser::Read* を繰り返し呼び、結果を捨てます。
+	template <class Read>
+	static void RunRead(BenchmarkRunner& runner, const StringView name, const Read& read)
+	{
+		runner.run(name, NumReadsPerIteration, [&]
+			{
+				for (size_t i = 0; i < NumReadsPerIteration; ++i)
+				{
+					DoNotOptimize(read());
+				}
+			});
+	}
+
+	/// @brief ストリームから値を 1 つデコードします。
+	template <class Type>
+	static void RunStreamDecode(BenchmarkRunner& runner, const StringView name, const std::string& text)
+	{
+		runner.run(name, NumReadsPerIteration, [&]
+			{
+				for (size_t i = 0; i < NumReadsPerIteration; ++i)
+				{
+					JSONStreamReader reader{ text.data(), text.size() };
+					reader.next();
+					DoNotOptimize(JSONParser::Decode<Type>(reader));
+				}
+			});
+	}
+}
+
+void RunJSONParserBenchmarks(BenchmarkRunner& runner)
+{
+	const JSON json = BenchmarkData::MakeTypedValues(runner.options().valuesPerFile);
+
+	RunRead(runner, U"JSONParser/ReadInt32", [&] { return JSONParser::ReadInt32(json, U"int32"); });
+	RunRead(runner, U"JSONParser/ReadDouble", [&] { return JSONParser::ReadDouble(json, U"double"); });
+	RunRead(runner, U"JSONParser/ReadVec2", [&] { return JSONParser::ReadVec2(json, U"Vec2"); });
+	RunRead(runner, U"JSONParser/ReadColorF", [&] { return JSONParser::ReadColorF(json, U"ColorF"); });
+	RunRead(runner, U"JSONParser/ReadString", [&] { return JSONParser::ReadString(json, U"String"); });
+	RunRead(runner, U"JSONParser/ReadBool", [&] { return JSONParser::ReadBool(json, U"bool"); });
+	RunRead(runner, U"JSONParser/ReadArray<Vec2>/array", [&] { return JSONParser::ReadArray<Vec2>(json, U"Vec2[]"); });
+	RunRead(runner, U"JSONParser/ReadArray<Vec2>/text", [&] { return JSONParser::ReadArray<Vec2>(json, U"Vec2[]text"); });
+
+	RunStreamDecode<int32>(runner, U"JSONParser/Decode<int32>/stream", Unicode::ToUTF8(json[U"int32"].formatMinimum()));
+	RunStreamDecode<Vec2>(runner, U"JSONParser/Decode<Vec2>/stream", Unicode::ToUTF8(json[U"Vec2"].formatMinimum()));
+	RunStreamDecode<ColorF>(runner, U"JSONParser/Decode<ColorF>/stream", Unicode::ToUTF8(json[U"ColorF"].formatMinimum()));
+	RunStreamDecode<String>(runner, U"JSONParser/Decode<String>/stream", Unicode::ToUTF8(json[U"String"].formatMinimum()));
+	RunStreamDecode<Array<Vec2>>(runner, U"JSONParser/Decode<Array<Vec2>>/stream/array", Unicode::ToUTF8(json[U"Vec2[]"].formatMinimum()));
+	RunStreamDecode<Array<Vec2>>(runner, U"JSONParser/Decode<Array<Vec2>>/stream/text", Unicode::ToUTF8(json[U"Vec2[]text"].formatMinimum()));
+}
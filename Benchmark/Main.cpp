@@ -0,0 +1,43 @@
+﻿# include <Siv3D.hpp>
+# include "Benchmarks.hpp"
+# include "NotificationAddon.hpp"
+
+// ウィンドウを開かずに実行します。
+SIV3D_SET(EngineOption::Renderer::Headless)
+
+void Main()
+{
+	const Optional<BenchmarkOptions> options = BenchmarkOptions::Parse(System::GetCommandLineArgs());
+
+	if (not options)
+	{
+		Console << U"使い方: EditorBenchmark [--files N] [--values N] [--rows N] [--events N] [--iterations N] [--work DIR] [--out FILE] [--filter PREFIX]";
+		return;
+	}
+
+	// パース中の通知は System::Update() で捨てます。
+	Addon::Register<NotificationAddon>(U"NotificationAddon");
+	NotificationAddon::SetLifeTime(0.0);
+
+	BenchmarkRunner runner{ *options };
+
+	RunJSONParserBenchmarks(runner);
+	RunConfigParserBenchmarks(runner);
+	RunConfigStoreBenchmarks(runner);
+	RunDirectoryMonitorBenchmarks(runner);
+	RunNotificationBenchmarks(runner);
+
+	if (not runner.save())
+	{
+		Console << U"結果を`{}`に書き出せませんでした。"_fmt(options->outputPath);
+		std::exit(EXIT_FAILURE);
+	}
+
+	Console << U"結果を`{}`に書き出しました。"_fmt(options->outputPath);
+
+	// CI で検出できるよう、失敗したベンチマークがある場合は 0 以外の終了コードで終了します。
+	if (runner.hasFailures())
+	{
+		std::exit(EXIT_FAILURE);
+	}
+}
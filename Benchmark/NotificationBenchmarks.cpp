@@ -0,0 +1,188 @@
+﻿# include "Benchmarks.hpp"
+# include "MPSCQueue.hpp"
+# include "NotificationAddon.hpp"
+
+namespace
+{
+	/// @brief 追加したスレッドの番号と、スレッドごとの通し番号を 1 つにまとめた要素です。
+	[[nodiscard]]
+	constexpr uint64 MakeItem(const size_t producer, const size_t sequence) noexcept
+	{
+		return ((static_cast<uint64>(producer) << 32) | static_cast<uint64>(sequence));
+	}
+
+	/// @brief 取り出した要素を確認した結果です。
+	struct StressResult
+	{
+		/// @brief 1 フレーム分の取り出しにかかった時間（ナノ秒）。要素を取り出せなかったフレームは含みません。
+		Array<uint64> drainSamples;
+
+		/// @brief 取り出した要素の数
+		size_t numConsumed = 0;
+
+		/// @brief 同じスレッドから追加した要素の順序が入れ替わっていた数
+		size_t numOrderViolations = 0;
+
+		/// @brief 全て取り出すまでの時間（ミリ秒）
+		uint64 totalMillisec = 0;
+	};
+
+	/// @brief 複数のスレッドから MPSCQueue に追加しながら、メインスレッドで NotificationAddon と同じ数ずつ取り出します。
+	[[nodiscard]]
+	static StressResult RunStress(const size_t numProducers, const size_t numItemsPerProducer, const uint64 timeoutMillisec)
+	{
+		MPSCQueue<uint64> queue;
+		std::atomic<bool> start = false;
+
+		Array<std::thread> producers;
+
+		for (size_t producer = 0; producer < numProducers; ++producer)
+		{
+			producers.emplace_back([&, producer]
+				{
+					while (not start.load(std::memory_order_acquire))
+					{
+						std::this_thread::yield();
+					}
+
+					for (size_t i = 0; i < numItemsPerProducer; ++i)
+					{
+						queue.push(MakeItem(producer, i));
+					}
+				});
+		}
+
+		StressResult result;
+		Array<int64> lastSequences(numProducers, -1);
+		const size_t expected = (numProducers * numItemsPerProducer);
+		const uint64 startMillisec = Time::GetMillisec();
+
+		start.store(true, std::memory_order_release);
+
+		while ((result.numConsumed < expected) && ((Time::GetMillisec() - startMillisec) < timeoutMillisec))
+		{
+			size_t numDrained = 0;
+
+			const uint64 sample = BenchmarkRunner::Measure([&]
+				{
+					uint64 item = 0;
+
+					for (; ((numDrained < NotificationAddon::MaxDrainPerFrame) && queue.tryPop(item)); ++numDrained)
+					{
+						const size_t producer = static_cast<size_t>(item >> 32);
+						const int64 sequence = static_cast<int64>(item & 0xFFFF'FFFF);
+
+						if (sequence <= lastSequences[producer])
+						{
+							++result.numOrderViolations;
+						}
+
+						lastSequences[producer] = sequence;
+					}
+				});
+
+			if (numDrained == 0)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			result.numConsumed += numDrained;
+			result.drainSamples << sample;
+		}
+
+		result.totalMillisec = (Time::GetMillisec() - startMillisec);
+
+		for (auto& producer : producers)
+		{
+			producer.join();
+		}
+
+		// 打ち切った場合も、残りの要素を数えます。
+		for (uint64 item = 0; queue.tryPop(item);)
+		{
+			++result.numConsumed;
+		}
+
+		return result;
+	}
+
+	constexpr uint64 TimeoutMillisec = 60000;
+
+	/// @brief 1 フレーム分の取り出しにかけてよい時間（ナノ秒）。60 FPS の 1 フレームの 1/8 です。
+	constexpr uint64 MaxDrainNanosec = 2'000'000;
+}
+
+void RunNotificationBenchmarks(BenchmarkRunner& runner)
+{
+	const BenchmarkOptions& options = runner.options();
+
+	// 生産者が消費者より多い状況を作るため、論理コア数より多くのスレッドから追加します。
+	const size_t numProducers = Max<size_t>((std::thread::hardware_concurrency() * 2), 8);
+
+	if (runner.isEnabled(U"Notification/mpscStress"))
+	{
+		StressResult result = RunStress(numProducers, options.numEvents, TimeoutMillisec);
+		const size_t expected = (numProducers * options.numEvents);
+
+		// 重複して受け取った場合は負になります。
+		const int64 lost = (static_cast<int64>(expected) - static_cast<int64>(result.numConsumed));
+
+		const BenchmarkResult& benchmark = runner.addResult(U"Notification/mpscStress", std::move(result.drainSamples), NotificationAddon::MaxDrainPerFrame)
+			.setMetric(U"producers", static_cast<double>(numProducers))
+			.setMetric(U"expected", static_cast<double>(expected))
+			.setMetric(U"lost", static_cast<double>(lost))
+			.setMetric(U"orderViolations", static_cast<double>(result.numOrderViolations))
+			.setMetric(U"totalMillisec", static_cast<double>(result.totalMillisec));
+
+		if (lost != 0)
+		{
+			runner.addFailure(U"Notification/mpscStress", U"{} 件中 {} 件を受け取りました。"_fmt(expected, result.numConsumed));
+		}
+
+		if (result.numOrderViolations != 0)
+		{
+			runner.addFailure(U"Notification/mpscStress", U"同じスレッドから追加した要素の順序が {} 件入れ替わりました。"_fmt(result.numOrderViolations));
+		}
+
+		if (static_cast<double>(MaxDrainNanosec) < benchmark.maxNanosec)
+		{
+			runner.addFailure(U"Notification/mpscStress", U"1 フレーム分の取り出しに {:.0f} ns かかりました（上限 {} ns）。"_fmt(benchmark.maxNanosec, MaxDrainNanosec));
+		}
+	}
+
+	// 複数のスレッドから NotificationAddon::Show を呼び、追加にかかる時間を計測します。
+	Array<String> messages;
+
+	for (size_t i = 0; i < 64; ++i)
+	{
+		messages << U"config ファイル`{}`が更新されました。"_fmt(i);
+	}
+
+	runner.run(U"Notification/show", (numProducers * options.numEvents), [&]
+		{
+			Array<std::thread> producers;
+
+			for (size_t producer = 0; producer < numProducers; ++producer)
+			{
+				producers.emplace_back([&]
+					{
+						for (size_t i = 0; i < options.numEvents; ++i)
+						{
+							NotificationAddon::Show(messages[(i % messages.size())], NotificationAddon::Type::Information);
+						}
+					});
+			}
+
+			for (auto& producer : producers)
+			{
+				producer.join();
+			}
+
+			// 追加した通知を、フレームごとに取り出す数を超えても全て取り出します。
+			for (size_t i = 0; i < (((numProducers * options.numEvents) / NotificationAddon::MaxDrainPerFrame) + 1); ++i)
+			{
+				System::Update();
+			}
+		});
+}
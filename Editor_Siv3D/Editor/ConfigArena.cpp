@@ -0,0 +1,20 @@
+﻿# include "ConfigArena.hpp"
+
+ConfigArena::ConfigArena(const size_t initialSize, const size_t numObjectsHint)
+	: m_resource{ Max<size_t>(initialSize, 1) }
+{
+	m_destructors.reserve(numObjectsHint);
+}
+
+ConfigArena::~ConfigArena()
+{
+	for (auto it = m_destructors.rbegin(); it != m_destructors.rend(); ++it)
+	{
+		it->destroy(it->object);
+	}
+}
+
+size_t ConfigArena::numObjects() const noexcept
+{
+	return m_numObjects;
+}
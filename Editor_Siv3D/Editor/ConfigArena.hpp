@@ -0,0 +1,67 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include <memory_resource>
+
+/// @brief ConfigStore::publish() がスナップショットのためにコピーする config をまとめて確保し、どの世代からも参照されなくなったときにまとめて解放する領域です。
+/// @remark 確保した config のデストラクタは、領域を破棄するときに確保と逆の順番で呼ばれます。
+/// @remark パースのときの確保（config 本体、JSON の DOM）と、config の String や Array のメンバが確保するメモリは、この領域には含まれません。
+/// 省けるのはスナップショットの config 1 つにつき 1 回の確保だけです。String と Array は std::allocator を使うため、世代ごとに 1 つの領域へまとめるには config の型を pmr のコンテナに変える必要があり、行っていません。
+class ConfigArena
+{
+public:
+	/// @brief 領域を作成します。
+	/// @param initialSize 最初に確保する領域のサイズ（バイト）です。足りなくなった場合は領域を追加します。
+	/// @param numObjectsHint 確保する config の数の見込みです。
+	explicit ConfigArena(size_t initialSize, size_t numObjectsHint = 0);
+
+	/// @brief 確保した全ての config のデストラクタを呼び、領域を解放します。
+	~ConfigArena();
+
+	ConfigArena(const ConfigArena&) = delete;
+
+	ConfigArena& operator=(const ConfigArena&) = delete;
+
+	/// @brief config を領域に作成します。
+	/// @tparam Type config の型
+	/// @param args コンストラクタの引数
+	/// @return 作成した config へのポインタです。領域を破棄するまで有効です。
+	/// @remark 複数のスレッドから同時に呼び出すことはできません。
+	template <class Type, class... Args>
+	[[nodiscard]]
+	Type* create(Args&&... args)
+	{
+		void* p = m_resource.allocate(sizeof(Type), alignof(Type));
+		Type* object = ::new (p) Type(std::forward<Args>(args)...);
+
+		if constexpr (not std::is_trivially_destructible_v<Type>)
+		{
+			m_destructors.push_back({ object, [](void* p) { static_cast<Type*>(p)->~Type(); } });
+		}
+
+		++m_numObjects;
+		return object;
+	}
+
+	/// @brief 作成した config の数を返します。
+	[[nodiscard]]
+	size_t numObjects() const noexcept;
+
+private:
+
+	/// @brief 破棄するオブジェクトと、そのデストラクタを呼ぶ関数
+	struct Destructor
+	{
+		void* object;
+
+		void (*destroy)(void*);
+	};
+
+	/// @brief config を確保する領域
+	std::pmr::monotonic_buffer_resource m_resource;
+
+	/// @brief 作成した config のデストラクタ（m_resource に確保します）
+	std::pmr::vector<Destructor> m_destructors{ &m_resource };
+
+	/// @brief 作成した config の数
+	size_t m_numObjects = 0;
+};
@@ -0,0 +1,176 @@
+﻿# include "ConfigBundle.hpp"
+# include "Editor.hpp"
+
+namespace
+{
+	/// @brief bundle の先頭を表す値（"CFGB"）
+	constexpr uint32 BundleMagic = 0x42474643;
+
+	/// @brief bundle の形式のバージョンです。形式を変えた場合は値を増やしてください。
+	constexpr uint32 BundleVersion = 1;
+
+	/// @brief bundle の先頭に置かれる固定長のヘッダ
+	struct BundleHeader
+	{
+		uint32 magic = BundleMagic;
+
+		uint32 version = BundleVersion;
+
+		/// @brief インデックスのオフセット（バイト）
+		uint64 indexOffset = 0;
+
+		/// @brief インデックスのサイズ（バイト）
+		uint64 indexSize = 0;
+	};
+
+	/// @brief ディレクトリのパスを、末尾に / が付いた絶対パスにします。
+	[[nodiscard]]
+	FilePath ToDirectoryPath(const FilePathView directory)
+	{
+		FilePath path = FileSystem::FullPath(directory);
+
+		if (not path.ends_with(U'/'))
+		{
+			path << U'/';
+		}
+
+		return path;
+	}
+}
+
+bool ConfigBundle::Bake(const ConfigParser& configParser, const FilePathView configDirectory, const FilePathView bundlePath)
+{
+	const FilePath directory = ToDirectoryPath(configDirectory);
+
+	Array<Entry> entries;
+	Array<Blob> blobs;
+
+	// config は、ヘッダの直後から順に並べます。
+	uint64 offset = sizeof(BundleHeader);
+
+	for (const auto& path : FileSystem::DirectoryContents(directory, Recursive::Yes))
+	{
+		if (const String extension = FileSystem::Extension(path); ((extension != U"json") && (not ConfigParser::IsTableExtension(extension))))
+		{
+			continue;
+		}
+
+		const FilePath relativePath = FileSystem::RelativePath(path, directory);
+
+		if (auto baked = configParser.bakeFile(path, relativePath))
+		{
+			entries << Entry{ .path = relativePath, .dataType = std::move(baked->dataType), .offset = offset, .size = baked->data.size() };
+			offset += baked->data.size();
+			blobs << std::move(baked->data);
+		}
+	}
+
+	Serializer<MemoryWriter> indexWriter;
+	indexWriter(entries);
+	const Blob index = indexWriter.getWriter().retrieve();
+
+	BinaryWriter writer{ bundlePath };
+
+	if (not writer)
+	{
+		Editor::ShowError(U"bundle`{}`を作成できませんでした。"_fmt(bundlePath));
+		return false;
+	}
+
+	writer.write(BundleHeader{ .indexOffset = offset, .indexSize = index.size() });
+
+	for (const auto& blob : blobs)
+	{
+		writer.write(blob.data(), blob.size());
+	}
+
+	writer.write(index.data(), index.size());
+
+	Editor::ShowSuccess(U"{} 個の config を bundle`{}`に書き出しました。"_fmt(entries.size(), bundlePath));
+	return true;
+}
+
+bool ConfigBundle::open(const FilePathView bundlePath)
+{
+	m_entries.clear();
+	m_memory = {};
+
+	if (not m_file.open(bundlePath))
+	{
+		return false;
+	}
+
+	const MemoryMappedFileView::MappedMemory memory = m_file.mapAll();
+
+	if ((memory.data == nullptr) || (memory.size < sizeof(BundleHeader)))
+	{
+		Editor::ShowError(U"bundle`{}`が壊れています。"_fmt(bundlePath));
+		return false;
+	}
+
+	BundleHeader header;
+	std::memcpy(&header, memory.data, sizeof(BundleHeader));
+
+	if ((header.magic != BundleMagic) || (header.version != BundleVersion)
+		|| (memory.size < header.indexOffset) || ((memory.size - header.indexOffset) < header.indexSize))
+	{
+		Editor::ShowError(U"bundle`{}`の形式が異なるか、壊れています。"_fmt(bundlePath));
+		return false;
+	}
+
+	Array<Entry> entries;
+
+	try
+	{
+		Deserializer<MemoryViewReader> reader{ (memory.data + header.indexOffset), static_cast<size_t>(header.indexSize) };
+		reader(entries);
+	}
+	catch (const std::exception&)
+	{
+		Editor::ShowError(U"bundle`{}`のインデックスが壊れています。"_fmt(bundlePath));
+		return false;
+	}
+
+	// インデックスが bundle の外を指していないか確かめます。
+	for (const auto& entry : entries)
+	{
+		if ((header.indexOffset < entry.offset) || ((header.indexOffset - entry.offset) < entry.size))
+		{
+			Editor::ShowError(U"bundle`{}`のインデックスが壊れています。"_fmt(bundlePath));
+			return false;
+		}
+	}
+
+	m_memory = memory;
+	m_entries = std::move(entries);
+	return true;
+}
+
+bool ConfigBundle::isOpen() const noexcept
+{
+	return (m_memory.data != nullptr);
+}
+
+const Array<ConfigBundle::Entry>& ConfigBundle::entries() const noexcept
+{
+	return m_entries;
+}
+
+Array<LoadedConfig> ConfigBundle::load(const ConfigParser& configParser, const FilePathView configDirectory) const
+{
+	const FilePath directory = ToDirectoryPath(configDirectory);
+
+	Array<LoadedConfig> loadedConfigs;
+	loadedConfigs.reserve(m_entries.size());
+
+	for (const auto& entry : m_entries)
+	{
+		// メモリマップした領域から直接復元します。
+		if (auto pConfig = configParser.loadBaked(entry.dataType, (m_memory.data + entry.offset), static_cast<size_t>(entry.size)))
+		{
+			loadedConfigs << LoadedConfig{ .path = (directory + entry.path), .friendlyPath = entry.path, .config = std::move(pConfig) };
+		}
+	}
+
+	return loadedConfigs;
+}
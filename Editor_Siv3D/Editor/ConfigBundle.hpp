@@ -0,0 +1,77 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include "ConfigParser.hpp"
+# include "ConfigLoader.hpp"
+
+/// @brief config ディレクトリの config をまとめてシリアライズした、リリースビルド用のバイナリファイルです。
+/// @remark ファイルはメモリマップして読むため、起動時に JSON のテキストを読み込んだりトークン化したりしません。
+class ConfigBundle
+{
+public:
+	/// @brief bundle に格納された config の情報です。
+	struct Entry
+	{
+		/// @brief config ディレクトリからの相対パス
+		FilePath path;
+
+		/// @brief データタイプ
+		String dataType;
+
+		/// @brief ファイルの先頭からシリアライズされた config までのオフセット（バイト）
+		uint64 offset = 0;
+
+		/// @brief シリアライズされた config のサイズ（バイト）
+		uint64 size = 0;
+
+		template <class Archive>
+		void SIV3D_SERIALIZE(Archive& archive)
+		{
+			archive(path, dataType, offset, size);
+		}
+	};
+
+	/// @brief config ディレクトリの全ての JSON ファイルと表のファイル（csv, ini）をパースし、bundle に書き出します。
+	/// @param configParser パースに使う ConfigParser です。パーサーの登録を済ませておく必要があります。
+	/// @param configDirectory config ディレクトリ
+	/// @param bundlePath 書き出す bundle のパスです。config ディレクトリの外を指定してください。
+	/// @return 書き出しに成功した場合 true, それ以外の場合は false
+	/// @remark パースできなかったファイルは bundle に含まれません。
+	static bool Bake(const ConfigParser& configParser, FilePathView configDirectory, FilePathView bundlePath);
+
+	ConfigBundle() = default;
+
+	ConfigBundle(const ConfigBundle&) = delete;
+
+	ConfigBundle& operator=(const ConfigBundle&) = delete;
+
+	/// @brief bundle をメモリマップし、インデックスを読み込みます。
+	/// @param bundlePath bundle のパス
+	/// @return 開くことができた場合 true, それ以外の場合は false
+	bool open(FilePathView bundlePath);
+
+	/// @brief bundle を開いているかを返します。
+	[[nodiscard]]
+	bool isOpen() const noexcept;
+
+	/// @brief bundle に格納された config の情報を返します。
+	[[nodiscard]]
+	const Array<Entry>& entries() const noexcept;
+
+	/// @brief bundle に格納された全ての config を復元します。
+	/// @param configParser 復元に使う ConfigParser です。パーサーの登録を済ませておく必要があります。
+	/// @param configDirectory bake したときの config ディレクトリです。LoadedConfig::path は JSON ファイルを読み込んだ場合と同じになります。
+	/// @return 復元できた config
+	[[nodiscard]]
+	Array<LoadedConfig> load(const ConfigParser& configParser, FilePathView configDirectory) const;
+
+private:
+
+	/// @brief メモリマップした bundle
+	MemoryMappedFileView m_file;
+
+	/// @brief bundle 全体のメモリ
+	MemoryMappedFileView::MappedMemory m_memory;
+
+	/// @brief bundle に格納された config の情報
+	Array<Entry> m_entries;
+};
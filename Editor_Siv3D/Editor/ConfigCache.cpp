@@ -0,0 +1,193 @@
+﻿# include "ConfigCache.hpp"
+# include "Editor.hpp"
+
+namespace
+{
+	/// @brief キャッシュファイルとマニフェストの形式のバージョンです。形式を変えた場合は値を増やしてください。
+	constexpr uint32 CacheVersion = 2;
+
+	/// @brief マニフェストのファイル名
+	constexpr StringView ManifestFileName = U"manifest.bin";
+}
+
+FileFingerprint FileFingerprint::FromStatus(const FilePathView path)
+{
+	return{ .size = FileSystem::FileSize(path), .writeTime = FileSystem::WriteTime(path).value_or(DateTime{}) };
+}
+
+uint64 FileFingerprint::HashContent(const void* data, const size_t size) noexcept
+{
+	const auto* bytes = static_cast<const uint8*>(data);
+	uint64 hash = 14695981039346656037ull;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash = ((hash ^ bytes[i]) * 1099511628211ull);
+	}
+
+	return hash;
+}
+
+ConfigCache::~ConfigCache()
+{
+	saveManifest();
+}
+
+bool ConfigCache::init(const FilePathView directory)
+{
+	if ((not FileSystem::IsDirectory(directory)) && (not FileSystem::CreateDirectories(directory)))
+	{
+		Editor::ShowError(U"キャッシュディレクトリ`{}`の作成に失敗しました。"_fmt(directory));
+		return false;
+	}
+
+	m_directory = FileSystem::FullPath(directory);
+
+	if (not m_directory.ends_with(U'/'))
+	{
+		m_directory << U'/';
+	}
+
+	HashTable<FilePath, Entry> entries;
+
+	if (Deserializer<BinaryReader> reader{ (m_directory + ManifestFileName) }; reader.getReader())
+	{
+		try
+		{
+			uint32 version = 0;
+			uint64 numEntries = 0;
+			reader(version, numEntries);
+
+			// 形式が異なるマニフェストは使わずに作り直します。
+			if (version == CacheVersion)
+			{
+				for (uint64 i = 0; i < numEntries; ++i)
+				{
+					FilePath path;
+					Entry entry;
+					reader(path, entry);
+					entries.emplace(std::move(path), std::move(entry));
+				}
+			}
+		}
+		catch (const std::exception&)
+		{
+			Editor::ShowWarning(U"config のキャッシュのマニフェストが壊れているため作り直します。");
+			entries.clear();
+		}
+	}
+
+	std::lock_guard lock{ m_mutex };
+	m_entries = std::move(entries);
+	m_dirty = false;
+
+	Editor::ShowInfo(U"config のキャッシュ`{}`を読み込みました（{} 件）。"_fmt(directory, m_entries.size()));
+	return true;
+}
+
+bool ConfigCache::isEnabled() const noexcept
+{
+	return (not m_directory.isEmpty());
+}
+
+Optional<ConfigCache::Entry> ConfigCache::find(const FilePathView path) const
+{
+	std::lock_guard lock{ m_mutex };
+
+	if (auto it = m_entries.find(path); (it != m_entries.end()))
+	{
+		return it->second;
+	}
+
+	return none;
+}
+
+std::unique_ptr<IConfig> ConfigCache::load(const FilePathView path, const Entry& entry, const std::function<std::unique_ptr<IConfig>(Deserializer<BinaryReader>&)>& loadConfig) const
+{
+	Deserializer<BinaryReader> reader{ cacheFilePath(path) };
+
+	if (not reader.getReader())
+	{
+		return nullptr;
+	}
+
+	try
+	{
+		uint32 version = 0;
+		uint64 hash = 0;
+		String dataType;
+		uint64 layoutHash = 0;
+		reader(version, hash, dataType, layoutHash);
+
+		// マニフェストの保存前に終了した場合などに備えて、キャッシュファイル自体の情報も確かめます。
+		if ((version != CacheVersion) || (hash != entry.fingerprint.hash) || (dataType != entry.dataType) || (layoutHash != entry.layoutHash))
+		{
+			return nullptr;
+		}
+
+		return loadConfig(reader);
+	}
+	catch (const std::exception&)
+	{
+		// キャッシュファイルが壊れている場合は JSON からパースし直します。
+		return nullptr;
+	}
+}
+
+void ConfigCache::save(const FilePathView path, const Entry& entry, const std::function<void(Serializer<BinaryWriter>&)>& saveConfig)
+{
+	{
+		Serializer<BinaryWriter> writer{ cacheFilePath(path) };
+
+		if (not writer.getWriter())
+		{
+			Editor::ShowWarning(U"config ファイル`{}`のキャッシュを保存できませんでした。"_fmt(path));
+			return;
+		}
+
+		writer(CacheVersion, entry.fingerprint.hash, entry.dataType, entry.layoutHash);
+		saveConfig(writer);
+	}
+
+	updateEntry(path, entry);
+}
+
+void ConfigCache::updateEntry(const FilePathView path, const Entry& entry)
+{
+	std::lock_guard lock{ m_mutex };
+	m_entries[path] = entry;
+	m_dirty = true;
+}
+
+bool ConfigCache::saveManifest()
+{
+	std::lock_guard lock{ m_mutex };
+
+	if ((not m_dirty) || m_directory.isEmpty())
+	{
+		return true;
+	}
+
+	Serializer<BinaryWriter> writer{ (m_directory + ManifestFileName) };
+
+	if (not writer.getWriter())
+	{
+		return false;
+	}
+
+	writer(CacheVersion, static_cast<uint64>(m_entries.size()));
+
+	for (const auto& [path, entry] : m_entries)
+	{
+		writer(path, entry);
+	}
+
+	m_dirty = false;
+	return true;
+}
+
+FilePath ConfigCache::cacheFilePath(const FilePathView path) const
+{
+	const uint64 hash = FileFingerprint::HashContent(path.data(), (path.size() * sizeof(char32)));
+	return U"{}{:016X}.bin"_fmt(m_directory, hash);
+}
@@ -0,0 +1,145 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include "IConfig.hpp"
+
+/// @brief ファイルの内容が変わったかを判定するための情報です。
+struct FileFingerprint
+{
+	/// @brief ファイルサイズ（バイト）
+	int64 size = 0;
+
+	/// @brief 最終更新日時
+	DateTime writeTime;
+
+	/// @brief ファイルの内容のハッシュ値
+	uint64 hash = 0;
+
+	/// @brief サイズと最終更新日時が一致するかを返します。
+	/// @param other 比較する情報
+	/// @return 一致する場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool hasSameStatus(const FileFingerprint& other) const noexcept
+	{
+		return ((size == other.size) && (writeTime == other.writeTime));
+	}
+
+	/// @brief サイズと内容のハッシュ値が一致するかを返します。
+	/// @param other 比較する情報
+	/// @return 一致する場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool hasSameContent(const FileFingerprint& other) const noexcept
+	{
+		return ((size == other.size) && (hash == other.hash));
+	}
+
+	/// @brief ファイルのサイズと最終更新日時を取得します。内容のハッシュ値は計算しません。
+	/// @param path ファイルのパス
+	/// @return ファイルの情報
+	[[nodiscard]]
+	static FileFingerprint FromStatus(FilePathView path);
+
+	/// @brief ハッシュ値（FNV-1a）を計算します。
+	/// @param data データの先頭
+	/// @param size データのサイズ（バイト）
+	/// @return ハッシュ値
+	[[nodiscard]]
+	static uint64 HashContent(const void* data, size_t size) noexcept;
+
+	template <class Archive>
+	void SIV3D_SERIALIZE(Archive& archive)
+	{
+		archive(size, writeTime.year, writeTime.month, writeTime.day,
+			writeTime.hour, writeTime.minute, writeTime.second, writeTime.milliseconds, hash);
+	}
+};
+
+/// @brief パースに成功した config をディスクに保存し、次回の起動時に JSON をパースせずに復元します。
+/// @remark 保存したファイルの情報はマニフェストにまとめて記録します。
+class ConfigCache
+{
+public:
+	/// @brief マニフェストに記録される、config ファイルごとの情報です。
+	struct Entry
+	{
+		/// @brief パースしたときのファイルの情報
+		FileFingerprint fingerprint;
+
+		/// @brief データタイプ
+		String dataType;
+
+		/// @brief 保存したときの config の型の構成のハッシュ値
+		uint64 layoutHash = 0;
+
+		template <class Archive>
+		void SIV3D_SERIALIZE(Archive& archive)
+		{
+			archive(fingerprint, dataType, layoutHash);
+		}
+	};
+
+	ConfigCache() = default;
+
+	/// @brief マニフェストに変更があれば保存します。
+	~ConfigCache();
+
+	ConfigCache(const ConfigCache&) = delete;
+
+	ConfigCache& operator=(const ConfigCache&) = delete;
+
+	/// @brief キャッシュを保存するディレクトリを指定し、マニフェストを読み込みます。
+	/// @param directory キャッシュを保存するディレクトリです。監視している config ディレクトリの外を指定してください。
+	/// @return ディレクトリを準備できた場合 true, それ以外の場合は false
+	bool init(FilePathView directory);
+
+	/// @brief キャッシュが有効かを返します。
+	/// @return init() に成功している場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool isEnabled() const noexcept;
+
+	/// @brief config ファイルのマニフェストの情報を返します。
+	/// @param path config ファイルの絶対パス
+	/// @return マニフェストの情報。記録されていない場合は none
+	[[nodiscard]]
+	Optional<Entry> find(FilePathView path) const;
+
+	/// @brief キャッシュから config を復元します。
+	/// @param path config ファイルの絶対パス
+	/// @param entry マニフェストの情報
+	/// @param loadConfig config を読み込む関数
+	/// @return 復元した config。キャッシュが壊れているか古い場合は nullptr
+	[[nodiscard]]
+	std::unique_ptr<IConfig> load(FilePathView path, const Entry& entry, const std::function<std::unique_ptr<IConfig>(Deserializer<BinaryReader>&)>& loadConfig) const;
+
+	/// @brief config をキャッシュに保存し、マニフェストを更新します。
+	/// @param path config ファイルの絶対パス
+	/// @param entry マニフェストの情報
+	/// @param saveConfig config を書き込む関数
+	void save(FilePathView path, const Entry& entry, const std::function<void(Serializer<BinaryWriter>&)>& saveConfig);
+
+	/// @brief マニフェストのファイルの情報だけを更新します。
+	/// @param path config ファイルの絶対パス
+	/// @param entry マニフェストの情報
+	void updateEntry(FilePathView path, const Entry& entry);
+
+	/// @brief マニフェストに変更があれば保存します。
+	/// @return 保存に成功したか、変更が無い場合 true, それ以外の場合は false
+	bool saveManifest();
+
+private:
+
+	/// @brief config ファイルに対応するキャッシュファイルのパスを返します。
+	[[nodiscard]]
+	FilePath cacheFilePath(FilePathView path) const;
+
+	/// @brief キャッシュを保存するディレクトリ
+	FilePath m_directory;
+
+	/// @brief m_entries と m_dirty を保護するミューテックス
+	mutable std::mutex m_mutex;
+
+	/// @brief config ファイルの絶対パスとマニフェストの情報
+	HashTable<FilePath, Entry> m_entries;
+
+	/// @brief マニフェストに保存していない変更があるか
+	bool m_dirty = false;
+};
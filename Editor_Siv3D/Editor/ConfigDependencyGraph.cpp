@@ -0,0 +1,153 @@
+﻿# include "ConfigDependencyGraph.hpp"
+
+void ConfigDependencyGraph::setIncludes(const FilePath& path, const Array<FilePath>& includes)
+{
+	std::lock_guard lock{ m_mutex };
+
+	if (auto it = m_includes.find(path); (it != m_includes.end()))
+	{
+		for (const auto& include : it->second)
+		{
+			m_dependents[include].erase(path);
+		}
+
+		m_includes.erase(it);
+	}
+
+	if (not includes)
+	{
+		return;
+	}
+
+	for (const auto& include : includes)
+	{
+		m_dependents[include].emplace(path);
+	}
+
+	m_includes.emplace(path, includes);
+}
+
+void ConfigDependencyGraph::remove(const FilePath& path)
+{
+	setIncludes(path, {});
+}
+
+Array<FilePath> ConfigDependencyGraph::includesOf(const FilePath& path) const
+{
+	std::lock_guard lock{ m_mutex };
+
+	if (auto it = m_includes.find(path); (it != m_includes.end()))
+	{
+		return it->second;
+	}
+
+	return{};
+}
+
+bool ConfigDependencyGraph::isIncluded(const FilePath& path) const
+{
+	std::lock_guard lock{ m_mutex };
+
+	// include をやめたファイルは空の集合として残るため、要素があるかを調べます。
+	if (auto it = m_dependents.find(path); (it != m_dependents.end()))
+	{
+		return (not it->second.empty());
+	}
+
+	return false;
+}
+
+Array<FilePath> ConfigDependencyGraph::collectAffected(const Array<FilePath>& changedPaths) const
+{
+	std::lock_guard lock{ m_mutex };
+
+	// 変更されたファイルから、include している側へ辿れる全てのファイルを集めます。
+	Array<FilePath> affected;
+	HashSet<FilePath> visited;
+
+	for (const auto& path : changedPaths)
+	{
+		if (visited.emplace(path).second)
+		{
+			affected << path;
+		}
+	}
+
+	for (size_t i = 0; i < affected.size(); ++i)
+	{
+		if (auto it = m_dependents.find(affected[i]); (it != m_dependents.end()))
+		{
+			for (const auto& dependent : it->second)
+			{
+				if (visited.emplace(dependent).second)
+				{
+					affected << dependent;
+				}
+			}
+		}
+	}
+
+	// 変更が他のファイルに波及しない場合は、並べ替える必要がありません。
+	if (affected.size() == changedPaths.size())
+	{
+		return affected;
+	}
+
+	// 集めたファイルの中で、まだ読み込み直していないファイルを include している数を数えます。
+	HashTable<FilePath, size_t> numPendingIncludes;
+
+	for (const auto& path : affected)
+	{
+		size_t count = 0;
+
+		if (auto it = m_includes.find(path); (it != m_includes.end()))
+		{
+			for (const auto& include : it->second)
+			{
+				count += visited.contains(include);
+			}
+		}
+
+		numPendingIncludes.emplace(path, count);
+	}
+
+	// include しているファイルが全て並んだファイルから順に並べます（Kahn のアルゴリズム）。
+	Array<FilePath> sorted;
+	sorted.reserve(affected.size());
+
+	for (const auto& path : affected)
+	{
+		if (numPendingIncludes[path] == 0)
+		{
+			sorted << path;
+		}
+	}
+
+	for (size_t i = 0; i < sorted.size(); ++i)
+	{
+		if (auto it = m_dependents.find(sorted[i]); (it != m_dependents.end()))
+		{
+			for (const auto& dependent : it->second)
+			{
+				if (--numPendingIncludes[dependent] == 0)
+				{
+					sorted << dependent;
+				}
+			}
+		}
+	}
+
+	// 循環している include は、残ったファイルを集めた順に並べます。
+	if (sorted.size() < affected.size())
+	{
+		for (const auto& path : affected)
+		{
+			if (numPendingIncludes[path] != 0)
+			{
+				sorted << path;
+			}
+		}
+	}
+
+	return sorted;
+}
@@ -0,0 +1,49 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include <mutex>
+
+/// @brief config ファイル同士の include の関係を記録する依存グラフです。
+/// @remark 共有ファイルが変更されたときに、そのファイルを直接または間接に include している config ファイルだけを読み込み直すために使います。
+/// 全てのメンバ関数は複数のスレッドから同時に呼び出せます。
+class ConfigDependencyGraph
+{
+public:
+	/// @brief config ファイルが include しているファイルを設定します。以前に設定したファイルは置き換えられます。
+	/// @param path config ファイルの絶対パス
+	/// @param includes include しているファイルの絶対パス
+	void setIncludes(const FilePath& path, const Array<FilePath>& includes);
+
+	/// @brief config ファイルが include しているファイルの記録を取り除きます。
+	/// @param path 削除された config ファイルの絶対パス
+	/// @remark path を include しているファイルの記録は残します。
+	void remove(const FilePath& path);
+
+	/// @brief config ファイルが include しているファイルを返します。
+	/// @param path config ファイルの絶対パス
+	/// @return include しているファイルの絶対パス
+	[[nodiscard]]
+	Array<FilePath> includesOf(const FilePath& path) const;
+
+	/// @brief ファイルがいずれかの config ファイルから include されているかを返します。
+	/// @param path ファイルの絶対パス
+	/// @return include されている場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool isIncluded(const FilePath& path) const;
+
+	/// @brief 変更されたファイルと、それらを直接または間接に include している全てのファイルを返します。
+	/// @param changedPaths 変更されたファイルの絶対パス
+	/// @return include されているファイルが先に来るよう、トポロジカル順に並べたファイルの絶対パスです。循環している include はその順番によらず末尾に並べます。
+	[[nodiscard]]
+	Array<FilePath> collectAffected(const Array<FilePath>& changedPaths) const;
+
+private:
+
+	/// @brief m_includes と m_dependents を保護するミューテックス
+	mutable std::mutex m_mutex;
+
+	/// @brief ファイルと、そのファイルが include しているファイルのマップです。
+	HashTable<FilePath, Array<FilePath>> m_includes;
+
+	/// @brief ファイルと、そのファイルを include しているファイルのマップです。
+	HashTable<FilePath, HashSet<FilePath>> m_dependents;
+};
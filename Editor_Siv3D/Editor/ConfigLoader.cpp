@@ -0,0 +1,273 @@
+﻿# include "ConfigLoader.hpp"
+# include "Editor.hpp"
+# include "ReloadProfiler.hpp"
+
+ConfigLoader::ConfigLoader(ConfigParser& configParser, size_t numThreads)
+	: m_configParser{ configParser }
+	, m_threadPool{ numThreads } {}
+
+void ConfigLoader::request(const Array<FilePath>& paths)
+{
+	if (not paths)
+	{
+		return;
+	}
+
+	// 変更されたファイルを include している config ファイルも読み込み直します。
+	const Array<FilePath> affectedPaths = m_configParser.invalidate(paths);
+
+	// include している側のファイルは、変更されたファイルを読み終えてから読み込みます。
+	if (affectedPaths.size() != paths.size())
+	{
+		PendingDependents pendingDependents{ .changedPaths = HashSet<FilePath>(paths.begin(), paths.end()) };
+
+		for (const auto& path : affectedPaths)
+		{
+			if (not pendingDependents.changedPaths.contains(path))
+			{
+				pendingDependents.dependents << path;
+			}
+		}
+
+		m_pendingDependents << std::move(pendingDependents);
+	}
+
+	for (const auto& path : paths)
+	{
+		// 同じファイルを複数のワーカースレッドで同時に読み込まないよう、読み込み中のファイルは完了後にもう一度読み込みます。
+		if (m_inFlightFiles.contains(path))
+		{
+			m_deferredFiles.emplace(path);
+			continue;
+		}
+
+		dispatch(path);
+	}
+}
+
+Array<LoadedConfig> ConfigLoader::retrieveLoadedConfigs()
+{
+	Array<LoadedConfig> results;
+	{
+		std::lock_guard lock{ m_resultsMutex };
+		results.swap(m_results);
+	}
+
+	Array<LoadedConfig> loadedConfigs;
+
+	for (auto& result : results)
+	{
+		m_inFlightFiles.erase(result.path);
+
+		ReloadProfiler::RecordDelivered(result.path, (result.removed ? U"(removed)" : (result.config ? result.config->dataType() : U"(none)")));
+
+		if (auto it = m_deferredFiles.find(result.path); (it != m_deferredFiles.end()))
+		{
+			m_deferredFiles.erase(it);
+			request({ result.path });
+		}
+
+		// パースが失敗（nullptr）なら何もしません。
+		if (result.config || result.removed)
+		{
+			loadedConfigs << std::move(result);
+		}
+	}
+
+	dispatchDependents(results);
+
+	return loadedConfigs;
+}
+
+size_t ConfigLoader::numPending() const noexcept
+{
+	size_t numPending = m_inFlightFiles.size();
+
+	for (const auto& pendingDependents : m_pendingDependents)
+	{
+		numPending += pendingDependents.dependents.size();
+	}
+
+	return numPending;
+}
+
+size_t ConfigLoader::numThreads() const noexcept
+{
+	return m_threadPool.numThreads();
+}
+
+bool ConfigLoader::isLoading(const FilePath& path) const
+{
+	return m_inFlightFiles.contains(path);
+}
+
+void ConfigLoader::requestPeek(const Array<FilePath>& paths)
+{
+	for (const auto& path : paths)
+	{
+		// ファイルを開くため、メインスレッドでは読みません。
+		m_threadPool.push([this, path]
+			{
+				PeekedConfig peekedConfig{ .path = path };
+
+				if (FileSystem::Exists(path))
+				{
+					peekedConfig.dataType = m_configParser.peekDataType(path);
+				}
+				else
+				{
+					peekedConfig.removed = true;
+				}
+
+				std::lock_guard lock{ m_resultsMutex };
+				m_peekedConfigs << std::move(peekedConfig);
+			});
+	}
+}
+
+Array<PeekedConfig> ConfigLoader::retrievePeekedConfigs()
+{
+	Array<PeekedConfig> peekedConfigs;
+	{
+		std::lock_guard lock{ m_resultsMutex };
+		peekedConfigs.swap(m_peekedConfigs);
+	}
+
+	return peekedConfigs;
+}
+
+Array<std::unique_ptr<IConfig>> ConfigLoader::loadNow(const Array<FilePath>& paths)
+{
+	Array<std::unique_ptr<IConfig>> results(paths.size());
+
+	Array<FilePath> jsonPaths;
+	Array<size_t> jsonIndices;
+
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		const FilePath& path = paths[i];
+
+		// 同じファイルを複数のスレッドで同時にパースしないよう、読み込み中のファイルはワーカースレッドの結果を待ちます。
+		if (m_inFlightFiles.contains(path))
+		{
+			continue;
+		}
+
+		if (const String extension = FileSystem::Extension(path); (extension == U"json"))
+		{
+			jsonPaths << path;
+			jsonIndices << i;
+		}
+		// 表はセルの変換をスレッドプールで分担するため、1 つずつパースします。
+		else if (ConfigParser::IsTableExtension(extension))
+		{
+			results[i] = m_configParser.parseTable(path, FileSystem::RelativePath(path), &m_threadPool);
+		}
+	}
+
+	Array<std::unique_ptr<IConfig>> jsonResults = m_configParser.parseJSONBatch(jsonPaths, m_threadPool);
+
+	for (size_t i = 0; i < jsonResults.size(); ++i)
+	{
+		results[jsonIndices[i]] = std::move(jsonResults[i]);
+	}
+
+	return results;
+}
+
+void ConfigLoader::reportUnincludedFiles()
+{
+	m_configParser.reportUnincludedFiles();
+}
+
+void ConfigLoader::dispatchDependents(const Array<LoadedConfig>& results)
+{
+	if (not m_pendingDependents)
+	{
+		return;
+	}
+
+	for (const auto& result : results)
+	{
+		for (auto& pendingDependents : m_pendingDependents)
+		{
+			pendingDependents.changedPaths.erase(result.path);
+		}
+	}
+
+	// 変更されたファイルを全て読み終えたものから、include している側のファイルを 1 つずつワーカースレッドに渡します。
+	Array<FilePath> dependents;
+
+	m_pendingDependents.remove_if([&](PendingDependents& pendingDependents)
+		{
+			if (not pendingDependents.changedPaths.empty())
+			{
+				return false;
+			}
+
+			dependents.append(pendingDependents.dependents);
+			return true;
+		});
+
+	for (const auto& path : dependents)
+	{
+		if (m_inFlightFiles.contains(path))
+		{
+			m_deferredFiles.emplace(path);
+			continue;
+		}
+
+		dispatch(path);
+	}
+}
+
+void ConfigLoader::dispatch(const FilePath& path)
+{
+	m_inFlightFiles.emplace(path);
+	m_threadPool.push([this, path] { load(path); });
+}
+
+void ConfigLoader::load(const FilePath& path)
+{
+	// ファイルパスを相対パスに変換します。
+	const FilePath friendlyPath = FileSystem::RelativePath(path);
+
+	if (not FileSystem::Exists(path))
+	{
+		Editor::ShowInfo(U"configファイル`{}`が削除されました。"_fmt(friendlyPath));
+
+		m_configParser.removeFile(path);
+
+		std::lock_guard lock{ m_resultsMutex };
+		m_results << LoadedConfig{ .path = path, .friendlyPath = friendlyPath, .removed = true };
+		return;
+	}
+
+	Editor::ShowInfo(U"configファイル`{}`が更新されました。"_fmt(friendlyPath));
+
+	std::unique_ptr<IConfig> pConfig;
+	{
+		// 段階ごとの所要時間を記録します。結果をメインスレッドに渡す前に記録を終えます。
+		const ReloadProfiler::Scope profile{ path };
+		pConfig = parse(path, friendlyPath);
+	}
+
+	std::lock_guard lock{ m_resultsMutex };
+	m_results << LoadedConfig{ path, friendlyPath, std::move(pConfig) };
+}
+
+std::unique_ptr<IConfig> ConfigLoader::parse(const FilePath& path, const FilePath& friendlyPath)
+{
+	// 拡張子が .json の場合、JSON ファイルとして読み込みます。
+	if (const String extension = FileSystem::Extension(path); (extension == U"json"))
+	{
+		return m_configParser.parseJSON(path, friendlyPath);
+	}
+	// 拡張子が .csv か .ini の場合、表として読み込みます。セルの変換はワーカースレッドで分担します。
+	else if (ConfigParser::IsTableExtension(extension))
+	{
+		return m_configParser.parseTable(path, friendlyPath, &m_threadPool);
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,137 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include "IConfig.hpp"
+# include "ConfigParser.hpp"
+# include "ThreadPool.hpp"
+
+/// @brief ワーカースレッドで読み込まれた config です。
+struct LoadedConfig
+{
+	/// @brief config ファイルの絶対パスです。
+	FilePath path;
+
+	/// @brief config ファイルの相対パスです。
+	FilePath friendlyPath;
+
+	/// @brief パースされたデータです。ファイルが削除された場合は nullptr です。
+	std::unique_ptr<IConfig> config;
+
+	/// @brief config ファイルが削除されたかです。
+	bool removed = false;
+};
+
+/// @brief ワーカースレッドでデータタイプだけを読んだ config ファイルです。
+struct PeekedConfig
+{
+	/// @brief config ファイルの絶対パスです。
+	FilePath path;
+
+	/// @brief データタイプです。読めなかった場合は none です。
+	Optional<String> dataType;
+
+	/// @brief config ファイルが削除されていたかです。
+	bool removed = false;
+};
+
+/// @brief config ファイルのロードとパースをワーカースレッドで行います。
+class ConfigLoader
+{
+public:
+	/// @brief ConfigLoader を作成します。
+	/// @param configParser パースに使う ConfigParser です。ConfigLoader より長く存在し、パーサーの登録を済ませておく必要があります。
+	/// @param numThreads ワーカースレッドの数です。0 の場合は論理コア数から自動で決定します。
+	explicit ConfigLoader(ConfigParser& configParser, size_t numThreads = 0);
+
+	/// @brief config ファイルの読み込みを依頼します。
+	/// @param paths 変更のあった config ファイルの絶対パスです。
+	/// @remark 変更のあったファイルを直接または間接に include している config ファイルも、変更のあったファイルを読み終えてから 1 つずつワーカースレッドに渡して読み込み直します。
+	void request(const Array<FilePath>& paths);
+
+	/// @brief 読み込みが完了した config を取り出します。
+	/// @return パースに成功した config と、削除された config ファイルです。同じファイルの結果は依頼した順に返されます。
+	[[nodiscard]]
+	Array<LoadedConfig> retrieveLoadedConfigs();
+
+	/// @brief 読み込み中の config ファイルの数を返します。
+	/// @return 読み込み中の config ファイルと、読み込み直しを待っている include している側の config ファイルの数
+	[[nodiscard]]
+	size_t numPending() const noexcept;
+
+	/// @brief ワーカースレッドの数を返します。
+	[[nodiscard]]
+	size_t numThreads() const noexcept;
+
+	/// @brief config ファイルがワーカースレッドで読み込み中かを返します。
+	/// @param path config ファイルの絶対パス
+	[[nodiscard]]
+	bool isLoading(const FilePath& path) const;
+
+	/// @brief config ファイルをパースせずに、データタイプだけを読むようワーカースレッドに依頼します。
+	/// @param paths 変更のあった config ファイルの絶対パスです。
+	void requestPeek(const Array<FilePath>& paths);
+
+	/// @brief データタイプを読み終えた config ファイルを取り出します。
+	[[nodiscard]]
+	Array<PeekedConfig> retrievePeekedConfigs();
+
+	/// @brief config ファイルをすぐにパースし、完了するまで待ちます。JSON ファイルはスレッドプールで並列にパースします。
+	/// @param paths config ファイルの絶対パスです。
+	/// @return paths と同じ順番に並んだパースされたデータ。パースに失敗したファイル、ワーカースレッドで読み込み中のファイルは nullptr
+	/// @remark メインスレッドから呼び出します。呼び出したスレッドも処理に加わります。読み込み中のファイルの結果は retrieveLoadedConfigs() で受け取ります。
+	[[nodiscard]]
+	Array<std::unique_ptr<IConfig>> loadNow(const Array<FilePath>& paths);
+
+	/// @brief dataType が無く、どの config ファイルからも include されていないファイルをエラーとして通知します。
+	/// @remark 全ての config ファイルを読み終えてから呼び出します。
+	void reportUnincludedFiles();
+
+private:
+
+	/// @brief 変更のあったファイルの読み込みを待っている、include している側の config ファイルです。
+	struct PendingDependents
+	{
+		/// @brief 読み込みを待っている、変更のあったファイル
+		HashSet<FilePath> changedPaths;
+
+		/// @brief 変更のあったファイルを全て読み終えたら読み込み直すファイル
+		Array<FilePath> dependents;
+	};
+
+	/// @brief config ファイルの読み込みをワーカースレッドに渡します。
+	void dispatch(const FilePath& path);
+
+	/// @brief 読み込みが完了したファイルを記録し、変更のあったファイルを全て読み終えた、include している側の config ファイルの読み込みをワーカースレッドに渡します。
+	/// @param results ワーカースレッドで処理された結果
+	void dispatchDependents(const Array<LoadedConfig>& results);
+
+	/// @brief ワーカースレッドで config ファイルを読み込みます。
+	void load(const FilePath& path);
+
+	/// @brief 拡張子に対応するパーサーで config ファイルをパースします。
+	/// @return パースされたデータ。失敗した場合は nullptr
+	[[nodiscard]]
+	std::unique_ptr<IConfig> parse(const FilePath& path, const FilePath& friendlyPath);
+
+	ConfigParser& m_configParser;
+
+	/// @brief ワーカースレッドで読み込み中のファイル（メインスレッドからのみアクセス）
+	HashSet<FilePath> m_inFlightFiles;
+
+	/// @brief 読み込み中に再度変更があり、読み込みの完了後にもう一度読み込むファイル（メインスレッドからのみアクセス）
+	HashSet<FilePath> m_deferredFiles;
+
+	/// @brief 変更のあったファイルの読み込みを待っている、include している側の config ファイル（メインスレッドからのみアクセス）
+	Array<PendingDependents> m_pendingDependents;
+
+	/// @brief m_results を保護するミューテックス
+	std::mutex m_resultsMutex;
+
+	/// @brief ワーカースレッドで処理された結果
+	Array<LoadedConfig> m_results;
+
+	/// @brief ワーカースレッドでデータタイプを読んだ結果（m_resultsMutex で保護します）
+	Array<PeekedConfig> m_peekedConfigs;
+
+	/// @brief ワーカースレッド（最初に破棄されるよう最後に宣言します）
+	ThreadPool m_threadPool;
+};
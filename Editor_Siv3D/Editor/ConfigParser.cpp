@@ -1,66 +1,777 @@
 ﻿# include "ConfigParser.hpp"
 # include "Editor.hpp"
+# include "ReloadProfiler.hpp"
 
 namespace
 {
-	/// @brief path から JSON をロードします。
-	/// @param path JSON ファイルの絶対パスです。
+	/// @brief ファイルの内容から JSON をロードします。
+	/// @param blob JSON ファイルの内容です。
 	/// @param friendlyPath JSON ファイルの相対パスです。
-	/// @return JSON とデータタイプのペアを返します。ロードに失敗した場合は空のペアを返します。
+	/// @return ロードした JSON を返します。ロードに失敗した場合は無効な JSON を返します。
 	[[nodiscard]]
-	static std::pair<JSON, String> LoadConfigJSON(const FilePathView path, const FilePathView friendlyPath)
+	static JSON LoadConfigJSON(const Blob& blob, const FilePathView friendlyPath)
 	{
 		Editor::ShowInfo(U"config ファイル`{}`を JSON としてロードします"_fmt(friendlyPath));
 
-		const JSON json = JSON::Load(path);
+		JSON json = JSON::Load(MemoryReader{ blob });
 
 		if (not json)
 		{
 			Editor::ShowError(U"config　ファイル`{}`のロードに失敗しました（不正なJSON）。"_fmt(friendlyPath));
-			return{};
+			return JSON::Invalid();
 		}
 
-		if (not json.contains(U"dataType") || not json[U"dataType"].isString())
+		return json;
+	}
+
+	/// @brief JSON のデータタイプを取得します。
+	/// @param json include を解決した JSON です。
+	/// @param friendlyPath JSON ファイルの相対パスです。
+	/// @return データタイプを返します。dataType が不正な場合は none を返します。
+	[[nodiscard]]
+	static Optional<String> GetDataType(const JSON& json, const FilePathView friendlyPath)
+	{
+		if (not json[U"dataType"].isString())
 		{
-			Editor::ShowError(U"config ファイル`{}`: dataTypeがないか不正です。"_fmt(friendlyPath));
-			return{};
+			Editor::ShowError(U"config ファイル`{}`: dataTypeが不正です。"_fmt(friendlyPath));
+			return none;
 		}
 
 		const String dataType = json[U"dataType"].getString();
 
 		Editor::ShowSuccess(U"データタイプは`{}`です。"_fmt(dataType));
 
-		return { json,dataType };
+		return dataType;
+	}
+
+	/// @brief ファイルが include を持つ可能性があるかを、JSON をロードせずに判定します。
+	/// @return `"include"`という文字列を含む場合 true, それ以外の場合は false
+	[[nodiscard]]
+	static bool MayHaveIncludes(const Blob& blob) noexcept
+	{
+		const std::string_view text{ reinterpret_cast<const char*>(blob.data()), blob.size() };
+		return (text.find(R"("include")") != std::string_view::npos);
+	}
+
+	/// @brief peekDataType() で最初に読むファイルの先頭のサイズ（バイト）
+	constexpr int64 PeekSize = 4096;
+
+	/// @brief ストリームパーサーで config を作成します。最上位のオブジェクトの後ろに空白以外がある場合は失敗とします。
+	/// @return 作成した config。失敗した場合は nullptr
+	[[nodiscard]]
+	static std::unique_ptr<IConfig> ParseStream(const std::function<std::unique_ptr<IConfig>(JSONStreamReader&)>& parser, JSONStreamReader& reader)
+	{
+		reader.next();
+
+		auto pConfig = parser(reader);
+
+		if ((not pConfig) || (reader.token() != JSONStreamReader::Token::EndObject) || (reader.next() != JSONStreamReader::Token::End))
+		{
+			return nullptr;
+		}
+
+		return pConfig;
+	}
+
+	/// @brief from のメンバを to に書き込みます。同じキーのメンバは上書きします。
+	static void MergeMembers(JSON& to, const JSON& from)
+	{
+		for (const auto& object : from)
+		{
+			if (object.key != U"include")
+			{
+				to[object.key] = object.value;
+			}
+		}
 	}
 }
 
 void ConfigParser::addJSONParser(StringView dataType, std::function<std::unique_ptr<IConfig>(const JSON&)> parser)
 {
+	std::lock_guard lock{ m_parsersMutex };
 	m_jsonParsers[dataType] = parser;
 }
 
+void ConfigParser::addTableParser(StringView dataType, std::function<std::unique_ptr<IConfig>(const TableText&, ThreadPool*)> parser)
+{
+	std::lock_guard lock{ m_parsersMutex };
+	m_tableParsers[dataType] = std::move(parser);
+}
+
+bool ConfigParser::IsTableExtension(const StringView extension) noexcept
+{
+	return ((extension == U"csv") || (extension == U"ini"));
+}
+
+void ConfigParser::addJSONStreamParser(StringView dataType, std::function<std::unique_ptr<IConfig>(JSONStreamReader&)> parser)
+{
+	std::lock_guard lock{ m_parsersMutex };
+	m_jsonStreamParsers[dataType] = std::move(parser);
+}
+
+bool ConfigParser::enableCache(const FilePathView directory)
+{
+	return m_cache.init(directory);
+}
+
 std::unique_ptr<IConfig> ConfigParser::parseJSON(FilePathView path, FilePathView friendlyPath)
 {
-	// path から JSON をロードします。
-	const auto [json, dataType] = LoadConfigJSON(path, friendlyPath);
+	return parseFile(path, friendlyPath, [&](const Blob& blob) { return parseJSONContent(blob, path, friendlyPath); });
+}
 
-	// ロードした JSON のデータタイプをもとにパーサーを呼び出します。
-	if (auto it = m_jsonParsers.find(dataType);(it == m_jsonParsers.end()))
+std::unique_ptr<IConfig> ConfigParser::parseTable(const FilePathView path, const FilePathView friendlyPath, ThreadPool* threadPool)
+{
+	const String extension = FileSystem::Extension(path);
+	return parseFile(path, friendlyPath, [&](const Blob& blob) { return parseTableContent(blob, extension, friendlyPath, threadPool); });
+}
+
+std::unique_ptr<IConfig> ConfigParser::parseFile(const FilePathView path, const FilePathView friendlyPath, const std::function<std::unique_ptr<IConfig>(const Blob&)>& parseContent)
+{
+	FileFingerprint fingerprint = FileFingerprint::FromStatus(path);
+
+	Optional<FileFingerprint> previous;
+	{
+		std::lock_guard lock{ m_fingerprintMutex };
+
+		if (auto it = m_fingerprints.find(path); (it != m_fingerprints.end()))
+		{
+			previous = it->second;
+		}
+	}
+
+	// 前回パースしたファイルは、サイズと更新日時が同じでも読み込んでハッシュ値を比べます。
+	// 更新日時の分解能より短い間隔で同じサイズの内容に書き換えられた場合も、変更を見逃さないためです。
+	// 起動後に初めて読み込むファイルは、前回の起動時のキャッシュがあれば使います。
+	const Optional<ConfigCache::Entry> cacheEntry = ((previous || (not m_cache.isEnabled())) ? none : m_cache.find(path));
+
+	// サイズと更新日時がキャッシュと同じ場合、ファイルを読まずにキャッシュから復元します。
+	if (cacheEntry && cacheEntry->fingerprint.hasSameStatus(fingerprint))
+	{
+		fingerprint.hash = cacheEntry->fingerprint.hash;
+
+		if (auto pConfig = restoreFromCache(path, friendlyPath, *cacheEntry, fingerprint))
+		{
+			return pConfig;
+		}
+	}
+
+	Blob blob;
+	{
+		const ReloadProfiler::StageTimer timer{ ReloadStage::Read };
+		blob = Blob{ path };
+	}
+
+	fingerprint.size = static_cast<int64>(blob.size());
+	fingerprint.hash = FileFingerprint::HashContent(blob.data(), blob.size());
+
+	// 内容が前回パースに成功したときと同じ場合はスキップします。
+	if (previous && previous->hasSameContent(fingerprint))
+	{
+		recordFingerprint(path, fingerprint);
+
+		++m_numSkippedReloads;
+
+		if (Editor::IsVerbose())
+		{
+			Editor::ShowVerbose(U"config ファイル`{}`の内容は変更されていないためスキップします。"_fmt(friendlyPath));
+		}
+
+		return nullptr;
+	}
+
+	// 更新日時だけが変わり、内容がキャッシュと同じ場合もキャッシュから復元します。
+	if (cacheEntry && cacheEntry->fingerprint.hasSameContent(fingerprint))
+	{
+		if (auto pConfig = restoreFromCache(path, friendlyPath, *cacheEntry, fingerprint))
+		{
+			return pConfig;
+		}
+	}
+
+	if (auto pConfig = parseContent(blob))
+	{
+		recordFingerprint(path, fingerprint);
+
+		// 次回の起動時に使うキャッシュを保存します。include を持つファイルは、include したファイルによって結果が変わるため保存しません。
+		if (not m_dependencies.includesOf(FilePath{ path }))
+		{
+			saveToCache(path, fingerprint, *pConfig);
+		}
+
+		return pConfig;
+	}
+
+	return nullptr;
+}
+
+Array<std::unique_ptr<IConfig>> ConfigParser::parseJSONBatch(const Array<FilePath>& paths, ThreadPool& threadPool)
+{
+	Array<std::unique_ptr<IConfig>> results(paths.size());
+
+	// 結果は paths のインデックスの位置に書き込むため、完了の順番によらず並びは一定です。
+	threadPool.parallelFor(paths.size(), [&](const size_t i)
+		{
+			results[i] = parseJSON(paths[i], FileSystem::RelativePath(paths[i]));
+		});
+
+	return results;
+}
+
+Optional<BakedConfig> ConfigParser::bakeFile(const FilePathView path, const FilePathView friendlyPath) const
+{
+	const String extension = FileSystem::Extension(path);
+	const Blob blob{ path };
+	std::unique_ptr<IConfig> pConfig;
+
+	if (extension == U"json")
+	{
+		pConfig = parseJSONContent(blob, path, friendlyPath);
+	}
+	else if (IsTableExtension(extension))
+	{
+		pConfig = parseTableContent(blob, extension, friendlyPath, nullptr);
+	}
+
+	if (not pConfig)
+	{
+		return none;
+	}
+
+	std::shared_lock lock{ m_parsersMutex };
+
+	auto it = m_serializeFunctions.find(pConfig->dataType());
+
+	if (it == m_serializeFunctions.end())
+	{
+		Editor::ShowWarning(U"データタイプ`{}`は SIV3D_SERIALIZE を持たないため、config ファイル`{}`を bundle に格納できません。"_fmt(pConfig->dataType(), friendlyPath));
+		return none;
+	}
+
+	Serializer<MemoryWriter> writer;
+	it->second.bake(writer, *pConfig);
+
+	return BakedConfig{ .dataType = String{ pConfig->dataType() }, .data = writer.getWriter().retrieve() };
+}
+
+std::unique_ptr<IConfig> ConfigParser::loadBaked(const StringView dataType, const void* data, const size_t size) const
+{
+	std::shared_lock lock{ m_parsersMutex };
+
+	auto it = m_serializeFunctions.find(dataType);
+
+	if (it == m_serializeFunctions.end())
 	{
 		Editor::ShowError(U"データタイプ`{}`のパーサーが登録されていません。"_fmt(dataType));
 		return nullptr;
 	}
+
+	try
+	{
+		Deserializer<MemoryViewReader> reader{ data, size };
+		return it->second.loadBaked(reader);
+	}
+	catch (const std::exception&)
+	{
+		Editor::ShowError(U"データタイプ`{}`の config を bundle から復元できませんでした。"_fmt(dataType));
+		return nullptr;
+	}
+}
+
+Optional<String> ConfigParser::peekDataType(const FilePathView path) const
+{
+	const String extension = FileSystem::Extension(path);
+	const bool isTable = IsTableExtension(extension);
+
+	if ((extension != U"json") && (not isTable))
+	{
+		return none;
+	}
+
+	// サイズと更新日時が前回の起動時のキャッシュと同じ場合は、ファイルを読みません。
+	if (m_cache.isEnabled())
+	{
+		if (const auto cacheEntry = m_cache.find(path); (cacheEntry && cacheEntry->fingerprint.hasSameStatus(FileFingerprint::FromStatus(path))))
+		{
+			return cacheEntry->dataType;
+		}
+	}
+
+	BinaryReader reader{ path };
+
+	if (not reader)
+	{
+		return none;
+	}
+
+	// dataType はファイルの先頭に書かれていることが多いため、まず先頭だけを読みます。
+	const int64 fileSize = reader.size();
+	Blob header(static_cast<size_t>(Min(fileSize, PeekSize)));
+
+	if (reader.read(header.data(), static_cast<int64>(header.size())) != static_cast<int64>(header.size()))
+	{
+		return none;
+	}
+
+	const auto peek = [&](const Blob& blob) -> Optional<String>
+		{
+			if (extension == U"json")
+			{
+				return JSONStreamReader::PeekDataType(blob.data(), blob.size());
+			}
+
+			return ((extension == U"csv") ? TableText::PeekDataTypeCSV(blob) : TableText::PeekDataTypeINI(blob));
+		};
+
+	if (fileSize <= PeekSize)
+	{
+		return peek(header);
+	}
+
+	// 行の途中で切れた値を読まないよう、最後の改行までにします。
+	const std::string_view text{ reinterpret_cast<const char*>(header.data()), header.size() };
+
+	if (const size_t lastNewline = text.find_last_of('\n'); (lastNewline != std::string_view::npos))
+	{
+		header.resize(lastNewline + 1);
+
+		if (auto dataType = peek(header))
+		{
+			return dataType;
+		}
+	}
+
+	// 先頭に見つからない場合は、ファイル全体を読みます。パースはしません。
+	Blob blob{ path };
+	return peek(blob);
+}
+
+Array<FilePath> ConfigParser::invalidate(const Array<FilePath>& changedPaths)
+{
+	Array<FilePath> affectedPaths = m_dependencies.collectAffected(changedPaths);
+
+	{
+		std::lock_guard lock{ m_includeMutex };
+
+		// 読み込み中のワーカースレッドが、変更前の内容を後からキャッシュに書き戻さないよう世代を進めます。
+		for (const auto& path : affectedPaths)
+		{
+			m_includeCache.erase(path);
+			++m_includeGenerations[path];
+		}
+	}
+
+	// include している側のファイルは内容が変わっていないため、スキップされないよう記録を取り除きます。
+	if (changedPaths.size() < affectedPaths.size())
+	{
+		const HashSet<FilePath> changed(changedPaths.begin(), changedPaths.end());
+
+		std::lock_guard lock{ m_fingerprintMutex };
+
+		for (const auto& path : affectedPaths)
+		{
+			if (not changed.contains(path))
+			{
+				m_fingerprints.erase(path);
+			}
+		}
+	}
+
+	return affectedPaths;
+}
+
+void ConfigParser::removeFile(const FilePath& path)
+{
+	m_dependencies.remove(path);
+
+	{
+		std::lock_guard lock{ m_includeMutex };
+		m_includeCache.erase(path);
+		++m_includeGenerations[path];
+	}
+
+	std::lock_guard lock{ m_fingerprintMutex };
+	m_fingerprints.erase(path);
+	m_unincludedFiles.erase(path);
+}
+
+void ConfigParser::reportUnincludedFiles()
+{
+	HashTable<FilePath, FilePath> unincludedFiles;
+	{
+		std::lock_guard lock{ m_fingerprintMutex };
+		unincludedFiles.swap(m_unincludedFiles);
+	}
+
+	for (const auto& [path, friendlyPath] : unincludedFiles)
+	{
+		if (FileSystem::Exists(path) && (not m_dependencies.isIncluded(path)))
+		{
+			Editor::ShowError(U"config ファイル`{}`: dataType がありません。"_fmt(friendlyPath));
+		}
+	}
+}
+
+const ConfigDependencyGraph& ConfigParser::dependencies() const noexcept
+{
+	return m_dependencies;
+}
+
+size_t ConfigParser::numSkippedReloads() const noexcept
+{
+	return m_numSkippedReloads;
+}
+
+std::unique_ptr<IConfig> ConfigParser::restoreFromCache(const FilePathView path, const FilePathView friendlyPath, const ConfigCache::Entry& entry, const FileFingerprint& fingerprint)
+{
+	std::unique_ptr<IConfig> pConfig;
+	{
+		const ReloadProfiler::StageTimer timer{ ReloadStage::Parse };
+		std::shared_lock lock{ m_parsersMutex };
+
+		// config の型の構成が保存したときと異なる場合は、古い形式のデータを読み込まないようキャッシュを使いません。
+		if (auto it = m_serializeFunctions.find(entry.dataType); ((it != m_serializeFunctions.end()) && (it->second.layoutHash == entry.layoutHash)))
+		{
+			pConfig = m_cache.load(path, entry, it->second.load);
+		}
+	}
+
+	if (not pConfig)
+	{
+		Editor::ShowWarning(U"config ファイル`{}`のキャッシュが使えないため JSON からパースします。"_fmt(friendlyPath));
+		return nullptr;
+	}
+
+	recordFingerprint(path, fingerprint);
+
+	// 更新日時だけが変わっていた場合はマニフェストを更新します。
+	if (not entry.fingerprint.hasSameStatus(fingerprint))
+	{
+		m_cache.updateEntry(path, { fingerprint, entry.dataType, entry.layoutHash });
+	}
+
+	Editor::ShowSuccess(U"config ファイル`{}`をキャッシュから復元しました（データタイプ`{}`）。"_fmt(friendlyPath, entry.dataType));
+	return pConfig;
+}
+
+std::unique_ptr<IConfig> ConfigParser::parseJSONContent(const Blob& blob, const FilePathView path, const FilePathView friendlyPath) const
+{
+	const FilePath fullPath{ path };
+	const bool mayHaveIncludes = MayHaveIncludes(blob);
+
+	bool hasStreamParsers = false;
+	{
+		std::shared_lock lock{ m_parsersMutex };
+		hasStreamParsers = (not m_jsonStreamParsers.empty());
+	}
+
+	// dataType だけを先に読み、ストリームパーサーが登録されていれば DOM を作らずにパースします。include は DOM で解決します。
+	if (const auto dataType = ((hasStreamParsers && (not mayHaveIncludes)) ? JSONStreamReader::PeekDataType(blob.data(), blob.size()) : none))
+	{
+		std::shared_lock lock{ m_parsersMutex };
+
+		if (auto it = m_jsonStreamParsers.find(*dataType); (it != m_jsonStreamParsers.end()))
+		{
+			m_dependencies.setIncludes(fullPath, {});
+
+			Editor::ShowInfo(U"config ファイル`{}`をストリームとしてパースします（データタイプ`{}`）。"_fmt(friendlyPath, *dataType));
+
+			const ReloadProfiler::StageTimer timer{ ReloadStage::Parse };
+
+			JSONStreamReader reader{ blob };
+
+			if (auto pConfig = ParseStream(it->second, reader))
+			{
+				Editor::ShowSuccess(U"データタイプ`{}`のパースに成功しました。"_fmt(*dataType));
+				return pConfig;
+			}
+
+			Editor::ShowError(U"データタイプ`{}`のパースに失敗しました。"_fmt(*dataType));
+			return nullptr;
+		}
+	}
+
+	// ファイルの内容から JSON をロードします。
+	JSON json;
+	{
+		const ReloadProfiler::StageTimer timer{ ReloadStage::Load };
+		json = LoadConfigJSON(blob, friendlyPath);
+	}
+
+	if (not json)
+	{
+		return nullptr;
+	}
+
+	// include したファイルのキーを既定値として加えます。
+	if (json.contains(U"include"))
+	{
+		const ReloadProfiler::StageTimer timer{ ReloadStage::Load };
+		Array<FilePath> chain{ fullPath };
+
+		auto resolved = resolveIncludes(json, fullPath, friendlyPath, chain);
+
+		if (not resolved)
+		{
+			return nullptr;
+		}
+
+		json = std::move(*resolved);
+	}
 	else
 	{
-		if (auto pConfig = it->second(json))
+		m_dependencies.setIncludes(fullPath, {});
+	}
+
+	// dataType の無いファイルは、他のファイルから include されている場合だけ共有ファイルとして扱います。
+	if (not json.contains(U"dataType"))
+	{
+		if (m_dependencies.isIncluded(fullPath))
 		{
-			Editor::ShowSuccess(U"データタイプ`{}`のパースに成功しました。"_fmt(dataType));
-			return pConfig;
+			if (Editor::IsVerbose())
+			{
+				Editor::ShowVerbose(U"config ファイル`{}`は dataType が無いため、include されるファイルとして扱います。"_fmt(friendlyPath));
+			}
 		}
 		else
 		{
-			Editor::ShowError(U"データタイプ`{}`のパースに失敗しました。"_fmt(dataType));
-			return nullptr;
+			// include しているファイルがまだパースされていない可能性があるため、全ての読み込みが終わってから判定します。
+			std::lock_guard lock{ m_fingerprintMutex };
+			m_unincludedFiles[fullPath] = FilePath{ friendlyPath };
+		}
+
+		return nullptr;
+	}
+
+	const Optional<String> dataType = GetDataType(json, friendlyPath);
+
+	if (not dataType)
+	{
+		return nullptr;
+	}
+
+	std::shared_lock lock{ m_parsersMutex };
+
+	const ReloadProfiler::StageTimer timer{ ReloadStage::Parse };
+
+	// ロードした JSON のデータタイプをもとにパーサーを呼び出します。
+	std::unique_ptr<IConfig> pConfig;
+
+	if (auto it = m_jsonParsers.find(*dataType); (it != m_jsonParsers.end()))
+	{
+		pConfig = it->second(json);
+	}
+	// ストリームパーサーしか無い場合は、include を解決した JSON を書き出してから渡します。
+	else if (auto streamIt = m_jsonStreamParsers.find(*dataType); (streamIt != m_jsonStreamParsers.end()))
+	{
+		const std::string text = json.formatUTF8Minimum();
+
+		JSONStreamReader reader{ text.data(), text.size() };
+		pConfig = ParseStream(streamIt->second, reader);
+	}
+	else
+	{
+		Editor::ShowError(U"データタイプ`{}`のパーサーが登録されていません。"_fmt(*dataType));
+		return nullptr;
+	}
+
+	if (not pConfig)
+	{
+		Editor::ShowError(U"データタイプ`{}`のパースに失敗しました。"_fmt(*dataType));
+		return nullptr;
+	}
+
+	Editor::ShowSuccess(U"データタイプ`{}`のパースに成功しました。"_fmt(*dataType));
+	return pConfig;
+}
+
+Optional<JSON> ConfigParser::resolveIncludes(const JSON& json, const FilePath& path, const FilePathView friendlyPath, Array<FilePath>& chain) const
+{
+	const JSON include = json[U"include"];
+	Array<String> names;
+
+	if (include.isString())
+	{
+		names << include.getString();
+	}
+	else if (include.isArray())
+	{
+		for (const auto& element : include.arrayView())
+		{
+			if (not element.isString())
+			{
+				Editor::ShowError(U"config ファイル`{}`: include が不正です。"_fmt(friendlyPath));
+				return none;
+			}
+
+			names << element.getString();
+		}
+	}
+	else
+	{
+		Editor::ShowError(U"config ファイル`{}`: include が不正です。"_fmt(friendlyPath));
+		return none;
+	}
+
+	const FilePath directory = FileSystem::ParentPath(path);
+
+	Array<FilePath> includes;
+
+	for (const auto& name : names)
+	{
+		includes << FileSystem::FullPath(directory + name);
+	}
+
+	// include したファイルが不正な場合でも、修正されたときに読み込み直せるよう先に記録します。
+	m_dependencies.setIncludes(path, includes);
+
+	// 後に書いたファイルのキーほど優先し、このファイル自身のキーを最も優先します。
+	JSON merged;
+
+	for (size_t i = 0; i < includes.size(); ++i)
+	{
+		const Optional<JSON> included = loadInclude(includes[i], chain);
+
+		if (not included)
+		{
+			Editor::ShowError(U"config ファイル`{}`: `{}`を include できませんでした。"_fmt(friendlyPath, names[i]));
+			return none;
+		}
+
+		MergeMembers(merged, *included);
+	}
+
+	MergeMembers(merged, json);
+
+	return merged;
+}
+
+Optional<JSON> ConfigParser::loadInclude(const FilePath& path, Array<FilePath>& chain) const
+{
+	const FilePath friendlyPath = FileSystem::RelativePath(path);
+
+	if (chain.contains(path))
+	{
+		Editor::ShowError(U"config ファイル`{}`の include が循環しています。"_fmt(friendlyPath));
+		return none;
+	}
+
+	// ファイルを読む前の世代です。読んでいる間に invalidate() された場合は、結果をキャッシュに保存しません。
+	uint64 generation = 0;
+	{
+		std::lock_guard lock{ m_includeMutex };
+
+		if (auto it = m_includeCache.find(path); (it != m_includeCache.end()))
+		{
+			return it->second;
+		}
+
+		generation = m_includeGenerations[path];
+	}
+
+	JSON json = JSON::Load(path);
+
+	if ((not json) || (not json.isObject()))
+	{
+		Editor::ShowError(U"include されたファイル`{}`のロードに失敗しました（ファイルが無いか、不正なJSON）。"_fmt(friendlyPath));
+		return none;
+	}
+
+	if (json.contains(U"include"))
+	{
+		chain << path;
+		auto resolved = resolveIncludes(json, path, friendlyPath, chain);
+		chain.pop_back();
+
+		if (not resolved)
+		{
+			return none;
+		}
+
+		json = std::move(*resolved);
+	}
+	else
+	{
+		m_dependencies.setIncludes(path, {});
+	}
+
+	std::lock_guard lock{ m_includeMutex };
+
+	if (m_includeGenerations[path] == generation)
+	{
+		m_includeCache[path] = json;
+	}
+
+	return json;
+}
+
+std::unique_ptr<IConfig> ConfigParser::parseTableContent(const Blob& blob, const StringView extension, const FilePathView friendlyPath, ThreadPool* threadPool) const
+{
+	// dataType の無い INI ファイルは、config ではない設定ファイルとして読み飛ばします。
+	if ((extension == U"ini") && (not TableText::PeekDataTypeINI(blob)))
+	{
+		if (Editor::IsVerbose())
+		{
+			Editor::ShowVerbose(U"INI ファイル`{}`は dataType が無いため、config ファイルとして扱いません。"_fmt(friendlyPath));
 		}
+
+		return nullptr;
+	}
+
+	Optional<TableText> table;
+	{
+		const ReloadProfiler::StageTimer timer{ ReloadStage::Load };
+		table = ((extension == U"csv") ? TableText::LoadCSV(blob) : TableText::LoadINI(blob));
+	}
+
+	if (not table)
+	{
+		Editor::ShowError(U"config ファイル`{}`のロードに失敗しました（不正な表、または dataType がありません）。"_fmt(friendlyPath));
+		return nullptr;
 	}
+
+	Editor::ShowSuccess(U"データタイプは`{}`です（{} 行）。"_fmt(table->dataType, table->numRows));
+
+	std::shared_lock lock{ m_parsersMutex };
+
+	auto it = m_tableParsers.find(table->dataType);
+
+	if (it == m_tableParsers.end())
+	{
+		Editor::ShowError(U"データタイプ`{}`のパーサーが登録されていません。"_fmt(table->dataType));
+		return nullptr;
+	}
+
+	const ReloadProfiler::StageTimer timer{ ReloadStage::Parse };
+
+	if (auto pConfig = it->second(*table, threadPool))
+	{
+		Editor::ShowSuccess(U"データタイプ`{}`のパースに成功しました。"_fmt(table->dataType));
+		return pConfig;
+	}
+
+	Editor::ShowError(U"データタイプ`{}`のパースに失敗しました（必要な列が無いか、変換できないセルがあります）。"_fmt(table->dataType));
+	return nullptr;
+}
+
+void ConfigParser::saveToCache(const FilePathView path, const FileFingerprint& fingerprint, const IConfig& config)
+{
+	if (not m_cache.isEnabled())
+	{
+		return;
+	}
+
+	std::shared_lock lock{ m_parsersMutex };
+
+	if (auto it = m_serializeFunctions.find(config.dataType()); (it != m_serializeFunctions.end()))
+	{
+		const auto& save = it->second.save;
+		m_cache.save(path, { fingerprint, String{ config.dataType() }, it->second.layoutHash }, [&](Serializer<BinaryWriter>& writer) { save(writer, config); });
+	}
+}
+
+void ConfigParser::recordFingerprint(const FilePathView path, const FileFingerprint& fingerprint)
+{
+	std::lock_guard lock{ m_fingerprintMutex };
+	m_fingerprints[path] = fingerprint;
+	m_unincludedFiles.erase(path);
 }
@@ -1,6 +1,22 @@
 ﻿# pragma once
 # include <Siv3D.hpp>
 # include "IConfig.hpp"
+# include "JSONStreamReader.hpp"
+# include "TableConfig.hpp"
+# include <shared_mutex>
+# include "ConfigCache.hpp"
+# include "ConfigDependencyGraph.hpp"
+# include "ThreadPool.hpp"
+
+/// @brief bundle に格納するためにシリアライズされた config です。
+struct BakedConfig
+{
+	/// @brief データタイプ
+	String dataType;
+
+	/// @brief シリアライズされた config
+	Blob data;
+};
 
 class ConfigParser
 {
@@ -12,14 +28,299 @@ public:
 	/// @param parser パースする関数です。
 	void addJSONParser(StringView dataType, std::function<std::unique_ptr<IConfig>(const JSON&)> parser);
 
+	/// @brief ConfigType::DataType の JSON パーサーとして ConfigType::Parse を追加します。
+	/// @tparam ConfigType SIV3D_SERIALIZE を持つ場合、パース結果がキャッシュに保存され、bundle に格納できるようになります。
+	/// @remark 型のサイズか Schema() のフィールドの構成が変わると、以前のキャッシュは使われません。既定値や Parse の処理を変えた場合は、static constexpr uint32 CacheVersion を定義して増やしてください。
+	template <class ConfigType>
+	void addJSONParser();
+
+	/// @brief JSON ファイルを DOM を作らずにパースするパーサーを追加します。
+	/// @param dataType 追加するパーサーのデータタイプです。
+	/// @param parser パースする関数です。最上位のオブジェクトの先頭のトークン（`{`）を指している JSONStreamReader を受け取り、最上位のオブジェクトの終わりのトークン（`}`）まで読み進めて返します。
+	/// @remark 同じデータタイプの JSON パーサーより優先して使われます。最上位のオブジェクトの後ろに空白以外がある場合は、パースに失敗したものとします。
+	void addJSONStreamParser(StringView dataType, std::function<std::unique_ptr<IConfig>(JSONStreamReader&)> parser);
+
+	/// @brief ConfigType::DataType のストリームパーサーとして ConfigType::Schema() を使うパーサーを追加します。
+	/// @tparam ConfigType Schema() を持つ必要があります。SIV3D_SERIALIZE を持つ場合、パース結果がキャッシュに保存され、bundle に格納できるようになります。
+	template <class ConfigType>
+	void addJSONStreamParser();
+
+	/// @brief CSV または INI の表のパーサーを追加します。
+	/// @param dataType 追加するパーサーのデータタイプです。
+	/// @param parser パースする関数です。表と、変換に使えるスレッドプール（nullptr の場合があります）を受け取ります。
+	void addTableParser(StringView dataType, std::function<std::unique_ptr<IConfig>(const TableText&, ThreadPool*)> parser);
+
+	/// @brief ConfigType::DataType の表のパーサーとして ConfigType::Schema() を使うパーサーを追加します。
+	/// @tparam ConfigType TableSchema を返す Schema() を持つ必要があります。SIV3D_SERIALIZE を持つ場合、パース結果がキャッシュに保存され、bundle に格納できるようになります。
+	template <class ConfigType>
+	void addTableParser();
+
+	/// @brief 拡張子が表の config ファイル（csv, ini）のものかを返します。
+	/// @param extension 小文字の拡張子
+	[[nodiscard]]
+	static bool IsTableExtension(StringView extension) noexcept;
+
+	/// @brief パースに成功した config をキャッシュし、次回の起動時に内容が変わっていないファイルをキャッシュから復元します。
+	/// @param directory キャッシュを保存するディレクトリです。監視している config ディレクトリの外を指定してください。
+	/// @return キャッシュを有効にできた場合 true, それ以外の場合は false
+	bool enableCache(FilePathView directory);
+
 	/// @brief path から JSON をパースします。
-	/// @param path JSON ファイルの絶対パスです。
+	/// @param path JSON ファイルの絶対パスです。`"include": "shared/palette.json"`（または相対パスの配列）があれば、include したファイルのキーを既定値として読み込みます。
 	/// @param friendlyPath JSON ファイルの相対パスです。
-	/// @return JSON からパースされたデータです。パースに失敗した場合は nullptr を返します。
+	/// @return JSON からパースされたデータです。パースに失敗した場合、または前回パースに成功したときから内容が変わっていない場合は nullptr を返します。
+	/// @remark 異なるファイルであれば複数のスレッドから同時に呼び出せます。
 	[[nodiscard]]
 	std::unique_ptr<IConfig> parseJSON(FilePathView path, FilePathView friendlyPath);
 
+	/// @brief path から CSV または INI の表をパースします。
+	/// @param path 表のファイルの絶対パスです。拡張子で形式を判断します。
+	/// @param friendlyPath 表のファイルの相対パスです。
+	/// @param threadPool セルの変換に使うスレッドプールです。nullptr の場合は呼び出したスレッドだけで変換します。
+	/// @return 表からパースされたデータです。パースに失敗した場合、または前回パースに成功したときから内容が変わっていない場合は nullptr を返します。
+	/// @remark 異なるファイルであれば複数のスレッドから同時に呼び出せます。
+	[[nodiscard]]
+	std::unique_ptr<IConfig> parseTable(FilePathView path, FilePathView friendlyPath, ThreadPool* threadPool = nullptr);
+
+	/// @brief 複数の JSON ファイルをスレッドプールで並列にパースします。
+	/// @param paths JSON ファイルの絶対パスです。同じパスを複数含めないでください。
+	/// @param threadPool パースに使うスレッドプールです。呼び出したスレッドも処理に加わります。
+	/// @return paths と同じ順番に並んだ、各ファイルの parseJSON() の結果です。
+	[[nodiscard]]
+	Array<std::unique_ptr<IConfig>> parseJSONBatch(const Array<FilePath>& paths, ThreadPool& threadPool);
+
+	/// @brief JSON または表のファイルをパースし、bundle に格納するためにシリアライズします。
+	/// @param path config ファイルの絶対パスです。
+	/// @param friendlyPath config ファイルの相対パスです。
+	/// @return シリアライズされた config。パースに失敗したか、データタイプが SIV3D_SERIALIZE を持たない場合は none
+	/// @remark parseJSON() と異なり、ファイルの内容が変わっていなくても必ずパースします。
+	[[nodiscard]]
+	Optional<BakedConfig> bakeFile(FilePathView path, FilePathView friendlyPath) const;
+
+	/// @brief bundle に格納された config を復元します。
+	/// @param dataType データタイプ
+	/// @param data シリアライズされた config の先頭です。
+	/// @param size シリアライズされた config のサイズ（バイト）です。
+	/// @return 復元した config。データタイプが登録されていないか、データが壊れている場合は nullptr
+	[[nodiscard]]
+	std::unique_ptr<IConfig> loadBaked(StringView dataType, const void* data, size_t size) const;
+
+	/// @brief config ファイルをパースせずに、データタイプだけを読みます。
+	/// @param path config ファイルの絶対パスです。
+	/// @return データタイプ。dataType が無いか、拡張子が config ファイルのものでない場合は none
+	/// @remark キャッシュのサイズと更新日時が一致する場合はファイルを読みません。それ以外の場合は、まずファイルの先頭だけを読みます。
+	/// include したファイルから dataType を受け継ぐ JSON ファイルのデータタイプは読めません。
+	[[nodiscard]]
+	Optional<String> peekDataType(FilePathView path) const;
+
+	/// @brief 変更されたファイルと、それらを直接または間接に include している config ファイルを、パースし直す順番に返します。
+	/// @param changedPaths 変更されたファイルの絶対パスです。
+	/// @return include されているファイルが先に来るトポロジカル順に並べたファイルの絶対パスです。
+	/// @remark 返した config ファイルは、内容が変わっていなくても次の parseJSON() でパースし直します。
+	[[nodiscard]]
+	Array<FilePath> invalidate(const Array<FilePath>& changedPaths);
+
+	/// @brief 削除されたファイルの記録を取り除きます。
+	/// @param path 削除されたファイルの絶対パスです。
+	void removeFile(const FilePath& path);
+
+	/// @brief dataType が無く、どの config ファイルからも include されていないファイルをエラーとして通知します。
+	/// @remark include しているファイルが後からパースされる場合があるため、全ての config ファイルを読み終えてから呼び出します。
+	void reportUnincludedFiles();
+
+	/// @brief config ファイル同士の include の関係を返します。
+	[[nodiscard]]
+	const ConfigDependencyGraph& dependencies() const noexcept;
+
+	/// @brief 内容が変わっていないためにパースをスキップした回数を返します。
+	/// @return パースをスキップした回数
+	[[nodiscard]]
+	size_t numSkippedReloads() const noexcept;
+
 private:
+	/// @brief config をキャッシュと bundle に読み書きする関数です。
+	struct SerializeFunctions
+	{
+		std::function<void(Serializer<BinaryWriter>&, const IConfig&)> save;
+
+		std::function<std::unique_ptr<IConfig>(Deserializer<BinaryReader>&)> load;
+
+		std::function<void(Serializer<MemoryWriter>&, const IConfig&)> bake;
+
+		std::function<std::unique_ptr<IConfig>(Deserializer<MemoryViewReader>&)> loadBaked;
+
+		/// @brief 型の構成のハッシュ値です。キャッシュを保存したときと異なる場合は、キャッシュを使いません。
+		uint64 layoutHash = 0;
+	};
+
+	/// @brief config の型の構成のハッシュ値を計算します。
+	/// @tparam ConfigType config の型
+	/// @return 型のサイズ、Schema() のフィールドの構成、ConfigType::CacheVersion（ある場合）から計算したハッシュ値
+	template <class ConfigType>
+	[[nodiscard]]
+	static uint64 LayoutHash();
+
+	/// @brief SIV3D_SERIALIZE を持つ ConfigType の、キャッシュと bundle に読み書きする関数を登録します。
+	template <class ConfigType>
+	void addSerializeFunctions();
+
+	/// @brief ファイルの内容を JSON としてロードし、データタイプに対応するパーサーでパースします。
+	/// @remark include が無く、データタイプにストリームパーサーが登録されている場合は、DOM を作らずにパースします。
+	/// @return パースされたデータ。失敗した場合は nullptr
+	[[nodiscard]]
+	std::unique_ptr<IConfig> parseJSONContent(const Blob& blob, FilePathView path, FilePathView friendlyPath) const;
+
+	/// @brief JSON の include を解決し、include したファイルのキーを既定値として加えた JSON を返します。
+	/// @param json include を持つ JSON
+	/// @param path JSON ファイルの絶対パスです。include のパスはこのファイルのディレクトリからの相対パスです。
+	/// @param friendlyPath JSON ファイルの相対パスです。
+	/// @param chain include を辿っている途中のファイルです。循環の検出に使います。
+	/// @return include を解決した JSON。include したファイルが無いか不正な場合は none
+	[[nodiscard]]
+	Optional<JSON> resolveIncludes(const JSON& json, const FilePath& path, FilePathView friendlyPath, Array<FilePath>& chain) const;
+
+	/// @brief include されるファイルをロードし、そのファイルの include も解決します。
+	/// @remark 解決した JSON は、ファイルが変更されるまで m_includeCache に保持します。
+	[[nodiscard]]
+	Optional<JSON> loadInclude(const FilePath& path, Array<FilePath>& chain) const;
+
+	/// @brief ファイルの内容を CSV または INI の表としてロードし、データタイプに対応するパーサーでパースします。
+	/// @return パースされたデータ。失敗した場合は nullptr
+	[[nodiscard]]
+	std::unique_ptr<IConfig> parseTableContent(const Blob& blob, StringView extension, FilePathView friendlyPath, ThreadPool* threadPool) const;
+
+	/// @brief ファイルの内容が変わっていなければスキップし、キャッシュが使えれば復元し、それ以外の場合は parseContent でパースします。
+	/// @return パースされたデータ。失敗した場合、またはスキップした場合は nullptr
+	[[nodiscard]]
+	std::unique_ptr<IConfig> parseFile(FilePathView path, FilePathView friendlyPath, const std::function<std::unique_ptr<IConfig>(const Blob&)>& parseContent);
+
+	/// @brief パースした config をキャッシュに保存します。
+	void saveToCache(FilePathView path, const FileFingerprint& fingerprint, const IConfig& config);
+
+	/// @brief キャッシュから config を復元します。
+	/// @return 復元した config。キャッシュが使えない場合は nullptr
+	[[nodiscard]]
+	std::unique_ptr<IConfig> restoreFromCache(FilePathView path, FilePathView friendlyPath, const ConfigCache::Entry& entry, const FileFingerprint& fingerprint);
+
+	/// @brief パースに成功したファイルの情報を記録します。
+	void recordFingerprint(FilePathView path, const FileFingerprint& fingerprint);
+
+	/// @brief パーサーのマップと m_serializeFunctions を保護するミューテックスです。パース中は共有ロックを取ります。
+	mutable std::shared_mutex m_parsersMutex;
+
 	/// @brief dataType と　JSON パーサーのマップです。
 	HashTable<String, std::function<std::unique_ptr<IConfig>(const JSON&)>> m_jsonParsers;
+
+	/// @brief dataType と JSON ストリームパーサーのマップです。
+	HashTable<String, std::function<std::unique_ptr<IConfig>(JSONStreamReader&)>> m_jsonStreamParsers;
+
+	/// @brief dataType と表のパーサーのマップです。
+	HashTable<String, std::function<std::unique_ptr<IConfig>(const TableText&, ThreadPool*)>> m_tableParsers;
+
+	/// @brief dataType と、キャッシュと bundle に読み書きする関数のマップです。
+	HashTable<String, SerializeFunctions> m_serializeFunctions;
+
+	/// @brief パース結果のキャッシュ
+	ConfigCache m_cache;
+
+	/// @brief config ファイル同士の include の関係
+	mutable ConfigDependencyGraph m_dependencies;
+
+	/// @brief m_includeCache と m_includeGenerations を保護するミューテックス
+	mutable std::mutex m_includeMutex;
+
+	/// @brief include されたファイルの絶対パスと、include を解決した JSON のマップです。
+	mutable HashTable<FilePath, JSON> m_includeCache;
+
+	/// @brief include されたファイルの絶対パスと、invalidate() で進む世代です。読み込みの開始から世代が変わっていない場合だけ m_includeCache に保存します。
+	mutable HashTable<FilePath, uint64> m_includeGenerations;
+
+	/// @brief m_fingerprints と m_unincludedFiles を保護するミューテックス
+	mutable std::mutex m_fingerprintMutex;
+
+	/// @brief ファイルパスと、最後にパースに成功したときのファイルの情報です。
+	HashTable<FilePath, FileFingerprint> m_fingerprints;
+
+	/// @brief dataType が無く、パースしたときにどのファイルからも include されていなかったファイルの絶対パスと相対パスです。
+	mutable HashTable<FilePath, FilePath> m_unincludedFiles;
+
+	/// @brief 内容が変わっていないためにパースをスキップした回数
+	std::atomic<size_t> m_numSkippedReloads = 0;
 };
+
+template <class ConfigType>
+void ConfigParser::addJSONParser()
+{
+	addJSONParser(ConfigType::DataType, &ConfigType::Parse);
+	addSerializeFunctions<ConfigType>();
+}
+
+template <class ConfigType>
+void ConfigParser::addJSONStreamParser()
+{
+	addJSONStreamParser(ConfigType::DataType, [](JSONStreamReader& reader) -> std::unique_ptr<IConfig>
+		{
+			return ConfigType::Schema().parse(reader);
+		});
+	addSerializeFunctions<ConfigType>();
+}
+
+template <class ConfigType>
+void ConfigParser::addTableParser()
+{
+	addTableParser(ConfigType::DataType, [](const TableText& table, ThreadPool* threadPool) -> std::unique_ptr<IConfig>
+		{
+			return ConfigType::Schema().parse(table, threadPool);
+		});
+	addSerializeFunctions<ConfigType>();
+}
+
+template <class ConfigType>
+void ConfigParser::addSerializeFunctions()
+{
+	if constexpr (requires (ConfigType& config, Serializer<BinaryWriter>& writer) { config.SIV3D_SERIALIZE(writer); })
+	{
+		std::lock_guard lock{ m_parsersMutex };
+		m_serializeFunctions[ConfigType::DataType] = SerializeFunctions{
+			.save = [](Serializer<BinaryWriter>& writer, const IConfig& config)
+			{
+				writer(static_cast<const ConfigType&>(config));
+			},
+			.load = [](Deserializer<BinaryReader>& reader) -> std::unique_ptr<IConfig>
+			{
+				auto pConfig = std::make_unique<ConfigType>();
+				reader(*pConfig);
+				return pConfig;
+			},
+			.bake = [](Serializer<MemoryWriter>& writer, const IConfig& config)
+			{
+				writer(static_cast<const ConfigType&>(config));
+			},
+			.loadBaked = [](Deserializer<MemoryViewReader>& reader) -> std::unique_ptr<IConfig>
+			{
+				auto pConfig = std::make_unique<ConfigType>();
+				reader(*pConfig);
+				return pConfig;
+			},
+			.layoutHash = LayoutHash<ConfigType>() };
+	}
+}
+
+template <class ConfigType>
+uint64 ConfigParser::LayoutHash()
+{
+	String layout = U"{}/{}"_fmt(ConfigType::DataType, sizeof(ConfigType));
+
+	// 既定値やパースの処理はフィールドの構成から分からないため、変えた場合は型に CacheVersion を定義して増やします。
+	if constexpr (requires { ConfigType::CacheVersion; })
+	{
+		layout += U"/v{}"_fmt(ConfigType::CacheVersion);
+	}
+
+	if constexpr (requires { ConfigType::Schema().signature(); })
+	{
+		layout += ConfigType::Schema().signature();
+	}
+
+	return FileFingerprint::HashContent(layout.data(), (layout.size() * sizeof(char32)));
+}
@@ -0,0 +1,264 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include "JSONParser.hpp"
+# include "SchemaDiff.hpp"
+
+/// @brief config のフィールドの宣言です。JSON のキーと、値を格納するメンバ変数を結び付けます。
+/// @tparam ConfigType config の型
+/// @tparam ValueType メンバ変数の型です。int32, double, Vec2, ColorF, String, bool, Array<double>, Array<Vec2>, Array<ColorF> のいずれかです。
+template <class ConfigType, class ValueType>
+struct ConfigField
+{
+	/// @brief JSON のキー
+	StringView name;
+
+	/// @brief 値を格納するメンバ変数
+	ValueType ConfigType::* member;
+
+	/// @brief JSON にキーが無い場合にパースを失敗とするか。false の場合はメンバ変数の初期値のままになります。
+	bool required = true;
+};
+
+/// @brief config のフィールドをまとめた宣言です。JSON オブジェクト、または JSONStreamReader を 1 回走査するだけで config を埋めます。
+/// @tparam ConfigType config の型
+/// @tparam ValueTypes 各フィールドのメンバ変数の型
+/// @remark 以下のように constexpr で宣言します。
+/// @code
+/// [[nodiscard]]
+/// static constexpr auto Schema()
+/// {
+///		return ConfigSchema{ ConfigField{ U"center", &CircleObject::center }, ConfigField{ U"radius", &CircleObject::radius } };
+/// }
+/// @endcode
+template <class ConfigType, class... ValueTypes>
+class ConfigSchema
+{
+public:
+	/// @brief フィールドの数
+	static constexpr size_t NumFields = sizeof...(ValueTypes);
+
+	static_assert((NumFields <= 64), "ConfigSchema supports up to 64 fields");
+
+	constexpr explicit ConfigSchema(const ConfigField<ConfigType, ValueTypes>&... fields) noexcept
+		: m_fields{ fields... } {}
+
+	/// @brief JSON オブジェクトを走査し、キーに対応するフィールドを config に書き込みます。
+	/// @param json config の JSON オブジェクト
+	/// @param config 書き込む config
+	/// @return 全ての required なフィールドを読み込めた場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool read(const JSON& json, ConfigType& config) const
+	{
+		if (not json.isObject())
+		{
+			return false;
+		}
+
+		std::array<bool, NumFields> found{};
+
+		for (const auto& object : json)
+		{
+			// 値の形式が不正な場合は、その場で失敗とします。
+			if (const size_t index = indexOf(object.key); ((index < NumFields) && (not readFieldAt(index, object.value, config, found))))
+			{
+				return false;
+			}
+		}
+
+		return isComplete(found, std::index_sequence_for<ValueTypes...>{});
+	}
+
+	/// @brief JSONStreamReader からオブジェクトを読み込み、キーに対応するフィールドを config に書き込みます。
+	/// @param reader オブジェクトの先頭のトークン（`{`）を指している JSONStreamReader です。オブジェクトの最後のトークンまで読み進めます。
+	/// @param config 書き込む config
+	/// @return 全ての required なフィールドを読み込めた場合 true, それ以外の場合は false
+	/// @remark フィールドに対応しないキーの値は読み飛ばします。
+	[[nodiscard]]
+	bool read(JSONStreamReader& reader, ConfigType& config) const
+	{
+		using Token = JSONStreamReader::Token;
+
+		if (reader.token() != Token::BeginObject)
+		{
+			return false;
+		}
+
+		std::array<bool, NumFields> found{};
+
+		while (reader.next() == Token::Key)
+		{
+			const size_t index = indexOf(reader);
+			reader.next();
+
+			if (index < NumFields)
+			{
+				if (not readFieldAt(index, reader, config, found))
+				{
+					return false;
+				}
+			}
+			else if (not reader.skipValue())
+			{
+				return false;
+			}
+		}
+
+		return ((reader.token() == Token::EndObject) && isComplete(found, std::index_sequence_for<ValueTypes...>{}));
+	}
+
+	/// @brief JSON オブジェクトから config を作成します。
+	/// @param json config の JSON オブジェクト
+	/// @return 作成した config。失敗した場合は nullptr
+	[[nodiscard]]
+	std::unique_ptr<ConfigType> parse(const JSON& json) const
+	{
+		auto pConfig = std::make_unique<ConfigType>();
+
+		if (not read(json, *pConfig))
+		{
+			return nullptr;
+		}
+
+		return pConfig;
+	}
+
+	/// @brief JSONStreamReader から config を作成します。
+	/// @param reader オブジェクトの先頭のトークン（`{`）を指している JSONStreamReader です。
+	/// @return 作成した config。失敗した場合は nullptr
+	[[nodiscard]]
+	std::unique_ptr<ConfigType> parse(JSONStreamReader& reader) const
+	{
+		auto pConfig = std::make_unique<ConfigType>();
+
+		if (not read(reader, *pConfig))
+		{
+			return nullptr;
+		}
+
+		return pConfig;
+	}
+
+	/// @brief 2 つの config をフィールドごとに比較します。
+	/// @param a 比較する config
+	/// @param b 比較する config
+	/// @return 値が異なるフィールドのビットマスクです。i 番目のフィールドが異なる場合、i 番目のビットが 1 になります。
+	[[nodiscard]]
+	uint64 diff(const ConfigType& a, const ConfigType& b) const
+	{
+		return SchemaDiff::Diff(m_fields, a, b);
+	}
+
+	/// @brief メンバ変数に対応するフィールドのビットマスクを返します。
+	/// @param member メンバ変数
+	/// @return フィールドのビットマスク。スキーマに含まれないメンバ変数の場合は 0
+	template <class ValueType>
+	[[nodiscard]]
+	constexpr uint64 fieldMask(ValueType ConfigType::* member) const noexcept
+	{
+		return SchemaDiff::FieldMask(m_fields, member);
+	}
+
+	/// @brief フィールドの構成を表す文字列を返します。
+	/// @return フィールドの名前、メンバ変数の型、required を並べた文字列
+	[[nodiscard]]
+	String signature() const
+	{
+		return SchemaDiff::Signature(m_fields);
+	}
+
+	/// @brief フィールドの宣言を返します。
+	[[nodiscard]]
+	constexpr const std::tuple<ConfigField<ConfigType, ValueTypes>...>& fields() const noexcept
+	{
+		return m_fields;
+	}
+
+private:
+
+	std::tuple<ConfigField<ConfigType, ValueTypes>...> m_fields;
+
+	/// @brief キーに一致する最初のフィールドのインデックスを返します。
+	/// @param key JSON のキー、またはキーを指している JSONStreamReader
+	/// @return フィールドのインデックス。一致するフィールドが無い場合は NumFields
+	template <class Key>
+	[[nodiscard]]
+	size_t indexOf(const Key& key) const
+	{
+		return indexOf(key, std::index_sequence_for<ValueTypes...>{});
+	}
+
+	template <class Key, size_t... Indices>
+	[[nodiscard]]
+	size_t indexOf(const Key& key, std::index_sequence<Indices...>) const
+	{
+		size_t index = NumFields;
+		(void)((IsSameKey(std::get<Indices>(m_fields).name, key) && ((index = Indices), true)) || ...);
+		return index;
+	}
+
+	[[nodiscard]]
+	static bool IsSameKey(const StringView name, const StringView key) noexcept
+	{
+		return (name == key);
+	}
+
+	/// @brief JSONStreamReader のキーと比較します。フィールド名は ASCII である必要があります。
+	[[nodiscard]]
+	static bool IsSameKey(const StringView name, const JSONStreamReader& reader)
+	{
+		std::array<char, 64> ascii{};
+
+		if (ascii.size() < name.size())
+		{
+			return (reader.getString() == name);
+		}
+
+		for (size_t i = 0; i < name.size(); ++i)
+		{
+			ascii[i] = static_cast<char>(name[i]);
+		}
+
+		return reader.equals(std::string_view{ ascii.data(), name.size() });
+	}
+
+	/// @brief インデックスのフィールドに値を書き込みます。
+	/// @return 値を書き込めた場合 true, 値の形式が不正な場合は false
+	template <class Source>
+	[[nodiscard]]
+	bool readFieldAt(const size_t index, Source& value, ConfigType& config, std::array<bool, NumFields>& found) const
+	{
+		return readFieldAt(index, value, config, found, std::index_sequence_for<ValueTypes...>{});
+	}
+
+	template <class Source, size_t... Indices>
+	[[nodiscard]]
+	bool readFieldAt(const size_t index, Source& value, ConfigType& config, std::array<bool, NumFields>& found, std::index_sequence<Indices...>) const
+	{
+		bool succeeded = false;
+		(void)(((index == Indices) && ((succeeded = readField<Indices>(value, config)), (found[Indices] = succeeded), true)) || ...);
+		return succeeded;
+	}
+
+	template <size_t Index, class Source>
+	[[nodiscard]]
+	bool readField(Source& value, ConfigType& config) const
+	{
+		const auto& field = std::get<Index>(m_fields);
+		using ValueType = std::remove_cvref_t<decltype(config.*(field.member))>;
+
+		if (auto decoded = JSONParser::Decode<ValueType>(value))
+		{
+			config.*(field.member) = std::move(*decoded);
+			return true;
+		}
+
+		return false;
+	}
+
+	template <size_t... Indices>
+	[[nodiscard]]
+	bool isComplete(const std::array<bool, NumFields>& found, std::index_sequence<Indices...>) const noexcept
+	{
+		return ((found[Indices] || (not std::get<Indices>(m_fields).required)) && ...);
+	}
+};
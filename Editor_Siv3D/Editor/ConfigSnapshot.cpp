@@ -0,0 +1,16 @@
+﻿# include "ConfigSnapshot.hpp"
+
+uint64 ConfigSnapshot::generation() const noexcept
+{
+	return m_generation;
+}
+
+size_t ConfigSnapshot::size() const noexcept
+{
+	return m_entries.size();
+}
+
+const Array<std::shared_ptr<const IConfig>>* ConfigSnapshot::configsOf(const uint32 typeIndex) const noexcept
+{
+	return ((typeIndex < m_configsByType.size()) ? &m_configsByType[typeIndex] : nullptr);
+}
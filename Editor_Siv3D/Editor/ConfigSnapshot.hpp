@@ -0,0 +1,102 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include "IConfig.hpp"
+# include "ConfigTypeID.hpp"
+
+class ConfigArena;
+
+/// @brief ある時点で ConfigStore に格納されていた config の、変更されない写しです。
+/// @remark ConfigStore::publish() で作成され、ConfigStore::snapshot() で任意のスレッドから取得できます。
+/// 変更されていない config は前の世代と共有するため、publish() では変更された config だけがコピーされます。
+class ConfigSnapshot
+{
+public:
+	ConfigSnapshot() = default;
+
+	/// @brief 世代を返します。publish() で config が変更されるたびに 1 ずつ増えます。
+	/// @return 世代。まだ publish() されていない場合は 0
+	[[nodiscard]]
+	uint64 generation() const noexcept;
+
+	/// @brief 格納している config の数を返します。
+	[[nodiscard]]
+	size_t size() const noexcept;
+
+	/// @brief キーに対応する config を返します。
+	/// @tparam ConfigType config の型
+	/// @param key config のキー
+	/// @return config へのポインタです。スナップショットを保持している間は有効です。キーが無いか、型が異なる場合は nullptr
+	template <class ConfigType>
+	[[nodiscard]]
+	const ConfigType* find(StringView key) const
+	{
+		if (auto it = m_entries.find(key); ((it != m_entries.end()) && (it->second.typeIndex == ConfigTypeIndex<ConfigType>)))
+		{
+			return static_cast<const ConfigType*>(it->second.config.get());
+		}
+
+		return nullptr;
+	}
+
+	/// @brief データタイプの config を 1 つ返します。
+	/// @tparam ConfigType config の型
+	/// @return config へのポインタです。スナップショットを保持している間は有効です。格納されていない場合は nullptr
+	/// @remark 公開した時点で GetConfig() が返す config と同じものを返します。
+	template <class ConfigType>
+	[[nodiscard]]
+	const ConfigType* front() const
+	{
+		if (const auto* configs = configsOf(ConfigTypeIndex<ConfigType>); (configs && (*configs)))
+		{
+			return static_cast<const ConfigType*>(configs->front().get());
+		}
+
+		return nullptr;
+	}
+
+	/// @brief データタイプの全ての config について関数を呼びます。
+	/// @tparam ConfigType config の型
+	/// @param function config を受け取る関数
+	template <class ConfigType, class Function>
+	void forEach(Function&& function) const
+	{
+		if (const auto* configs = configsOf(ConfigTypeIndex<ConfigType>))
+		{
+			for (const auto& config : *configs)
+			{
+				function(static_cast<const ConfigType&>(*config));
+			}
+		}
+	}
+
+private:
+
+	friend class ConfigStore;
+
+	/// @brief 格納している config
+	struct Entry
+	{
+		/// @brief config の型のインデックス
+		uint32 typeIndex = 0;
+
+		/// @brief config（前後の世代と共有します）
+		std::shared_ptr<const IConfig> config;
+
+		/// @brief config を確保した領域（ConfigStore が、領域ごとに参照されている config を数えるために使います）
+		const ConfigArena* arena = nullptr;
+	};
+
+	/// @brief 型のインデックスに対応する config の配列を返します。
+	/// @return config の配列。型が登録されていない場合は nullptr
+	[[nodiscard]]
+	const Array<std::shared_ptr<const IConfig>>* configsOf(uint32 typeIndex) const noexcept;
+
+	/// @brief 世代
+	uint64 m_generation = 0;
+
+	/// @brief キーと config
+	HashTable<String, Entry> m_entries;
+
+	/// @brief 型のインデックスごとの config（ConfigPool に格納されている順）
+	Array<Array<std::shared_ptr<const IConfig>>> m_configsByType;
+};
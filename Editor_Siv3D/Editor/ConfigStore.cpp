@@ -0,0 +1,360 @@
+﻿# include "ConfigStore.hpp"
+# include "Editor.hpp"
+# include "ReloadProfiler.hpp"
+
+ConfigStore::ConfigStore()
+	: m_snapshot{ std::make_shared<const ConfigSnapshot>() } {}
+
+bool ConfigStore::addPool(const uint32 typeIndex, std::unique_ptr<IConfigPool> pool)
+{
+	// 登録済みの格納先を指したまま新しい格納先を破棄しないよう、どこにも記録する前に確認します。
+	if (m_pools.contains(pool->dataType()))
+	{
+		Editor::ShowError(U"データタイプ`{}`は ConfigStore に登録済みです。"_fmt(pool->dataType()));
+		return false;
+	}
+
+	if (m_poolsByTypeIndex.size() <= typeIndex)
+	{
+		m_poolsByTypeIndex.resize(typeIndex + 1, nullptr);
+	}
+
+	m_poolsByTypeIndex[typeIndex] = pool.get();
+	m_pools.emplace(String{ pool->dataType() }, std::move(pool));
+	return true;
+}
+
+bool ConfigStore::insertOrAssign(const String& key, std::unique_ptr<IConfig> config)
+{
+	auto it = m_pools.find(config->dataType());
+
+	if (it == m_pools.end())
+	{
+		Editor::ShowError(U"データタイプ`{}`は ConfigStore に登録されていません。"_fmt(config->dataType()));
+		return false;
+	}
+
+	IConfigPool* pool = it->second.get();
+
+	// 同じ DataType を持つ別の型の config を、格納先の型として扱わないよう確認します。
+	if (not pool->accepts(*config))
+	{
+		Editor::ShowError(U"データタイプ`{}`の config の型が、ConfigStore に登録された型と一致しません。"_fmt(config->dataType()));
+		return false;
+	}
+
+	// まだパースしていなかった config は、パースが済んだものとして記録を取り除きます。
+	if (auto deferredIt = m_deferredKeys.find(key); (deferredIt != m_deferredKeys.end()))
+	{
+		deferredIt->second->setNumDeferred(deferredIt->second->numDeferred() - 1);
+		m_deferredKeys.erase(deferredIt);
+	}
+
+	// 同じファイルのデータタイプが変わった場合は、元の格納先から削除します。
+	if (auto keyIt = m_keyToPool.find(key); (keyIt != m_keyToPool.end()))
+	{
+		if (keyIt->second != pool)
+		{
+			keyIt->second->erase(key);
+			keyIt->second = pool;
+		}
+	}
+	else
+	{
+		m_keyToPool.emplace(key, pool);
+	}
+
+	pool->insertOrAssign(key, std::move(*config));
+	m_unpublishedKeys.emplace(key);
+	return true;
+}
+
+bool ConfigStore::erase(const String& key)
+{
+	// まだパースしていない config は公開されていないため、記録を取り除くだけです。
+	if (auto it = m_deferredKeys.find(key); (it != m_deferredKeys.end()))
+	{
+		it->second->setNumDeferred(it->second->numDeferred() - 1);
+		m_deferredKeys.erase(it);
+		return true;
+	}
+
+	if (auto it = m_keyToPool.find(key); (it != m_keyToPool.end()))
+	{
+		it->second->erase(key);
+		m_keyToPool.erase(it);
+		m_unpublishedKeys.emplace(key);
+		return true;
+	}
+
+	return false;
+}
+
+bool ConfigStore::defer(const String& key, const StringView dataType)
+{
+	auto it = m_pools.find(dataType);
+
+	// 登録されていないデータタイプは、パースして insertOrAssign() したときにエラーを通知します。
+	if (it == m_pools.end())
+	{
+		return false;
+	}
+
+	IConfigPool* pool = it->second.get();
+
+	// 既に参照・購読されているデータタイプは、次に参照されたときにメインスレッドでパースすることになるため、記録しません。
+	if ((pool->numAccesses() != 0) || (pool->numSubscribers() != 0) || m_keyToPool.contains(key))
+	{
+		return false;
+	}
+
+	// 同じファイルのデータタイプが変わった場合は、元の格納先の記録を取り除きます。
+	if (auto [deferredIt, inserted] = m_deferredKeys.try_emplace(key, pool); (not inserted))
+	{
+		if (deferredIt->second == pool)
+		{
+			return true;
+		}
+
+		deferredIt->second->setNumDeferred(deferredIt->second->numDeferred() - 1);
+		deferredIt->second = pool;
+	}
+
+	pool->setNumDeferred(pool->numDeferred() + 1);
+	return true;
+}
+
+void ConfigStore::setDeferredLoader(DeferredLoader loader)
+{
+	m_deferredLoader = std::move(loader);
+}
+
+bool ConfigStore::isDeferred(const String& key) const
+{
+	return m_deferredKeys.contains(key);
+}
+
+size_t ConfigStore::size() const noexcept
+{
+	return m_keyToPool.size();
+}
+
+size_t ConfigStore::numDeferred() const noexcept
+{
+	return m_deferredKeys.size();
+}
+
+Optional<StringView> ConfigStore::dataTypeOf(const String& key) const
+{
+	if (auto it = m_keyToPool.find(key); (it != m_keyToPool.end()))
+	{
+		return it->second->dataType();
+	}
+
+	if (auto it = m_deferredKeys.find(key); (it != m_deferredKeys.end()))
+	{
+		return it->second->dataType();
+	}
+
+	return none;
+}
+
+Array<std::pair<StringView, uint64>> ConfigStore::numAccessesByType() const
+{
+	Array<std::pair<StringView, uint64>> numAccesses;
+	numAccesses.reserve(m_pools.size());
+
+	for (const auto& [dataType, pool] : m_pools)
+	{
+		numAccesses.emplace_back(pool->dataType(), pool->numAccesses());
+	}
+
+	return numAccesses;
+}
+
+uint64 ConfigStore::publish()
+{
+	// スナップショットを書き換えるのはメインスレッドだけのため、読み込みの順序は問いません。
+	const std::shared_ptr<const ConfigSnapshot> current = m_snapshot.load(std::memory_order_relaxed);
+
+	if (m_unpublishedKeys.empty())
+	{
+		// 読み込みに失敗した config など、格納されなかった結果も集計します。
+		ReloadProfiler::RecordPublished();
+		return current->generation();
+	}
+
+	// 変更の無い config は前の世代と共有し、変更された config だけをコピーします。
+	auto next = std::make_shared<ConfigSnapshot>();
+	next->m_generation = (current->m_generation + 1);
+	next->m_entries = current->m_entries;
+
+	// 置き換え・削除される config の分、元の領域で最新の世代から参照されている config が減ります。
+	for (const auto& key : m_unpublishedKeys)
+	{
+		if (auto it = next->m_entries.find(key); (it != next->m_entries.end()))
+		{
+			releaseArenaObject(it->second.arena);
+		}
+	}
+
+	// 一部だけが置き換えられ続けると、変更の無い config が 1 つ残っているだけで古い写しを含む領域全体が解放されないため、コピーし直します。
+	compactArenas(next->m_entries);
+
+	// この世代でコピーする config は 1 つの領域にまとめて確保し、どの世代からも参照されなくなったときにまとめて解放します。
+	size_t arenaSize = 0;
+
+	for (const auto& key : m_unpublishedKeys)
+	{
+		if (auto it = m_keyToPool.find(key); (it != m_keyToPool.end()))
+		{
+			arenaSize += (it->second->configSize() + alignof(std::max_align_t));
+		}
+	}
+
+	const auto arena = std::make_shared<ConfigArena>(arenaSize, m_unpublishedKeys.size());
+
+	for (const auto& key : m_unpublishedKeys)
+	{
+		if (auto it = m_keyToPool.find(key); (it != m_keyToPool.end()))
+		{
+			next->m_entries[key] = ConfigSnapshot::Entry{ it->second->typeIndex(), it->second->share(key, arena), arena.get() };
+		}
+		else
+		{
+			next->m_entries.erase(key);
+		}
+	}
+
+	m_unpublishedKeys.clear();
+
+	if (const size_t numObjects = arena->numObjects())
+	{
+		m_arenaUsages.emplace(arena.get(), ArenaUsage{ numObjects, numObjects });
+	}
+
+	// front() が GetConfig() と同じ config を返すよう、ハッシュテーブルの順ではなく格納先の配列の順に並べます。
+	next->m_configsByType.resize(m_poolsByTypeIndex.size());
+
+	for (size_t typeIndex = 0; typeIndex < m_poolsByTypeIndex.size(); ++typeIndex)
+	{
+		const IConfigPool* pool = m_poolsByTypeIndex[typeIndex];
+
+		if (not pool)
+		{
+			continue;
+		}
+
+		auto& configs = next->m_configsByType[typeIndex];
+		configs.reserve(pool->size());
+
+		for (size_t i = 0; i < pool->size(); ++i)
+		{
+			if (auto it = next->m_entries.find(pool->keyAt(i)); (it != next->m_entries.end()))
+			{
+				configs << it->second.config;
+			}
+		}
+	}
+
+	const uint64 generation = next->m_generation;
+
+	// 完成したスナップショットだけを公開するため、読み込む側が途中の状態を見ることはありません。
+	m_snapshot.store(std::move(next), std::memory_order_release);
+
+	// ワーカースレッドから受け取った config の、変更から公開までの時間を集計します。
+	ReloadProfiler::RecordPublished();
+
+	return generation;
+}
+
+void ConfigStore::loadDeferred(IConfigPool& pool)
+{
+	// パースした config の追加を通知された関数が同じデータタイプを参照しても、もう一度パースしないよう先に記録を取り除きます。
+	pool.setNumDeferred(0);
+
+	Array<String> keys;
+
+	for (const auto& [key, deferredPool] : m_deferredKeys)
+	{
+		if (deferredPool == &pool)
+		{
+			keys << key;
+		}
+	}
+
+	for (const auto& key : keys)
+	{
+		m_deferredKeys.erase(key);
+	}
+
+	if (not m_deferredLoader)
+	{
+		return;
+	}
+
+	if (Editor::IsVerbose())
+	{
+		Editor::ShowVerbose(U"データタイプ`{}`が参照されたため、{} 個の config ファイルをパースします。"_fmt(pool.dataType(), keys.size()));
+	}
+
+	// まとめて渡し、スレッドプールで並列にパースします。パースした config は、次の publish() でスナップショットに加わります。
+	Array<std::unique_ptr<IConfig>> configs = m_deferredLoader(keys);
+
+	for (size_t i = 0; i < Min(keys.size(), configs.size()); ++i)
+	{
+		if (configs[i])
+		{
+			insertOrAssign(keys[i], std::move(configs[i]));
+		}
+	}
+}
+
+size_t ConfigStore::numArenas() const noexcept
+{
+	return m_arenaUsages.size();
+}
+
+void ConfigStore::releaseArenaObject(const ConfigArena* arena)
+{
+	if (auto it = m_arenaUsages.find(arena); (it != m_arenaUsages.end()))
+	{
+		// 最新の世代から参照されなくなった領域は、古い世代を保持しているスレッドが手放したときに解放されます。
+		if (--it->second.numLive == 0)
+		{
+			m_arenaUsages.erase(it);
+		}
+	}
+}
+
+void ConfigStore::compactArenas(const HashTable<String, ConfigSnapshot::Entry>& entries)
+{
+	HashSet<const ConfigArena*> sparseArenas;
+
+	for (const auto& [arena, usage] : m_arenaUsages)
+	{
+		if ((usage.numLive * 2) < usage.numObjects)
+		{
+			sparseArenas.emplace(arena);
+		}
+	}
+
+	if (sparseArenas.empty())
+	{
+		return;
+	}
+
+	// 残っている config は新しい領域にコピーされ、古い領域は最新の世代から参照されなくなります。
+	for (const auto& [key, entry] : entries)
+	{
+		if (sparseArenas.contains(entry.arena) && m_unpublishedKeys.emplace(key).second)
+		{
+			releaseArenaObject(entry.arena);
+		}
+	}
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigStore::snapshot() const noexcept
+{
+	return m_snapshot.load(std::memory_order_acquire);
+}
@@ -0,0 +1,1040 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include "IConfig.hpp"
+# include "ConfigTypeID.hpp"
+# include "ConfigSnapshot.hpp"
+# include "ConfigArena.hpp"
+
+/// @brief ConfigStore に格納された config を指す ID です。
+/// @remark config を削除すると世代が進むため、削除後の ID で別の config を参照することはありません。
+struct ConfigID
+{
+	/// @brief 無効なインデックス
+	static constexpr uint32 InvalidIndex = UINT32_MAX;
+
+	/// @brief スロットのインデックス
+	uint32 index = InvalidIndex;
+
+	/// @brief スロットの世代
+	uint32 generation = 0;
+
+	/// @brief 有効な ID かを返します。
+	/// @return 有効な ID の場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool isValid() const noexcept
+	{
+		return (index != InvalidIndex);
+	}
+
+	[[nodiscard]]
+	friend bool operator ==(const ConfigID&, const ConfigID&) = default;
+};
+
+/// @brief 全てのフィールドを表すビットマスク
+inline constexpr uint64 AllConfigFields = ~uint64{ 0 };
+
+/// @brief Schema() を持つ config の型
+template <class ConfigType>
+concept HasConfigSchema = requires { ConfigType::Schema(); };
+
+/// @brief メンバ変数に対応するフィールドのビットマスクを返します。
+/// @param member メンバ変数
+/// @return フィールドのビットマスク。config の型が Schema() を持たない場合は AllConfigFields
+template <class ConfigType, class ValueType>
+[[nodiscard]]
+constexpr uint64 ConfigFieldMask(ValueType ConfigType::* member) noexcept
+{
+	if constexpr (HasConfigSchema<ConfigType>)
+	{
+		return ConfigType::Schema().fieldMask(member);
+	}
+	else
+	{
+		return AllConfigFields;
+	}
+}
+
+/// @brief 2 つの config をフィールドごとに比較します。
+/// @return 値が異なるフィールドのビットマスク。config の型が Schema() を持たない場合は AllConfigFields
+template <class ConfigType>
+[[nodiscard]]
+uint64 DiffConfig(const ConfigType& a, const ConfigType& b)
+{
+	if constexpr (HasConfigSchema<ConfigType>)
+	{
+		return ConfigType::Schema().diff(a, b);
+	}
+	else
+	{
+		return AllConfigFields;
+	}
+}
+
+/// @brief config の変更の種類
+enum class ConfigChangeType
+{
+	/// @brief 追加された
+	Added,
+
+	/// @brief 置き換えられた
+	Modified,
+
+	/// @brief 削除された
+	Removed,
+};
+
+/// @brief config の変更の通知です。
+/// @tparam ConfigType config の型
+template <class ConfigType>
+struct ConfigChange
+{
+	/// @brief 変更の種類
+	ConfigChangeType type;
+
+	/// @brief config の ID
+	ConfigID id;
+
+	/// @brief config のキー
+	StringView key;
+
+	/// @brief 変更前の config です。追加された場合は nullptr です。
+	const ConfigType* previous = nullptr;
+
+	/// @brief 変更後の config です。削除された場合は nullptr です。
+	const ConfigType* current = nullptr;
+
+	/// @brief 値が変わったフィールドのビットマスクです。追加・削除の場合は AllConfigFields です。
+	uint64 changedFields = 0;
+
+	/// @brief メンバ変数の値が変わったかを返します。
+	/// @param member メンバ変数
+	/// @return 値が変わった場合 true, それ以外の場合は false
+	template <class ValueType>
+	[[nodiscard]]
+	bool hasChanged(ValueType ConfigType::* member) const noexcept
+	{
+		return ((changedFields & ConfigFieldMask(member)) != 0);
+	}
+};
+
+/// @brief データタイプごとの config の格納先のインタフェースです。
+class IConfigPool
+{
+public:
+	virtual ~IConfigPool() = default;
+
+	/// @brief 格納する config のデータタイプを返します。
+	[[nodiscard]]
+	virtual StringView dataType() const noexcept = 0;
+
+	/// @brief config を追加します。同じキーの config がある場合は置き換えます。
+	/// @param key config のキー（config ファイルの絶対パスなど）
+	/// @param config 追加する config です。accepts() が true を返す必要があります。
+	/// @return 追加した config の ID
+	virtual ConfigID insertOrAssign(const String& key, IConfig&& config) = 0;
+
+	/// @brief config が格納する型のオブジェクトかを返します。
+	/// @param config 調べる config
+	/// @return 格納する型の場合 true, それ以外の場合は false
+	/// @remark dynamic_cast を使うため、追加するときだけ呼び出します。
+	[[nodiscard]]
+	virtual bool accepts(const IConfig& config) const noexcept = 0;
+
+	/// @brief キーに対応する config を削除します。
+	/// @param key config のキー
+	/// @return 削除した場合 true, キーが無い場合は false
+	virtual bool erase(const String& key) = 0;
+
+	/// @brief 格納している config の数を返します。
+	[[nodiscard]]
+	virtual size_t size() const noexcept = 0;
+
+	/// @brief 格納する config の型のインデックスを返します。
+	[[nodiscard]]
+	virtual uint32 typeIndex() const noexcept = 0;
+
+	/// @brief config 1 つのサイズ（バイト）を返します。
+	[[nodiscard]]
+	virtual size_t configSize() const noexcept = 0;
+
+	/// @brief キーに対応する config のコピーを領域に作成します。
+	/// @param key config のキー
+	/// @param arena コピーを作成する領域です。返したコピーが参照されている間は解放されません。
+	/// @return config のコピー。キーが無い場合は nullptr
+	[[nodiscard]]
+	virtual std::shared_ptr<const IConfig> share(const String& key, const std::shared_ptr<ConfigArena>& arena) const = 0;
+
+	/// @brief 連続したメモリに格納している順で、index 番目の config のキーを返します。
+	/// @param index 0 以上 size() 未満のインデックス
+	/// @return config のキー
+	[[nodiscard]]
+	virtual const String& keyAt(size_t index) const = 0;
+
+	/// @brief config が get(), front(), forEach() で参照された回数を返します。
+	[[nodiscard]]
+	virtual uint64 numAccesses() const noexcept = 0;
+
+	/// @brief 変更の購読の数を返します。
+	[[nodiscard]]
+	virtual size_t numSubscribers() const noexcept = 0;
+
+	/// @brief まだパースしていない config の数を返します。
+	[[nodiscard]]
+	virtual size_t numDeferred() const noexcept = 0;
+
+	/// @brief まだパースしていない config の数を設定します。
+	/// @param numDeferred まだパースしていない config の数です。0 でない場合、次に参照されたときに ConfigStore がパースします。
+	virtual void setNumDeferred(size_t numDeferred) noexcept = 0;
+};
+
+/// @brief 1 つのデータタイプの config を連続したメモリに格納します。
+/// @tparam ConfigType config の型
+/// @remark 追加・置き換え・削除は O(1) です。削除では末尾の要素を空いた位置に移すため、要素の順序は保たれません。
+/// @remark 置き換えの際は新旧の config をフィールドごとに比較し、値が変わったフィールドを購読している関数にだけ通知します。
+template <class ConfigType>
+class ConfigPool final : public IConfigPool
+{
+public:
+	/// @brief 変更を受け取る関数です。関数の中で ConfigStore を変更しないでください。
+	using Callback = std::function<void(const ConfigChange<ConfigType>&)>;
+
+	[[nodiscard]]
+	StringView dataType() const noexcept override
+	{
+		return ConfigType::DataType;
+	}
+
+	ConfigID insertOrAssign(const String& key, IConfig&& config) override
+	{
+		return insertOrAssign(key, static_cast<ConfigType&&>(config));
+	}
+
+	[[nodiscard]]
+	bool accepts(const IConfig& config) const noexcept override
+	{
+		return (dynamic_cast<const ConfigType*>(&config) != nullptr);
+	}
+
+	/// @brief config を追加します。同じキーの config がある場合は置き換え、ID は変わりません。
+	/// @param key config のキー
+	/// @param config 追加する config
+	/// @return 追加した config の ID
+	ConfigID insertOrAssign(const String& key, ConfigType&& config)
+	{
+		if (auto it = m_keyToSlot.find(key); (it != m_keyToSlot.end()))
+		{
+			const Slot& slot = m_slots[it->second];
+			const ConfigID id{ it->second, slot.generation };
+			ConfigType& target = m_configs[slot.denseIndex];
+
+			// 購読が無い場合は比較を省きます。
+			if (not m_subscribers)
+			{
+				target = std::move(config);
+				return id;
+			}
+
+			const ConfigType previous = std::move(target);
+			target = std::move(config);
+
+			if (const uint64 changedFields = DiffConfig(previous, target))
+			{
+				notify({ .type = ConfigChangeType::Modified, .id = id, .key = key, .previous = &previous, .current = &target, .changedFields = changedFields });
+			}
+
+			return id;
+		}
+
+		uint32 slotIndex;
+
+		if (m_freeSlots)
+		{
+			slotIndex = m_freeSlots.back();
+			m_freeSlots.pop_back();
+		}
+		else
+		{
+			slotIndex = static_cast<uint32>(m_slots.size());
+			m_slots.emplace_back();
+		}
+
+		Slot& slot = m_slots[slotIndex];
+		slot.denseIndex = static_cast<uint32>(m_configs.size());
+		slot.key = key;
+
+		m_configs.push_back(std::move(config));
+		m_denseToSlot.push_back(slotIndex);
+		m_keyToSlot.emplace(key, slotIndex);
+
+		const ConfigID id{ slotIndex, slot.generation };
+		notify({ .type = ConfigChangeType::Added, .id = id, .key = key, .current = &m_configs.back(), .changedFields = AllConfigFields });
+
+		return id;
+	}
+
+	bool erase(const String& key) override
+	{
+		if (auto it = m_keyToSlot.find(key); (it != m_keyToSlot.end()))
+		{
+			const uint32 slotIndex = it->second;
+			m_keyToSlot.erase(it);
+			eraseSlot(slotIndex);
+			return true;
+		}
+
+		return false;
+	}
+
+	/// @brief フィールドの変更を購読します。
+	/// @param fieldMask 購読するフィールドのビットマスクです。ConfigFieldMask() で作成します。
+	/// @param callback 変更を受け取る関数
+	/// @return 購読の ID
+	uint64 subscribe(const uint64 fieldMask, Callback callback)
+	{
+		const uint64 subscriptionID = m_nextSubscriptionID++;
+		m_subscribers << Subscriber{ subscriptionID, fieldMask, std::move(callback) };
+
+		// 購読した関数にも追加を通知するため、購読を加えてからパースします。
+		loadDeferred();
+
+		return subscriptionID;
+	}
+
+	/// @brief 購読を解除します。
+	/// @param subscriptionID 購読の ID
+	/// @return 解除した場合 true, 購読が見つからない場合は false
+	bool unsubscribe(const uint64 subscriptionID)
+	{
+		const size_t numSubscribers = m_subscribers.size();
+		m_subscribers.remove_if([=](const Subscriber& subscriber) { return (subscriber.subscriptionID == subscriptionID); });
+		return (m_subscribers.size() != numSubscribers);
+	}
+
+	/// @brief ID に対応する config を削除します。
+	/// @param id config の ID
+	/// @return 削除した場合 true, ID が無効な場合は false
+	bool erase(const ConfigID id)
+	{
+		if (not contains(id))
+		{
+			return false;
+		}
+
+		m_keyToSlot.erase(m_slots[id.index].key);
+		eraseSlot(id.index);
+		return true;
+	}
+
+	[[nodiscard]]
+	size_t size() const noexcept override
+	{
+		return m_configs.size();
+	}
+
+	[[nodiscard]]
+	uint32 typeIndex() const noexcept override
+	{
+		return ConfigTypeIndex<ConfigType>;
+	}
+
+	[[nodiscard]]
+	size_t configSize() const noexcept override
+	{
+		return sizeof(ConfigType);
+	}
+
+	[[nodiscard]]
+	std::shared_ptr<const IConfig> share(const String& key, const std::shared_ptr<ConfigArena>& arena) const override
+	{
+		if (auto it = m_keyToSlot.find(key); (it != m_keyToSlot.end()))
+		{
+			// 領域の所有権を共有するため、config ごとに制御ブロックを確保しません。
+			const ConfigType* config = arena->create<ConfigType>(m_configs[m_slots[it->second].denseIndex]);
+			return std::shared_ptr<const IConfig>{ arena, config };
+		}
+
+		return nullptr;
+	}
+
+	[[nodiscard]]
+	const String& keyAt(const size_t index) const override
+	{
+		return m_slots[m_denseToSlot[index]].key;
+	}
+
+	[[nodiscard]]
+	uint64 numAccesses() const noexcept override
+	{
+		return m_numAccesses;
+	}
+
+	[[nodiscard]]
+	size_t numSubscribers() const noexcept override
+	{
+		return m_subscribers.size();
+	}
+
+	[[nodiscard]]
+	size_t numDeferred() const noexcept override
+	{
+		return m_numDeferred;
+	}
+
+	void setNumDeferred(const size_t numDeferred) noexcept override
+	{
+		m_numDeferred = numDeferred;
+	}
+
+	/// @brief まだパースしていない config を参照されたときにパースする関数を設定します。ConfigStore が設定します。
+	/// @param loadDeferred パースする関数
+	void setDeferredLoader(std::function<void()> loadDeferred)
+	{
+		m_loadDeferred = std::move(loadDeferred);
+	}
+
+	/// @brief まだパースしていない config があればパースします。
+	/// @remark パースした config を ConfigStore に追加するため、const なメンバ関数からは呼び出しません。
+	void loadDeferred()
+	{
+		if ((m_numDeferred != 0) && m_loadDeferred)
+		{
+			m_loadDeferred();
+		}
+	}
+
+	/// @brief ID が有効な config を指しているかを返します。
+	[[nodiscard]]
+	bool contains(const ConfigID id) const noexcept
+	{
+		return ((id.index < m_slots.size())
+			&& (m_slots[id.index].generation == id.generation)
+			&& (m_slots[id.index].denseIndex != ConfigID::InvalidIndex));
+	}
+
+	/// @brief キーに対応する config の ID を返します。
+	/// @param key config のキー
+	/// @return config の ID。キーが無い場合は無効な ID
+	[[nodiscard]]
+	ConfigID find(const String& key) const
+	{
+		if (auto it = m_keyToSlot.find(key); (it != m_keyToSlot.end()))
+		{
+			return{ it->second, m_slots[it->second].generation };
+		}
+
+		return{};
+	}
+
+	/// @brief ID に対応する config を返します。
+	/// @param id config の ID
+	/// @return config へのポインタ。ID が無効な場合は nullptr
+	[[nodiscard]]
+	ConfigType* get(const ConfigID id) noexcept
+	{
+		++m_numAccesses;
+		return (contains(id) ? &m_configs[m_slots[id.index].denseIndex] : nullptr);
+	}
+
+	/// @brief ID に対応する config を返します。
+	/// @param id config の ID
+	/// @return config へのポインタ。ID が無効な場合は nullptr
+	[[nodiscard]]
+	const ConfigType* get(const ConfigID id) const noexcept
+	{
+		++m_numAccesses;
+		return (contains(id) ? &m_configs[m_slots[id.index].denseIndex] : nullptr);
+	}
+
+	/// @brief 配列の先頭の config を返します。
+	/// @return config へのポインタ。空の場合は nullptr
+	/// @remark まだパースしていない config がある場合は、先にパースします。
+	[[nodiscard]]
+	ConfigType* front()
+	{
+		++m_numAccesses;
+		loadDeferred();
+		return (m_configs ? &m_configs.front() : nullptr);
+	}
+
+	/// @brief 配列の先頭の config を返します。
+	/// @return config へのポインタ。空の場合は nullptr
+	/// @remark まだパースしていない config はパースせず、含めません。
+	[[nodiscard]]
+	const ConfigType* front() const
+	{
+		++m_numAccesses;
+		return (m_configs ? &m_configs.front() : nullptr);
+	}
+
+	/// @brief 格納している config の配列を返します。
+	[[nodiscard]]
+	const Array<ConfigType>& configs() const noexcept
+	{
+		return m_configs;
+	}
+
+	/// @brief 格納している全ての config について関数を呼びます。
+	/// @param function config を受け取る関数
+	/// @remark まだパースしていない config がある場合は、先にパースします。
+	template <class Function>
+	void forEach(Function&& function)
+	{
+		++m_numAccesses;
+		loadDeferred();
+
+		for (auto& config : m_configs)
+		{
+			function(config);
+		}
+	}
+
+	/// @brief 格納している全ての config について関数を呼びます。
+	/// @param function config を受け取る関数
+	/// @remark まだパースしていない config はパースせず、含めません。
+	template <class Function>
+	void forEach(Function&& function) const
+	{
+		++m_numAccesses;
+
+		for (const auto& config : m_configs)
+		{
+			function(config);
+		}
+	}
+
+private:
+
+	/// @brief ID から config の位置を引くためのスロット
+	struct Slot
+	{
+		/// @brief m_configs のインデックス。空きスロットの場合は ConfigID::InvalidIndex
+		uint32 denseIndex = ConfigID::InvalidIndex;
+
+		/// @brief 削除されるたびに増える世代
+		uint32 generation = 0;
+
+		/// @brief config のキー
+		String key;
+	};
+
+	/// @brief 購読
+	struct Subscriber
+	{
+		uint64 subscriptionID;
+
+		uint64 fieldMask;
+
+		Callback callback;
+	};
+
+	/// @brief 変更したフィールドを購読している関数に通知します。
+	void notify(const ConfigChange<ConfigType>& change) const
+	{
+		for (const auto& subscriber : m_subscribers)
+		{
+			if (subscriber.fieldMask & change.changedFields)
+			{
+				subscriber.callback(change);
+			}
+		}
+	}
+
+	/// @brief スロットの config を削除し、末尾の config を空いた位置に移します。
+	void eraseSlot(const uint32 slotIndex)
+	{
+		Slot& slot = m_slots[slotIndex];
+		const uint32 denseIndex = slot.denseIndex;
+		const uint32 lastIndex = static_cast<uint32>(m_configs.size() - 1);
+
+		if (m_subscribers)
+		{
+			const ConfigType previous = std::move(m_configs[denseIndex]);
+			const String key = std::move(slot.key);
+			notify({ .type = ConfigChangeType::Removed, .id = { slotIndex, slot.generation }, .key = key, .previous = &previous, .changedFields = AllConfigFields });
+		}
+
+		if (denseIndex != lastIndex)
+		{
+			m_configs[denseIndex] = std::move(m_configs[lastIndex]);
+			m_denseToSlot[denseIndex] = m_denseToSlot[lastIndex];
+			m_slots[m_denseToSlot[denseIndex]].denseIndex = denseIndex;
+		}
+
+		m_configs.pop_back();
+		m_denseToSlot.pop_back();
+
+		slot.denseIndex = ConfigID::InvalidIndex;
+		++slot.generation;
+		slot.key.clear();
+		m_freeSlots.push_back(slotIndex);
+	}
+
+	/// @brief config（連続したメモリに詰めて格納します）
+	Array<ConfigType> m_configs;
+
+	/// @brief m_configs の各要素に対応するスロットのインデックス
+	Array<uint32> m_denseToSlot;
+
+	/// @brief スロット
+	Array<Slot> m_slots;
+
+	/// @brief 空きスロットのインデックス
+	Array<uint32> m_freeSlots;
+
+	/// @brief キーとスロットのインデックス
+	HashTable<String, uint32> m_keyToSlot;
+
+	/// @brief 購読
+	Array<Subscriber> m_subscribers;
+
+	/// @brief 次に割り当てる購読の ID
+	uint64 m_nextSubscriptionID = 1;
+
+	/// @brief config が参照された回数です。ReloadScheduler が、参照されているデータタイプを優先して読み込むために使います。
+	mutable uint64 m_numAccesses = 0;
+
+	/// @brief まだパースしていない config の数
+	size_t m_numDeferred = 0;
+
+	/// @brief まだパースしていない config をパースする関数
+	std::function<void()> m_loadDeferred;
+};
+
+/// @brief ConfigStore の config を、毎フレームのハッシュ計算や dynamic_cast なしで参照するためのハンドルです。
+/// @tparam ConfigType config の型
+/// @remark config が置き換えられても同じ config を指し続けます。ConfigStore より長く使わないでください。
+/// @remark キーを指定したハンドルはそのキーの config だけを指し、キーを指定しないハンドルはデータタイプの config を 1 つ指します。
+template <class ConfigType>
+class ConfigHandle
+{
+public:
+	ConfigHandle() = default;
+
+	/// @brief データタイプの config を 1 つ指すハンドルを作成します。
+	/// @param pool config の格納先
+	explicit ConfigHandle(ConfigPool<ConfigType>* pool) noexcept
+		: m_pool{ pool } {}
+
+	/// @brief キーの config を指すハンドルを作成します。
+	/// @param pool config の格納先
+	/// @param key config のキー
+	/// @param id config の ID です。まだ格納されていない場合は無効な ID を渡します。
+	ConfigHandle(ConfigPool<ConfigType>* pool, const String& key, const ConfigID id)
+		: m_pool{ pool }
+		, m_key{ key }
+		, m_id{ id }
+		, m_keyed{ true } {}
+
+	/// @brief config を返します。
+	/// @return config へのポインタ。config が無いか、削除された場合は nullptr
+	/// @remark キーを指定したハンドルは、キーの config が格納されていない間は nullptr を返し、格納された後に参照したときに指し直します。
+	[[nodiscard]]
+	ConfigType* get() const
+	{
+		if (not m_pool)
+		{
+			return nullptr;
+		}
+
+		if (not m_keyed)
+		{
+			return m_pool->front();
+		}
+
+		// キーの config が削除されたか、まだ格納されていない場合は、キーから ID を引き直します。
+		if (not m_pool->contains(m_id))
+		{
+			m_pool->loadDeferred();
+			m_id = m_pool->find(m_key);
+		}
+
+		return m_pool->get(m_id);
+	}
+
+	[[nodiscard]]
+	ConfigType* operator ->() const
+	{
+		return get();
+	}
+
+	[[nodiscard]]
+	explicit operator bool() const
+	{
+		return (get() != nullptr);
+	}
+
+private:
+
+	ConfigPool<ConfigType>* m_pool = nullptr;
+
+	/// @brief config のキー（キーを指定したハンドルのみ）
+	String m_key;
+
+	/// @brief 最後に引いた config の ID
+	mutable ConfigID m_id;
+
+	/// @brief キーを指定したハンドルか
+	bool m_keyed = false;
+};
+
+/// @brief 読み込んだ config をデータタイプごとに格納します。同じデータタイプの config を複数格納できます。
+/// @remark 格納するデータタイプは、事前に addType() で登録しておく必要があります。
+/// @remark snapshot() 以外のメンバ関数はメインスレッドから呼び出します。他のスレッドからは snapshot() で取得したスナップショットを参照します。
+/// @remark defer() で記録した config は、そのデータタイプが非 const のメンバ関数、ConfigHandle、または subscribe() で初めて参照されたときに setDeferredLoader() の関数でパースします。const なメンバ関数はパースしません。
+class ConfigStore
+{
+public:
+	/// @brief まだパースしていない config をまとめてパースする関数です。キーの配列を受け取り、同じ順番に並んだ config を返します。失敗したキーの config は nullptr です。
+	using DeferredLoader = std::function<Array<std::unique_ptr<IConfig>>(const Array<String>&)>;
+
+	ConfigStore();
+
+	/// @brief 格納するデータタイプを登録します。
+	/// @tparam ConfigType config の型です。DataType を持つ必要があります。
+	/// @remark 同じ型、または同じ DataType を持つ型が登録済みの場合は、エラーを通知して登録しません。
+	template <class ConfigType>
+	void addType()
+	{
+		auto pool = std::make_unique<ConfigPool<ConfigType>>();
+		pool->setDeferredLoader([this, p = pool.get()] { loadDeferred(*p); });
+
+		addPool(ConfigTypeIndex<ConfigType>, std::move(pool));
+	}
+
+	/// @brief config を追加します。同じキーの config がある場合は置き換えます。
+	/// @param key config のキー（config ファイルの絶対パスなど）
+	/// @param config 追加する config
+	/// @return 追加できた場合 true, データタイプが登録されていない場合は false
+	bool insertOrAssign(const String& key, std::unique_ptr<IConfig> config);
+
+	/// @brief キーに対応する config を削除します。まだパースしていない config の記録も削除します。
+	/// @param key config のキー
+	/// @return 削除した場合 true, キーが無い場合は false
+	bool erase(const String& key);
+
+	/// @brief config ファイルをパースせずに、キーとデータタイプだけを記録します。データタイプが初めて参照されたときにパースします。
+	/// @param key config のキー（config ファイルの絶対パス）
+	/// @param dataType config ファイルのデータタイプ
+	/// @return 記録した場合 true, データタイプが登録されていないか、既に参照または購読されているデータタイプの場合、キーの config が既に格納されている場合は false
+	/// @remark false の場合は、通常どおりパースして insertOrAssign() で追加してください。
+	bool defer(const String& key, StringView dataType);
+
+	/// @brief まだパースしていない config をパースする関数を設定します。
+	/// @param loader パースする関数。メインスレッドで、データタイプが初めて参照されたときに呼ばれます。
+	void setDeferredLoader(DeferredLoader loader);
+
+	/// @brief キーに対応する config がまだパースされていないかを返します。
+	/// @param key config のキー
+	[[nodiscard]]
+	bool isDeferred(const String& key) const;
+
+	/// @brief 格納している config の数を返します。まだパースしていない config は含みません。
+	[[nodiscard]]
+	size_t size() const noexcept;
+
+	/// @brief まだパースしていない config の数を返します。
+	[[nodiscard]]
+	size_t numDeferred() const noexcept;
+
+	/// @brief 前回の publish() 以降の変更をまとめて、新しい世代のスナップショットとして公開します。
+	/// @return 公開した世代。変更が無い場合は現在の世代
+	/// @remark 1 フレームの変更を全て適用してから呼び出すことで、他のスレッドが変更の途中の状態を見ることはありません。
+	uint64 publish();
+
+	/// @brief 最新の世代が参照している、config をコピーした領域の数を返します。
+	[[nodiscard]]
+	size_t numArenas() const noexcept;
+
+	/// @brief キーに対応する config のデータタイプを返します。まだパースしていない config のデータタイプも返します。
+	/// @param key config のキー
+	/// @return データタイプ。キーが無い場合は none
+	[[nodiscard]]
+	Optional<StringView> dataTypeOf(const String& key) const;
+
+	/// @brief データタイプごとに、config が GetConfig, ハンドル, forEach で参照された回数を返します。
+	/// @return データタイプと参照された回数
+	[[nodiscard]]
+	Array<std::pair<StringView, uint64>> numAccessesByType() const;
+
+	/// @brief 最後に公開されたスナップショットを返します。
+	/// @return スナップショット。保持している間は、新しい世代が公開されても内容は変わりません。
+	/// @remark 任意のスレッドから呼び出せます。std::atomic<std::shared_ptr> はロックフリーではなく、MSVC や libstdc++ では内部で短いロックを取ります。
+	/// publish() でスナップショットを作成している間は待たず、完成したスナップショットを置き換える瞬間とだけ排他されます。
+	[[nodiscard]]
+	std::shared_ptr<const ConfigSnapshot> snapshot() const noexcept;
+
+	/// @brief データタイプの格納先を返します。
+	/// @tparam ConfigType config の型
+	/// @return 格納先。データタイプが登録されていない場合は nullptr
+	/// @remark 型のインデックスで配列を引くため、ハッシュ計算や dynamic_cast は行いません。
+	template <class ConfigType>
+	[[nodiscard]]
+	ConfigPool<ConfigType>* pool() noexcept
+	{
+		if (const uint32 typeIndex = ConfigTypeIndex<ConfigType>; (typeIndex < m_poolsByTypeIndex.size()))
+		{
+			return static_cast<ConfigPool<ConfigType>*>(m_poolsByTypeIndex[typeIndex]);
+		}
+
+		return nullptr;
+	}
+
+	/// @brief データタイプの格納先を返します。
+	/// @tparam ConfigType config の型
+	/// @return 格納先。データタイプが登録されていない場合は nullptr
+	template <class ConfigType>
+	[[nodiscard]]
+	const ConfigPool<ConfigType>* pool() const noexcept
+	{
+		if (const uint32 typeIndex = ConfigTypeIndex<ConfigType>; (typeIndex < m_poolsByTypeIndex.size()))
+		{
+			return static_cast<const ConfigPool<ConfigType>*>(m_poolsByTypeIndex[typeIndex]);
+		}
+
+		return nullptr;
+	}
+
+	/// @brief config を指すハンドルを返します。
+	/// @tparam ConfigType config の型
+	/// @param key config のキーです。空の場合は、そのデータタイプの config を 1 つ指すハンドルを返します。
+	/// @return ハンドル
+	/// @remark キーを指定した場合、config がまだ格納されていない間は get() が nullptr を返し、格納された後はその config を指します。
+	/// 他のキーの config を返すことはありません。
+	template <class ConfigType>
+	[[nodiscard]]
+	ConfigHandle<ConfigType> handle(const String& key = {})
+	{
+		auto* p = pool<ConfigType>();
+
+		if (key.isEmpty())
+		{
+			return ConfigHandle<ConfigType>{ p };
+		}
+
+		return{ p, key, ConfigID{} };
+	}
+
+	/// @brief キーに対応する config の ID を返します。
+	/// @tparam ConfigType config の型
+	/// @param key config のキー
+	/// @return config の ID。見つからない場合は無効な ID
+	/// @remark まだパースしていない config は先にパースします。
+	template <class ConfigType>
+	[[nodiscard]]
+	ConfigID find(const String& key)
+	{
+		if (auto* p = pool<ConfigType>())
+		{
+			p->loadDeferred();
+			return p->find(key);
+		}
+
+		return{};
+	}
+
+	/// @brief キーに対応する config の ID を返します。
+	/// @tparam ConfigType config の型
+	/// @param key config のキー
+	/// @return config の ID。見つからない場合は無効な ID
+	/// @remark まだパースしていない config はパースせず、見つからないものとして扱います。
+	template <class ConfigType>
+	[[nodiscard]]
+	ConfigID find(const String& key) const
+	{
+		if (const auto* p = pool<ConfigType>())
+		{
+			return p->find(key);
+		}
+
+		return{};
+	}
+
+	/// @brief ID に対応する config を返します。
+	/// @tparam ConfigType config の型
+	/// @param id config の ID
+	/// @return config へのポインタ。ID が無効な場合は nullptr
+	template <class ConfigType>
+	[[nodiscard]]
+	ConfigType* get(const ConfigID id)
+	{
+		if (auto* p = pool<ConfigType>())
+		{
+			return p->get(id);
+		}
+
+		return nullptr;
+	}
+
+	/// @brief ID に対応する config を返します。
+	/// @tparam ConfigType config の型
+	/// @param id config の ID
+	/// @return config へのポインタ。ID が無効な場合は nullptr
+	template <class ConfigType>
+	[[nodiscard]]
+	const ConfigType* get(const ConfigID id) const
+	{
+		if (const auto* p = pool<ConfigType>())
+		{
+			return p->get(id);
+		}
+
+		return nullptr;
+	}
+
+	/// @brief データタイプの全ての config について関数を呼びます。
+	/// @tparam ConfigType config の型
+	/// @param function config を受け取る関数
+	template <class ConfigType, class Function>
+	void forEach(Function&& function)
+	{
+		if (auto* p = pool<ConfigType>())
+		{
+			p->forEach(std::forward<Function>(function));
+		}
+	}
+
+	/// @brief データタイプの全ての config について関数を呼びます。
+	/// @tparam ConfigType config の型
+	/// @param function const な config を受け取る関数
+	/// @remark まだパースしていない config はパースせず、含めません。
+	template <class ConfigType, class Function>
+	void forEach(Function&& function) const
+	{
+		if (const auto* p = pool<ConfigType>())
+		{
+			p->forEach(std::forward<Function>(function));
+		}
+	}
+
+	/// @brief データタイプの config の変更を購読します。
+	/// @tparam ConfigType config の型です。addType() で登録しておく必要があります。
+	/// @param callback 変更を受け取る関数
+	/// @return 購読の ID。データタイプが登録されていない場合は 0
+	template <class ConfigType>
+	uint64 subscribe(typename ConfigPool<ConfigType>::Callback callback)
+	{
+		if (auto* p = pool<ConfigType>())
+		{
+			return p->subscribe(AllConfigFields, std::move(callback));
+		}
+
+		return 0;
+	}
+
+	/// @brief config のフィールドの変更を購読します。他のフィールドだけが変わった場合は通知されません。
+	/// @param member 購読するフィールドのメンバ変数です。config の型は addType() で登録しておく必要があります。
+	/// @param callback 変更を受け取る関数
+	/// @return 購読の ID。データタイプが登録されていない場合は 0
+	template <class ConfigType, class ValueType>
+	uint64 subscribe(ValueType ConfigType::* member, typename ConfigPool<ConfigType>::Callback callback)
+	{
+		if (auto* p = pool<ConfigType>())
+		{
+			return p->subscribe(ConfigFieldMask(member), std::move(callback));
+		}
+
+		return 0;
+	}
+
+	/// @brief 購読を解除します。
+	/// @tparam ConfigType config の型
+	/// @param subscriptionID 購読の ID
+	/// @return 解除した場合 true, 購読が見つからない場合は false
+	template <class ConfigType>
+	bool unsubscribe(const uint64 subscriptionID)
+	{
+		if (auto* p = pool<ConfigType>())
+		{
+			return p->unsubscribe(subscriptionID);
+		}
+
+		return false;
+	}
+
+private:
+
+	/// @brief 格納先のまだパースしていない config をパースして追加します。
+	void loadDeferred(IConfigPool& pool);
+
+	/// @brief 格納先を登録します。
+	/// @param typeIndex 格納する config の型のインデックス
+	/// @param pool 格納先
+	/// @return 登録できた場合 true, 同じデータタイプが登録済みの場合は false
+	bool addPool(uint32 typeIndex, std::unique_ptr<IConfigPool> pool);
+
+	/// @brief データタイプと格納先
+	HashTable<String, std::unique_ptr<IConfigPool>> m_pools;
+
+	/// @brief 型のインデックスと格納先（登録されていない型は nullptr）
+	Array<IConfigPool*> m_poolsByTypeIndex;
+
+	/// @brief キーと、そのキーの config を格納している格納先
+	HashTable<String, IConfigPool*> m_keyToPool;
+
+	/// @brief 前回の publish() 以降に追加・置き換え・削除された config のキー
+	HashSet<String> m_unpublishedKeys;
+
+	/// @brief まだパースしていない config のキーと、パースした config を格納する格納先
+	HashTable<String, IConfigPool*> m_deferredKeys;
+
+	/// @brief まだパースしていない config をパースする関数
+	DeferredLoader m_deferredLoader;
+
+	/// @brief 領域の使用状況
+	struct ArenaUsage
+	{
+		/// @brief 領域に作成した config の数
+		size_t numObjects = 0;
+
+		/// @brief 最新の世代から参照されている config の数
+		size_t numLive = 0;
+	};
+
+	/// @brief 最新の世代が参照している領域と、その使用状況
+	HashTable<const ConfigArena*, ArenaUsage> m_arenaUsages;
+
+	/// @brief 最新の世代から参照されなくなった config を、領域の使用状況から除きます。
+	void releaseArenaObject(const ConfigArena* arena);
+
+	/// @brief 最新の世代から参照されている config が半分より少ない領域について、残りの config をコピーし直すよう m_unpublishedKeys に加えます。
+	/// @param entries 新しい世代の config
+	void compactArenas(const HashTable<String, ConfigSnapshot::Entry>& entries);
+
+	/// @brief 公開されているスナップショット（読み込みは任意のスレッドから、書き込みは publish() だけが行います）
+	std::atomic<std::shared_ptr<const ConfigSnapshot>> m_snapshot;
+};
+
+/// @brief データタイプの config を 1 つ返します。
+/// @tparam ConfigType config の型
+/// @param configs config の格納先
+/// @return config へのポインタ。格納されていない場合は nullptr
+/// @remark 1 つだけ格納するデータタイプに使います。複数格納されている場合にどれを返すかは決まっていません。
+template <class ConfigType>
+[[nodiscard]]
+ConfigType* GetConfig(ConfigStore& configs)
+{
+	if (auto* p = configs.pool<ConfigType>())
+	{
+		return p->front();
+	}
+
+	return nullptr;
+}
+
+/// @brief データタイプの config を 1 つ返します。
+/// @tparam ConfigType config の型
+/// @param configs config の格納先
+/// @return config へのポインタ。格納されていない場合は nullptr
+/// @remark 1 つだけ格納するデータタイプに使います。複数格納されている場合にどれを返すかは決まっていません。
+/// まだパースしていない config はパースせず、含めません。
+template <class ConfigType>
+[[nodiscard]]
+const ConfigType* GetConfig(const ConfigStore& configs)
+{
+	if (const auto* p = configs.pool<ConfigType>())
+	{
+		return p->front();
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,21 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+
+namespace detail
+{
+	/// @brief 次に割り当てる config の型のインデックス
+	inline std::atomic<uint32> s_nextConfigTypeIndex = 0;
+
+	[[nodiscard]]
+	inline uint32 NextConfigTypeIndex() noexcept
+	{
+		return s_nextConfigTypeIndex++;
+	}
+}
+
+/// @brief config の型ごとに割り当てられる、0 から始まる連続したインデックスです。
+/// @tparam ConfigType config の型
+/// @remark コンパイル時の定数ではなく、静的初期化のときに型ごとに 1 回だけ採番される変数です。以降はハッシュ計算や RTTI なしで読み出せます。
+/// 採番の順序は翻訳単位の初期化順に依存し、プログラムの実行ごとに変わる可能性があるため、保存したり switch の case に使ったりしないでください。
+template <class ConfigType>
+inline const uint32 ConfigTypeIndex = detail::NextConfigTypeIndex();
@@ -1,5 +1,6 @@
 ﻿# include "DirectoryMonitor.hpp"
 # include "Editor.hpp"
+# include "ReloadProfiler.hpp"
 
 namespace
 {
@@ -20,11 +21,12 @@ namespace
 	}
 }
 
-bool DirectoryMonitor::init(FilePathView directory, const Array<String>& allowExtensions, int32 cooldownTimeMillisec)
+bool DirectoryMonitor::init(FilePathView directory, const Array<String>& allowExtensions, int32 cooldownTimeMillisec, size_t maxDepth)
 {
 	m_directory = directory;
-	m_allowExtensions = allowExtensions;
+	m_extensionFilter = ExtensionFilter{ allowExtensions };
 	m_cooldownTimeMillisec = cooldownTimeMillisec;
+	m_maxDepth = maxDepth;
 	m_directoryWatcher = DirectoryWatcher{ m_directory };
 
 	//ディレクトリが見つからない場合作成する
@@ -51,67 +53,244 @@ bool DirectoryMonitor::init(FilePathView directory, const Array<String>& allowEx
 
 	Editor::ShowSuccess(U"ディレクトリ`{}`の監視を開始しました。"_fmt(m_directory));
 
-	//既存のファイルをバッファに追加
-	for (const auto& path : FileSystem::DirectoryContents(m_directory))
-	{
-		if (const String extension = FileSystem::Extension(path);
-			(not m_allowExtensions.contains(extension)))
-		{
-			//監視対象の拡張子でない場合は無視する。
-			continue;
-		}
+	m_fullDirectory = FileSystem::FullPath(m_directory);
 
-		m_changeFileBuffer.emplace(path, 0);
-	}
+	//既存のファイルは update() で少しずつ探索してバッファに追加する
+	m_crawlDirectories = { CrawlDirectory{ .path = m_fullDirectory, .depth = 0 } };
+	m_crawlEntries.clear();
+	m_crawlEntryIndex = 0;
 
 	return true;
 }
 
 void DirectoryMonitor::update()
 {
+	const uint64 beginTimeMicrosec = Time::GetMicrosec();
 	uint64 currentTimeMillisec = Time::GetMillisec();
 	// 絶対パスと、アクションの内容を取得する
 	for (const auto& [path, fileAction] : m_directoryWatcher.retrieveChanges())
 	{
-		//監視対象でない拡張子の場合無視する
-		const String extension = FileSystem::Extension(path);
-		if (not m_allowExtensions.contains(extension))
+		const size_t depth = depthOf(path);
+
+		//監視する深さより深い場合は無視する
+		if (m_maxDepth < depth)
 		{
 			continue;
 		}
 
-		Editor::ShowVerbose(U"File {}:`{}`"_fmt(ToString(fileAction), path));
-
-
-		//バッファーに無いファイルの変更の場合バッファーにpathと時間を追加
-		if (auto it = m_changeFileBuffer.find(path); (it != m_changeFileBuffer.end()))
+		//監視対象でない拡張子の場合無視する。ただし追加されたディレクトリは中身を探索する
+		if (not m_extensionFilter.matches(path))
 		{
-			it->second = currentTimeMillisec;
+			if ((fileAction == FileAction::Added) && (depth < m_maxDepth) && FileSystem::IsDirectory(path))
+			{
+				m_crawlDirectories << CrawlDirectory{ .path = path, .depth = (depth + 1) };
+			}
+
+			continue;
 		}
-		else
+
+		if (Editor::IsVerbose())
 		{
-			m_changeFileBuffer.emplace(path, currentTimeMillisec);
+			Editor::ShowVerbose(U"File {}:`{}`"_fmt(ToString(fileAction), path));
 		}
+
+		addChange(path, currentTimeMillisec, false);
 	}
+
+	crawl(Time::GetMicrosec() + CrawlTimeBudgetMicrosec);
+
+	ReloadProfiler::RecordWatcherUpdate(Time::GetMicrosec() - beginTimeMicrosec);
+}
+
+void DirectoryMonitor::setDebounceMode(const DebounceMode debounceMode) noexcept
+{
+	m_debounceMode = debounceMode;
 }
 
 Array<FilePath> DirectoryMonitor::retrieveChangedFiles()
 {
 	const uint64 currentTimeMillisec = Time::GetMillisec();
 	Array<FilePath> changedFiles;
-	//最終更新から一定時間変更のないファイルを読み込む
-	for (auto it = m_changeFileBuffer.begin(); it != m_changeFileBuffer.end();)
+	m_lastChangeLatencies.clear();
+
+	//最終更新から一定時間変更のないファイルを読み込む。キューの先頭がまだの場合は何もしない
+	while ((not m_pendingQueue.empty()) && (m_pendingQueue.top().readyTimeMillisec <= currentTimeMillisec))
 	{
-		if (currentTimeMillisec < it->second + m_cooldownTimeMillisec)
+		const PendingChange pendingChange = m_pendingQueue.top();
+		m_pendingQueue.pop();
+
+		// 再度変更されたファイルの古い要素の場合は読み飛ばす
+		auto it = m_changeFileBuffer.find(pendingChange.path);
+
+		if ((it == m_changeFileBuffer.end()) || (it->second.readyTimeMillisec != pendingChange.readyTimeMillisec))
+		{
+			continue;
+		}
+
+		ChangeState& state = it->second;
+
+		// 書き込み中のファイルは間隔をあけて再度確認する
+		if ((m_debounceMode == DebounceMode::Adaptive) && (not state.settled) && (not IsWriteComplete(it->first, state)))
 		{
-			
-			++it;
+			state.readyTimeMillisec = (currentTimeMillisec + state.backoffMillisec);
+			schedule(it->first, state.readyTimeMillisec);
 			continue;
 		}
 
+		const uint64 latencyMillisec = (currentTimeMillisec - state.firstChangeTimeMillisec);
+
+		if ((not state.settled) && Editor::IsVerbose())
+		{
+			Editor::ShowVerbose(U"File Ready:`{}` ({} ms)"_fmt(it->first, latencyMillisec));
+		}
+
+		ReloadProfiler::RecordReady(it->first, (Time::GetMicrosec() - state.firstChangeTimeMicrosec));
+
+		m_lastChangeLatencies << ChangeLatency{ .path = it->first, .latencyMillisec = latencyMillisec };
 		changedFiles << it->first;
-		it = m_changeFileBuffer.erase(it);
+		m_changeFileBuffer.erase(it);
 	}
 
 	return changedFiles;
 }
+
+const Array<DirectoryMonitor::ChangeLatency>& DirectoryMonitor::lastChangeLatencies() const noexcept
+{
+	return m_lastChangeLatencies;
+}
+
+void DirectoryMonitor::crawl(const uint64 deadlineMicrosec)
+{
+	while (Time::GetMicrosec() < deadlineMicrosec)
+	{
+		// 探索中のディレクトリの中身を 1 つずつ調べる
+		if (m_crawlEntryIndex < m_crawlEntries.size())
+		{
+			const FilePath& path = m_crawlEntries[m_crawlEntryIndex++];
+
+			if (m_extensionFilter.matches(path))
+			{
+				addChange(path, Time::GetMillisec(), true);
+			}
+			else if ((m_crawlEntryDepth < m_maxDepth) && FileSystem::IsDirectory(path))
+			{
+				m_crawlDirectories << CrawlDirectory{ .path = path, .depth = (m_crawlEntryDepth + 1) };
+			}
+
+			continue;
+		}
+
+		if (m_crawlDirectories.isEmpty())
+		{
+			m_crawlEntries.clear();
+			m_crawlEntryIndex = 0;
+			return;
+		}
+
+		// 次のディレクトリの中身を取得する
+		const CrawlDirectory crawlDirectory = std::move(m_crawlDirectories.back());
+		m_crawlDirectories.pop_back();
+
+		m_crawlEntries = FileSystem::DirectoryContents(crawlDirectory.path, Recursive::No);
+		m_crawlEntryIndex = 0;
+		m_crawlEntryDepth = crawlDirectory.depth;
+	}
+}
+
+size_t DirectoryMonitor::depthOf(const FilePathView path) const noexcept
+{
+	size_t depth = 0;
+
+	for (size_t i = (path.starts_with(m_fullDirectory) ? m_fullDirectory.size() : 0); i < path.size(); ++i)
+	{
+		if ((path[i] == U'/') || (path[i] == U'\\'))
+		{
+			++depth;
+		}
+	}
+
+	// ディレクトリ自体の末尾の区切り文字は数えない
+	if ((depth != 0) && ((path.back() == U'/') || (path.back() == U'\\')))
+	{
+		--depth;
+	}
+
+	return depth;
+}
+
+void DirectoryMonitor::addChange(const FilePath& path, const uint64 currentTimeMillisec, const bool settled)
+{
+	//バッファーに無いファイルの変更の場合バッファーにpathと時間を追加し、ある場合は時間を更新する
+	auto [it, inserted] = m_changeFileBuffer.try_emplace(path);
+	ChangeState& state = it->second;
+
+	if (inserted)
+	{
+		state.firstChangeTimeMillisec = currentTimeMillisec;
+		state.firstChangeTimeMicrosec = Time::GetMicrosec();
+		state.settled = settled;
+	}
+
+	if (settled)
+	{
+		// 起動時の探索で見つかったファイルはすぐに読み込む
+		state.readyTimeMillisec = currentTimeMillisec;
+	}
+	else
+	{
+		state.settled = false;
+
+		// Adaptive の場合、書き込み中のファイルは確認の間隔を広げたまま待つ
+		state.readyTimeMillisec = currentTimeMillisec + ((m_debounceMode == DebounceMode::Adaptive)
+			? Max(SettleTimeMillisec, state.backoffMillisec) : static_cast<uint64>(m_cooldownTimeMillisec));
+	}
+
+	schedule(path, state.readyTimeMillisec);
+}
+
+void DirectoryMonitor::schedule(const FilePath& path, const uint64 readyTimeMillisec)
+{
+	m_pendingQueue.push(PendingChange{ .readyTimeMillisec = readyTimeMillisec, .path = path });
+
+	// 読み飛ばす要素が増えすぎた場合はキューを作り直す
+	if ((m_changeFileBuffer.size() * 4) < m_pendingQueue.size())
+	{
+		Array<PendingChange> pendingChanges;
+		pendingChanges.reserve(m_changeFileBuffer.size());
+
+		for (const auto& [changedPath, state] : m_changeFileBuffer)
+		{
+			pendingChanges << PendingChange{ .readyTimeMillisec = state.readyTimeMillisec, .path = changedPath };
+		}
+
+		m_pendingQueue = std::priority_queue<PendingChange, Array<PendingChange>, std::greater<>>{ std::greater<>{}, std::move(pendingChanges) };
+	}
+}
+
+bool DirectoryMonitor::IsWriteComplete(const FilePathView path, ChangeState& state)
+{
+	// 削除されたファイルは待たずに読み込み可能とする
+	if (not FileSystem::Exists(path))
+	{
+		return true;
+	}
+
+	const int64 size = FileSystem::FileSize(path);
+	const int64 lastSize = std::exchange(state.lastSize, size);
+
+	// 前回の確認からサイズが変わった場合は書き込み中とみなし、確認の間隔を広げる
+	if (size != lastSize)
+	{
+		state.backoffMillisec = ((lastSize < 0) ? SettleTimeMillisec : Min((state.backoffMillisec * 2), MaxBackoffMillisec));
+		return false;
+	}
+
+	// サイズが変わらなくても、他のプロセスが書き込みのために開いている場合は開けない
+	if (not BinaryReader{ path })
+	{
+		state.backoffMillisec = Min((Max(state.backoffMillisec, SettleTimeMillisec) * 2), MaxBackoffMillisec);
+		return false;
+	}
+
+	return true;
+}
@@ -1,31 +1,182 @@
 ﻿# pragma once
 # include <Siv3D.hpp>
+# include <queue>
+# include "ExtensionFilter.hpp"
 
 class DirectoryMonitor
 {
 public:
+	/// @brief ファイルの書き込みが終わったと判断する方法
+	enum class DebounceMode
+	{
+		/// @brief 最後の変更から一定時間（cooldownTimeMillisec）経過したら読み込み可能とします。
+		Fixed,
+
+		/// @brief サイズが変わらなくなり、ファイルを開けるようになったら読み込み可能とします。書き込み中のファイルは確認の間隔を広げます。
+		Adaptive,
+	};
+
+	/// @brief ファイルの変更が通知されてから読み込み可能になるまでの時間です。
+	struct ChangeLatency
+	{
+		/// @brief ファイルのパス
+		FilePath path;
+
+		/// @brief 最初の変更の通知から読み込み可能になるまでの時間（ミリ秒）
+		uint64 latencyMillisec = 0;
+	};
+
+	/// @brief サブディレクトリを深さの制限なく監視する場合の maxDepth です。
+	static constexpr size_t UnlimitedDepth = std::numeric_limits<size_t>::max();
+
 	DirectoryMonitor() = default;
 
-	bool init(FilePathView directory, const Array<String>& allowExtensions, int32 cooldownTimeMillisec = 100);
+	/// @brief ディレクトリの監視を開始します。
+	/// @param directory 監視するディレクトリのパス
+	/// @param allowExtensions 監視する拡張子
+	/// @param cooldownTimeMillisec ファイルが最終更新からこの時間（ミリ秒）経過後に読み込まれます。
+	/// @param maxDepth 監視するサブディレクトリの深さです。0 の場合は directory 直下のファイルのみを監視します。
+	/// @return 監視を開始できた場合 true, それ以外の場合は false
+	/// @remark 既存のファイルは update() の中で数フレームに分けて探索されます。
+	bool init(FilePathView directory, const Array<String>& allowExtensions, int32 cooldownTimeMillisec = 100, size_t maxDepth = UnlimitedDepth);
+
+	/// @brief ファイルの書き込みが終わったと判断する方法を設定します。
+	/// @param debounceMode 判断する方法
+	void setDebounceMode(DebounceMode debounceMode) noexcept;
 
 	void update();
 
 	Array<FilePath> retrieveChangedFiles();
 
+	/// @brief 直前の retrieveChangedFiles() で返したファイルが、変更の通知から読み込み可能になるまでの時間を返します。
+	/// @return ファイルごとの時間
+	[[nodiscard]]
+	const Array<ChangeLatency>& lastChangeLatencies() const noexcept;
+
 private:
 
+	/// @brief 読み込み可能になる時刻が来るのを待っているファイル
+	struct PendingChange
+	{
+		/// @brief 読み込み可能になる時刻（ミリ秒）
+		uint64 readyTimeMillisec = 0;
+
+		/// @brief ファイルのパス
+		FilePath path;
+
+		[[nodiscard]]
+		bool operator >(const PendingChange& other) const noexcept
+		{
+			return (readyTimeMillisec > other.readyTimeMillisec);
+		}
+	};
+
+	/// @brief バッファ内のファイルの状態
+	struct ChangeState
+	{
+		/// @brief 読み込み可能になる（Adaptive の場合は書き込みの完了を確認する）時刻（ミリ秒）
+		uint64 readyTimeMillisec = 0;
+
+		/// @brief 最初に変更が通知された時刻（ミリ秒）
+		uint64 firstChangeTimeMillisec = 0;
+
+		/// @brief 最初に変更が通知された時刻（マイクロ秒）。ReloadProfiler で待ち時間を計測するために使います。
+		uint64 firstChangeTimeMicrosec = 0;
+
+		/// @brief 前回確認したときのファイルサイズ。まだ確認していない場合は -1
+		int64 lastSize = -1;
+
+		/// @brief 書き込み中のファイルを次に確認するまでの間隔（ミリ秒）
+		uint64 backoffMillisec = 0;
+
+		/// @brief 起動時の探索で見つかったファイルなど、書き込みの完了を確認しなくてよいか
+		bool settled = false;
+	};
+
+	/// @brief 探索を待っているディレクトリ
+	struct CrawlDirectory
+	{
+		FilePath path;
+
+		/// @brief ディレクトリ直下のファイルの深さ
+		size_t depth = 0;
+	};
+
+	/// @brief 既存のファイルを探索してバッファに追加します。
+	/// @param deadlineMicrosec この時刻（マイクロ秒）を過ぎたら探索を中断し、次のフレームで再開します。
+	void crawl(uint64 deadlineMicrosec);
+
+	/// @brief 監視するディレクトリから見たファイルの深さを返します。
+	/// @param path ファイルの絶対パス
+	/// @return ディレクトリ直下の場合 0
+	[[nodiscard]]
+	size_t depthOf(FilePathView path) const noexcept;
+
+	/// @brief ファイルの変更をバッファに追加します。
+	/// @param path ファイルのパス
+	/// @param currentTimeMillisec 変更が通知された時刻（ミリ秒）
+	/// @param settled 書き込みの完了を確認せずに読み込み可能とする場合 true
+	void addChange(const FilePath& path, uint64 currentTimeMillisec, bool settled);
+
+	/// @brief ファイルの読み込み可能になる時刻をキューに追加します。
+	void schedule(const FilePath& path, uint64 readyTimeMillisec);
+
+	/// @brief ファイルの書き込みが終わったかを確認します（Adaptive）。
+	/// @param path ファイルのパス
+	/// @param state ファイルの状態。確認したサイズと次に確認するまでの間隔が更新されます。
+	/// @return 書き込みが終わっている場合 true, それ以外の場合は false
+	[[nodiscard]]
+	static bool IsWriteComplete(FilePathView path, ChangeState& state);
+
 	/// @brief ディレクトリのパス
 	FilePath m_directory;
 
+	/// @brief ディレクトリの絶対パス
+	FilePath m_fullDirectory;
+
 	/// @brief ディレクトリの監視オブジェクト
 	DirectoryWatcher m_directoryWatcher;
 
 	/// @brief ディレクトリで監視する拡張子
-	Array<String> m_allowExtensions;
+	ExtensionFilter m_extensionFilter;
+
+	/// @brief 監視するサブディレクトリの深さ
+	size_t m_maxDepth = UnlimitedDepth;
+
+	/// @brief 1 フレームで既存のファイルの探索に使う時間（マイクロ秒）
+	static constexpr uint64 CrawlTimeBudgetMicrosec = 2000;
+
+	/// @brief 探索を待っているディレクトリ
+	Array<CrawlDirectory> m_crawlDirectories;
+
+	/// @brief 探索中のディレクトリの中身
+	Array<FilePath> m_crawlEntries;
+
+	/// @brief m_crawlEntries の次に調べる位置
+	size_t m_crawlEntryIndex = 0;
+
+	/// @brief m_crawlEntries のファイルの深さ
+	size_t m_crawlEntryDepth = 0;
 
 	/// @brief バッファ内のファイルが最終更新からこの時間（ミリ秒）経過後に読み込まれる閾値
 	int32 m_cooldownTimeMillisec = 100;
 
-	/// @brief 変更されたファイルのパスと更新時間（ミリ秒）
-	HashTable<FilePath, uint64> m_changeFileBuffer;
+	/// @brief ファイルの書き込みが終わったと判断する方法
+	DebounceMode m_debounceMode = DebounceMode::Fixed;
+
+	/// @brief Adaptive で、最後の変更から書き込みの完了を確認するまでの時間（ミリ秒）
+	static constexpr uint64 SettleTimeMillisec = 15;
+
+	/// @brief Adaptive で、書き込み中のファイルを確認する間隔の最大値（ミリ秒）
+	static constexpr uint64 MaxBackoffMillisec = 1000;
+
+	/// @brief 変更されたファイルのパスと状態
+	HashTable<FilePath, ChangeState> m_changeFileBuffer;
+
+	/// @brief 直前の retrieveChangedFiles() で返したファイルの、変更の通知から読み込み可能になるまでの時間
+	Array<ChangeLatency> m_lastChangeLatencies;
+
+	/// @brief 読み込み可能になる時刻の早い順に並んだキュー
+	/// @remark 再度変更されたファイルの古い要素は、取り出したときに m_changeFileBuffer の時刻と一致しないため読み飛ばします。
+	std::priority_queue<PendingChange, Array<PendingChange>, std::greater<>> m_pendingQueue;
 };
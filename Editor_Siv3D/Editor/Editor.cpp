@@ -1,5 +1,24 @@
 ﻿# include "Editor.hpp"
 # include "NotificationAddon.hpp"
+# include "ReloadProfilerAddon.hpp"
+# include "LogSink.hpp"
+
+namespace
+{
+	/// @brief 通知を書き出すログファイル
+	[[nodiscard]]
+	LogSink& GetLogSink()
+	{
+		static LogSink logSink;
+		return logSink;
+	}
+
+# if SIV3D_BUILD(DEBUG)
+	std::atomic<bool> g_verbose = true;
+# else
+	std::atomic<bool> g_verbose = false;
+# endif
+}
 
 bool Editor::init()
 {
@@ -12,16 +31,28 @@ bool Editor::init()
 	//通知の横幅を設定する
 	NotificationAddon::SetStyle({ .width = 900 });
 
+	// 通知をログファイルにも書き出します。ログファイルを開けなくても Editor は使えます。
+	if (not GetLogSink().open(LogSink::Options{}))
+	{
+		ShowWarning(U"ログファイルを開けませんでした。");
+	}
+
+	// config の読み込みにかかった時間を表示するアドオンを登録します（最初は非表示）。
+	Addon::Register<ReloadProfilerAddon>(U"ReloadProfilerAddon");
+
 	return true;
 }
 
 bool Editor::prepareConfigDirectory()
 {
 	//DirectoryMonitorで監視する config ディレクトリのパスとファイルの拡張子を指定します。
-	if (not m_configDirectoryMonitor.init(U"config/", { U"json",U"ini",U"txt"}))
+	if (not m_configDirectoryMonitor.init(U"config/", { U"json",U"csv",U"ini",U"txt"}))
 	{
 		return false;
 	}
+
+	//書き込みが終わったファイルから順に読み込みます。
+	m_configDirectoryMonitor.setDebounceMode(DirectoryMonitor::DebounceMode::Adaptive);
 	return true;
 }
 
@@ -35,29 +66,47 @@ Array<FilePath> Editor::retrieveChangedConfigFiles()
 	return m_configDirectoryMonitor.retrieveChangedFiles();
 }
 
-void Editor::ShowVerbose([[maybe_unused]]const StringView text)
+void Editor::ShowVerbose(const StringView text, const std::source_location& location)
 {
-# if SIV3D_BUILD(DEBUG)
+	if (not IsVerbose())
+	{
+		return;
+	}
+
+	GetLogSink().write(LogLevel::Verbose, text, location);
 	NotificationAddon::Show(text, NotificationAddon::Type::Normal);
-# endif
 }
 
-void Editor::ShowInfo(const StringView text)
+void Editor::ShowInfo(const StringView text, const std::source_location& location)
 {
+	GetLogSink().write(LogLevel::Info, text, location);
 	NotificationAddon::Show(text, NotificationAddon::Type::Information);
 }
 
-void Editor::ShowSuccess(const StringView text)
+void Editor::ShowSuccess(const StringView text, const std::source_location& location)
 {
+	GetLogSink().write(LogLevel::Success, text, location);
 	NotificationAddon::Show(text, NotificationAddon::Type::Success);
 }
 
-void Editor::ShowWarning(const StringView text)
+void Editor::ShowWarning(const StringView text, const std::source_location& location)
 {
+	GetLogSink().write(LogLevel::Warning, text, location);
 	NotificationAddon::Show(text, NotificationAddon::Type::Warning);
 }
 
-void Editor::ShowError(const StringView text)
+void Editor::ShowError(const StringView text, const std::source_location& location)
 {
+	GetLogSink().write(LogLevel::Error, text, location);
 	NotificationAddon::Show(text, NotificationAddon::Type::Failure);
 }
+
+void Editor::SetVerbose(const bool verbose) noexcept
+{
+	g_verbose.store(verbose, std::memory_order_relaxed);
+}
+
+bool Editor::IsVerbose() noexcept
+{
+	return g_verbose.load(std::memory_order_relaxed);
+}
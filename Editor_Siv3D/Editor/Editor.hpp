@@ -1,5 +1,6 @@
 ﻿# pragma once
 # include <Siv3D.hpp>
+# include <source_location>
 # include "DirectoryMonitor.hpp"
 
 class Editor
@@ -23,24 +24,39 @@ public:
 
 	/// @brief 通知（詳細）を出力します。
 	/// @param text 通知内容
-	/// @remark Relese ビルドでは通知は出力されません。
-	static void ShowVerbose(StringView text);
+	/// @param location 呼び出し元の位置（ログに記録します）
+	/// @remark SetVerbose(false) の場合は通知もログも出力されません。Release ビルドでは既定で無効です。
+	static void ShowVerbose(StringView text, const std::source_location& location = std::source_location::current());
 
 	/// @brief 通知（情報）を出力します。
 	/// @param text 通知内容
-	static void ShowInfo(StringView text);
+	/// @param location 呼び出し元の位置（ログに記録します）
+	static void ShowInfo(StringView text, const std::source_location& location = std::source_location::current());
 
 	/// @brief 通知（成功）を出力します。
 	/// @param text 通知内容
-	static void ShowSuccess(StringView text);
+	/// @param location 呼び出し元の位置（ログに記録します）
+	static void ShowSuccess(StringView text, const std::source_location& location = std::source_location::current());
 
 	/// @brief 通知（警告）を出力します。
 	/// @param text 通知内容
-	static void ShowWarning(StringView text);
+	/// @param location 呼び出し元の位置（ログに記録します）
+	static void ShowWarning(StringView text, const std::source_location& location = std::source_location::current());
 
 	/// @brief 通知（失敗）を出力します。
 	/// @param text 通知内容
-	static void ShowError(StringView text);
+	/// @param location 呼び出し元の位置（ログに記録します）
+	static void ShowError(StringView text, const std::source_location& location = std::source_location::current());
+
+	/// @brief 詳細な通知とログを出力するかを設定します。どのスレッドからでも呼び出せます。
+	/// @param verbose 出力する場合 true
+	static void SetVerbose(bool verbose) noexcept;
+
+	/// @brief 詳細な通知とログを出力するかを返します。
+	/// @return 出力する場合 true, それ以外の場合は false
+	/// @remark メッセージの作成に時間がかかる場合は、先にこの関数で確認してください。
+	[[nodiscard]]
+	static bool IsVerbose() noexcept;
 
 private:
 
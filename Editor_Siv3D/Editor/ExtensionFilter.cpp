@@ -0,0 +1,91 @@
+﻿# include "ExtensionFilter.hpp"
+
+namespace
+{
+	[[nodiscard]]
+	static constexpr char32 ToLowerASCII(const char32 ch) noexcept
+	{
+		return ((U'A' <= ch) && (ch <= U'Z')) ? (ch + (U'a' - U'A')) : ch;
+	}
+
+	/// @brief ファイルパスから拡張子の部分を取り出します。
+	/// @param path ファイルパス
+	/// @return 拡張子（`.` を含まない）。拡張子が無い場合は空の文字列
+	[[nodiscard]]
+	static StringView ExtensionView(const FilePathView path) noexcept
+	{
+		for (size_t i = path.size(); i != 0; --i)
+		{
+			const char32 ch = path[i - 1];
+
+			if (ch == U'.')
+			{
+				return path.substr(i);
+			}
+
+			if ((ch == U'/') || (ch == U'\\'))
+			{
+				break;
+			}
+		}
+
+		return{};
+	}
+
+	/// @brief 大文字と小文字を区別せずにハッシュ値（FNV-1a）を計算します。
+	[[nodiscard]]
+	static uint64 HashLowercase(const StringView s) noexcept
+	{
+		uint64 hash = 14695981039346656037ull;
+
+		for (const char32 ch : s)
+		{
+			hash = ((hash ^ ToLowerASCII(ch)) * 1099511628211ull);
+		}
+
+		return hash;
+	}
+}
+
+ExtensionFilter::ExtensionFilter(const Array<String>& allowExtensions)
+{
+	for (const auto& extension : allowExtensions)
+	{
+		m_allowExtensions.emplace(HashLowercase(extension), extension.lowercased());
+	}
+}
+
+bool ExtensionFilter::matches(const FilePathView path) const noexcept
+{
+	const StringView extension = ExtensionView(path);
+
+	if (extension.isEmpty())
+	{
+		return false;
+	}
+
+	const auto it = m_allowExtensions.find(HashLowercase(extension));
+
+	if (it == m_allowExtensions.end())
+	{
+		return false;
+	}
+
+	// ハッシュ値の衝突に備えて文字列を比較します。
+	const String& allowExtension = it->second;
+
+	if (allowExtension.size() != extension.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < extension.size(); ++i)
+	{
+		if (ToLowerASCII(extension[i]) != allowExtension[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,24 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+
+/// @brief ファイルパスの拡張子が許可されたものかを、文字列を確保せずに判定します。
+class ExtensionFilter
+{
+public:
+	ExtensionFilter() = default;
+
+	/// @brief 許可する拡張子からフィルタを作成します。
+	/// @param allowExtensions 許可する拡張子です（`.` を含まず、大文字と小文字は区別しません）。
+	explicit ExtensionFilter(const Array<String>& allowExtensions);
+
+	/// @brief ファイルパスの拡張子が許可されたものかを返します。
+	/// @param path ファイルパス
+	/// @return 許可された拡張子の場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool matches(FilePathView path) const noexcept;
+
+private:
+
+	/// @brief 許可する拡張子のハッシュ値と、小文字の拡張子です。
+	HashTable<uint64, String> m_allowExtensions;
+};
@@ -1,120 +1,628 @@
 ﻿#include "JSONParser.hpp"
+# include <charconv>
 
-//TODO: 各関数で似た処理が登場している場合は共通の処理をまとめる(無名名前空間、static)
+namespace
+{
+	/// @brief `value`が`{ "type": typeName, ... }`の形式かを調べます。
+	[[nodiscard]]
+	static bool HasType(const JSON& value, const StringView typeName)
+	{
+		return (value.isObject() && value.contains(U"type") && value[U"type"].isString() && (value[U"type"].getString() == typeName));
+	}
+
+	/// @brief `value`の`key`の数値を取得します。
+	[[nodiscard]]
+	static Optional<double> GetNumber(const JSON& value, const StringView key)
+	{
+		if (not value.contains(key))
+		{
+			return none;
+		}
+
+		const auto& number = value[key];
+
+		if (not number.isNumber())
+		{
+			return none;
+		}
+
+		return number.get<double>();
+	}
+
+	/// @brief 数値を int32 に変換します。
+	/// @return 変換した値。整数でないか、int32 の範囲外の場合は none
+	[[nodiscard]]
+	static Optional<int32> ToInt32(const double number) noexcept
+	{
+		// NaN は比較が全て false になるため、ここで除かれます。
+		if ((not ((std::numeric_limits<int32>::min() <= number) && (number <= std::numeric_limits<int32>::max())))
+			|| (std::trunc(number) != number))
+		{
+			return none;
+		}
+
+		return static_cast<int32>(number);
+	}
+
+	/// @brief `json`の`key`の値を Type に変換します。
+	template <class Type>
+	[[nodiscard]]
+	static Optional<Type> Read(const JSON& json, const StringView key)
+	{
+		if (not json.contains(key))
+		{
+			return none;
+		}
+
+		return JSONParser::Decode<Type>(json[key]);
+	}
+
+	/// @brief JSONStreamReader から読み込んだ`{ "type": ..., ... }`の形式の値です。
+	struct StreamValue
+	{
+		/// @brief 数値の成分のキー
+		static constexpr std::array<std::string_view, 6> ComponentKeys = { "x", "y", "r", "g", "b", "a" };
+
+		String type;
+
+		/// @brief "value" が数値の場合の値
+		Optional<double> number;
+
+		/// @brief "value" が文字列の場合の値
+		Optional<String> string;
+
+		/// @brief "value" が真偽値の場合の値
+		Optional<bool> boolean;
+
+		/// @brief ComponentKeys の各キーの数値
+		std::array<Optional<double>, ComponentKeys.size()> components;
+
+		[[nodiscard]]
+		Optional<double> component(const std::string_view key) const
+		{
+			for (size_t i = 0; i < ComponentKeys.size(); ++i)
+			{
+				if (ComponentKeys[i] == key)
+				{
+					return components[i];
+				}
+			}
+
+			return none;
+		}
+	};
+
+	/// @brief `{ "type": ..., ... }`の形式の値を読み込みます。知らないキーは読み飛ばします。
+	[[nodiscard]]
+	static Optional<StreamValue> ReadStreamValue(JSONStreamReader& reader)
+	{
+		using Token = JSONStreamReader::Token;
+
+		if (reader.token() != Token::BeginObject)
+		{
+			reader.skipValue();
+			return none;
+		}
+
+		StreamValue value;
+
+		while (reader.next() == Token::Key)
+		{
+			const bool isType = reader.equals("type");
+			const bool isValue = reader.equals("value");
+			size_t componentIndex = StreamValue::ComponentKeys.size();
+
+			for (size_t i = 0; i < StreamValue::ComponentKeys.size(); ++i)
+			{
+				if (reader.equals(StreamValue::ComponentKeys[i]))
+				{
+					componentIndex = i;
+					break;
+				}
+			}
+
+			switch (reader.next())
+			{
+			case Token::String:
+				if (isType)
+				{
+					value.type = reader.getString();
+				}
+				else if (isValue)
+				{
+					value.string = reader.getString();
+				}
+				break;
+			case Token::Number:
+				if (isValue)
+				{
+					value.number = reader.getNumber();
+				}
+				else if (componentIndex < StreamValue::ComponentKeys.size())
+				{
+					value.components[componentIndex] = reader.getNumber();
+				}
+				break;
+			case Token::Bool:
+				if (isValue)
+				{
+					value.boolean = reader.getBool();
+				}
+				break;
+			default:
+				if (not reader.skipValue())
+				{
+					return none;
+				}
+				break;
+			}
+		}
+
+		if (reader.token() != Token::EndObject)
+		{
+			return none;
+		}
+
+		return value;
+	}
+
+	/// @brief 数値を並べた配列の要素の型の情報です。
+	template <class Type>
+	struct PackedArrayTraits;
+
+	template <>
+	struct PackedArrayTraits<double>
+	{
+		static constexpr StringView TypeName = U"double[]";
+
+		static constexpr size_t NumComponents = 1;
+	};
+
+	template <>
+	struct PackedArrayTraits<Vec2>
+	{
+		static constexpr StringView TypeName = U"Vec2[]";
+
+		static constexpr size_t NumComponents = 2;
+	};
+
+	template <>
+	struct PackedArrayTraits<ColorF>
+	{
+		static constexpr StringView TypeName = U"ColorF[]";
+
+		static constexpr size_t NumComponents = 4;
+	};
+
+	/// @brief 成分を並べた数値の配列を、Type の配列に変換します。
+	template <class Type>
+	[[nodiscard]]
+	static Optional<Array<Type>> FromComponents(Array<double>&& components)
+	{
+		constexpr size_t NumComponents = PackedArrayTraits<Type>::NumComponents;
+
+		if ((components.size() % NumComponents) != 0)
+		{
+			return none;
+		}
+
+		if constexpr (std::is_same_v<Type, double>)
+		{
+			return std::move(components);
+		}
+		else
+		{
+			Array<Type> result(components.size() / NumComponents);
+			const double* p = components.data();
+
+			for (auto& element : result)
+			{
+				if constexpr (std::is_same_v<Type, Vec2>)
+				{
+					element = Vec2{ p[0], p[1] };
+				}
+				else
+				{
+					element = ColorF{ p[0], p[1], p[2], p[3] };
+				}
+
+				p += NumComponents;
+			}
+
+			return result;
+		}
+	}
+
+	/// @brief `{ "type": "Vec2[]", "data": ... }`の形式の値を配列に変換します。
+	template <class Type>
+	[[nodiscard]]
+	static Optional<Array<Type>> DecodePackedArray(const JSON& value)
+	{
+		if (not HasType(value, PackedArrayTraits<Type>::TypeName) || not value.contains(U"data"))
+		{
+			return none;
+		}
+
+		const JSON data = value[U"data"];
+		Array<double> components;
+
+		if (data.isString())
+		{
+			// 文字列の場合は要素ごとの JSON を作らずにまとめて読み込みます。
+			if (not JSONParser::ParseNumbers(Unicode::ToUTF8(data.getString()), components))
+			{
+				return none;
+			}
+		}
+		else if (data.isArray())
+		{
+			components.reserve(data.size());
+
+			for (const auto& element : data.arrayView())
+			{
+				if (not element.isNumber())
+				{
+					return none;
+				}
+
+				components << element.get<double>();
+			}
+		}
+		else
+		{
+			return none;
+		}
+
+		return FromComponents<Type>(std::move(components));
+	}
+
+	/// @brief JSONStreamReader から`{ "type": "Vec2[]", "data": ... }`の形式の値を読み込み、配列に変換します。
+	template <class Type>
+	[[nodiscard]]
+	static Optional<Array<Type>> DecodePackedArray(JSONStreamReader& reader)
+	{
+		using Token = JSONStreamReader::Token;
+
+		if (reader.token() != Token::BeginObject)
+		{
+			reader.skipValue();
+			return none;
+		}
+
+		bool hasType = false;
+		bool hasData = false;
+		Array<double> components;
+
+		while (reader.next() == Token::Key)
+		{
+			const bool isType = reader.equals("type");
+			const bool isData = reader.equals("data");
+			const Token token = reader.next();
+
+			if (isType && (token == Token::String))
+			{
+				hasType = (reader.getString() == PackedArrayTraits<Type>::TypeName);
+			}
+			else if (isData && (token == Token::BeginArray))
+			{
+				// 数値を読むたびに配列の末尾へ追加します。
+				while (reader.next() == Token::Number)
+				{
+					components << reader.getNumber();
+				}
+
+				if (reader.token() != Token::EndArray)
+				{
+					return none;
+				}
+
+				hasData = true;
+			}
+			else if (isData && (token == Token::String))
+			{
+				// 読み込み元のメモリを直接読むため、文字列を変換しません。
+				if (not JSONParser::ParseNumbers(reader.getRawString(), components))
+				{
+					return none;
+				}
+
+				hasData = true;
+			}
+			else if (not reader.skipValue())
+			{
+				return none;
+			}
+		}
+
+		if ((reader.token() != Token::EndObject) || not hasType || not hasData)
+		{
+			return none;
+		}
+
+		return FromComponents<Type>(std::move(components));
+	}
+}
 
 /// @brief JSONを型ごとにパースします。
 namespace JSONParser
 {
 	Optional<int32> ReadInt32(const JSON& json, StringView key)
 	{
-		if (not json.contains(key) || not json[key].isObject())
+		return Read<int32>(json, key);
+	}
+
+	Optional<double> ReadDouble(const JSON& json, StringView key)
+	{
+		return Read<double>(json, key);
+	}
+
+	Optional<Vec2> ReadVec2(const JSON& json, StringView key)
+	{
+		return Read<Vec2>(json, key);
+	}
+
+	Optional<ColorF> ReadColorF(const JSON& json, StringView key)
+	{
+		return Read<ColorF>(json, key);
+	}
+
+	Optional<String> ReadString(const JSON& json, StringView key)
+	{
+		return Read<String>(json, key);
+	}
+
+	Optional<bool> ReadBool(const JSON& json, StringView key)
+	{
+		return Read<bool>(json, key);
+	}
+
+	bool ParseNumbers(const std::string_view text, Array<double>& numbers)
+	{
+		// 区切りの数から要素数を見積もり、再確保を減らします。
+		numbers.reserve(numbers.size() + static_cast<size_t>(std::count(text.begin(), text.end(), ',')) + 1);
+
+		const char* p = text.data();
+		const char* const end = (text.data() + text.size());
+
+		for (;;)
+		{
+			while ((p != end) && ((*p == ' ') || (*p == ',') || (*p == '\t') || (*p == '\n') || (*p == '\r')))
+			{
+				++p;
+			}
+
+			if (p == end)
+			{
+				return true;
+			}
+
+			double value;
+			const auto result = std::from_chars(p, end, value);
+
+			if (result.ec != std::errc{})
+			{
+				return false;
+			}
+
+			numbers << value;
+			p = result.ptr;
+		}
+	}
+
+	template <>
+	Optional<int32> Decode<int32>(const JSON& value)
+	{
+		if (not HasType(value, U"int") || not value.contains(U"value") || not value[U"value"].isNumber())
 		{
 			return none;
 		}
 
-		const auto& i = json[key];
-		if (not i.contains(U"type") || not i[U"type"].isString() || i[U"type"] != U"int" ||
-						not i.contains(U"value") || not i[U"value"].isNumber())
+		return ToInt32(value[U"value"].get<double>());
+	}
+
+	template <>
+	Optional<double> Decode<double>(const JSON& value)
+	{
+		if (not HasType(value, U"double"))
 		{
 			return none;
 		}
 
-		return i[U"value"].get<int32>();
+		return GetNumber(value, U"value");
 	}
 
-	Optional<double> ReadDouble(const JSON& json, StringView key)
+	template <>
+	Optional<Vec2> Decode<Vec2>(const JSON& value)
 	{
-		if (not json.contains(key) || not json[key].isObject())
+		if (not HasType(value, U"Vec2"))
 		{
 			return none;
 		}
 
-		const auto& d = json[key];
-		if (not d.contains(U"type") || not d[U"type"].isString() || d[U"type"] != U"double" ||
-			not d.contains(U"value") || not d[U"value"].isNumber())
+		const auto x = GetNumber(value, U"x");
+		const auto y = GetNumber(value, U"y");
+
+		if (not x || not y)
 		{
 			return none;
 		}
 
-		return d[U"value"].get<double>();
+		return Vec2{ *x, *y };
 	}
 
-	Optional<Vec2> ReadVec2(const JSON& json, StringView key)
+	template <>
+	Optional<ColorF> Decode<ColorF>(const JSON& value)
 	{
-		if (not json.contains(key) || not json[key].isObject())
+		//ColorF の体裁で json ファイルが記述されているか調べる。
+		if (not HasType(value, U"ColorF"))
 		{
 			return none;
 		}
 
-		const auto& vec2 = json[key];
-		if (not vec2.contains(U"type") || not vec2[U"type"].isString() || vec2[U"type"] != U"Vec2" ||
-			not vec2.contains(U"x") || not vec2[U"x"].isNumber() ||
-			not vec2.contains(U"y") || not vec2[U"y"].isNumber())
+		const auto r = GetNumber(value, U"r");
+		const auto g = GetNumber(value, U"g");
+		const auto b = GetNumber(value, U"b");
+
+		if (not r || not g || not b)
 		{
 			return none;
 		}
 
-		return Vec2{ vec2[U"x"].get<double>(),vec2[U"y"].get<double>() };
+		//alpha 成分を記述していなかった場合 1.0 にする
+		return ColorF{ *r, *g, *b, GetNumber(value, U"a").value_or(1.0) };
 	}
 
-	Optional<ColorF> ReadColorF(const JSON& json, StringView key)
+	template <>
+	Optional<String> Decode<String>(const JSON& value)
 	{
-		if (not json.contains(key) || not json[key].isObject())
+		if (not HasType(value, U"String") || not value.contains(U"value") || not value[U"value"].isString())
 		{
 			return none;
 		}
 
-		//ColorF の体裁で json ファイルが記述されているか調べる。
-		const auto& color = json[key];
-		if (not color.contains(U"type") || not color[U"type"].isString() || color[U"type"] != U"ColorF" ||
-			not color.contains(U"r") || not color[U"r"].isNumber() ||
-			not color.contains(U"g") || not color[U"g"].isNumber() ||
-			not color.contains(U"b") || not color[U"b"].isNumber())
+		return value[U"value"].getString();
+	}
+
+	template <>
+	Optional<bool> Decode<bool>(const JSON& value)
+	{
+		if (not HasType(value, U"bool") || not value.contains(U"value") || not value[U"value"].isBool())
 		{
 			return none;
 		}
 
-		//alpha 成分を記述していなかった場合 1.0 にする
-		double alpha = 1.0;
-		if (color.contains(U"a") && color[U"a"].isNumber())
+		return value[U"value"].get<bool>();
+	}
+
+	template <>
+	Optional<int32> Decode<int32>(JSONStreamReader& reader)
+	{
+		const auto value = ReadStreamValue(reader);
+
+		if (not value || (value->type != U"int") || not value->number)
 		{
-			alpha = color[U"a"].get<double>();
+			return none;
 		}
 
-		return ColorF{ color[U"r"].get<double>(),color[U"g"].get<double>() ,color[U"b"].get<double>() ,alpha };
+		return ToInt32(*value->number);
 	}
 
-	Optional<String> ReadString(const JSON& json, StringView key)
+	template <>
+	Optional<double> Decode<double>(JSONStreamReader& reader)
+	{
+		const auto value = ReadStreamValue(reader);
+
+		if (not value || (value->type != U"double"))
+		{
+			return none;
+		}
+
+		return value->number;
+	}
+
+	template <>
+	Optional<Vec2> Decode<Vec2>(JSONStreamReader& reader)
 	{
-		if (not json.contains(key) || not json[key].isObject())
+		const auto value = ReadStreamValue(reader);
+
+		if (not value || (value->type != U"Vec2"))
 		{
 			return none;
 		}
 
-		const auto& s = json[key];
-		if (not s.contains(U"type") || not s[U"type"].isString() || s[U"type"] != U"String" ||
-						not s.contains(U"value") || not s[U"value"].isString())
+		const auto x = value->component("x");
+		const auto y = value->component("y");
+
+		if (not x || not y)
 		{
 			return none;
 		}
 
-		return s[U"value"].getString();
+		return Vec2{ *x, *y };
 	}
 
-	Optional<bool> ReadBool(const JSON& json, StringView key)
+	template <>
+	Optional<ColorF> Decode<ColorF>(JSONStreamReader& reader)
+	{
+		const auto value = ReadStreamValue(reader);
+
+		if (not value || (value->type != U"ColorF"))
+		{
+			return none;
+		}
+
+		const auto r = value->component("r");
+		const auto g = value->component("g");
+		const auto b = value->component("b");
+
+		if (not r || not g || not b)
+		{
+			return none;
+		}
+
+		//alpha 成分を記述していなかった場合 1.0 にする
+		return ColorF{ *r, *g, *b, value->component("a").value_or(1.0) };
+	}
+
+	template <>
+	Optional<String> Decode<String>(JSONStreamReader& reader)
 	{
-		if (not json.contains(key) || not json[key].isObject())
+		const auto value = ReadStreamValue(reader);
+
+		if (not value || (value->type != U"String"))
 		{
 			return none;
 		}
 
-		const auto& b = json[key];
-		if (not b.contains(U"type") || not b[U"type"].isString() || b[U"type"] != U"bool" ||
-									not b.contains(U"value") || not b[U"value"].isBool())
+		return value->string;
+	}
+
+	template <>
+	Optional<bool> Decode<bool>(JSONStreamReader& reader)
+	{
+		const auto value = ReadStreamValue(reader);
+
+		if (not value || (value->type != U"bool"))
 		{
 			return none;
 		}
 
-		return b[U"value"].get<bool>();
+		return value->boolean;
+	}
+
+	template <>
+	Optional<Array<double>> Decode<Array<double>>(const JSON& value)
+	{
+		return DecodePackedArray<double>(value);
+	}
+
+	template <>
+	Optional<Array<Vec2>> Decode<Array<Vec2>>(const JSON& value)
+	{
+		return DecodePackedArray<Vec2>(value);
+	}
+
+	template <>
+	Optional<Array<ColorF>> Decode<Array<ColorF>>(const JSON& value)
+	{
+		return DecodePackedArray<ColorF>(value);
+	}
+
+	template <>
+	Optional<Array<double>> Decode<Array<double>>(JSONStreamReader& reader)
+	{
+		return DecodePackedArray<double>(reader);
+	}
+
+	template <>
+	Optional<Array<Vec2>> Decode<Array<Vec2>>(JSONStreamReader& reader)
+	{
+		return DecodePackedArray<Vec2>(reader);
+	}
+
+	template <>
+	Optional<Array<ColorF>> Decode<Array<ColorF>>(JSONStreamReader& reader)
+	{
+		return DecodePackedArray<ColorF>(reader);
 	}
 }
@@ -1,5 +1,6 @@
 ﻿# pragma once
 # include <Siv3D.hpp>
+# include "JSONStreamReader.hpp"
 
 /// @brief JSONを型ごとにパースします。
 namespace JSONParser
@@ -45,5 +46,120 @@ namespace JSONParser
 	/// @return 変換したboolを返します。失敗した場合、無効値を返します。
 	[[nodiscard]]
 	Optional<bool> ReadBool(const JSON& json, StringView key);
-	 
+
+	/// @brief `json`から`{ "type": "Vec2[]", "data": [x0, y0, x1, y1, ...] }`の形式の配列に変換します。
+	/// @tparam Type double, Vec2, ColorF のいずれかです。型名はそれぞれ "double[]", "Vec2[]", "ColorF[]" で、ColorF は r, g, b, a の 4 成分を並べます。
+	/// @param json `key`を持っている`json`ファイルを渡します。
+	/// @param key 変換したい`key`を渡します。
+	/// @return 変換した配列を返します。失敗した場合、無効値を返します。
+	/// @remark "data" は数値の配列のほか、`"x0 y0 x1 y1 ..."`のように空白か`,`で区切った数値の文字列でも書けます。要素の多い配列は文字列の方が高速に読み込めます。
+	template <class Type>
+	[[nodiscard]]
+	Optional<Array<Type>> ReadArray(const JSON& json, StringView key);
+
+	/// @brief 空白か`,`で区切られた数値の文字列を読み込みます。
+	/// @param text 数値の文字列を渡します。
+	/// @param numbers 読み込んだ数値を末尾に追加します。
+	/// @return 全て読み込めた場合 true, 数値でない文字がある場合は false を返します。
+	[[nodiscard]]
+	bool ParseNumbers(std::string_view text, Array<double>& numbers);
+
+	/// @brief `{ "type": ..., ... }`の形式の値を Type に変換します。
+	/// @tparam Type int32, double, Vec2, ColorF, String, bool, Array<double>, Array<Vec2>, Array<ColorF> のいずれかです。
+	/// @param value 変換したい値を渡します。
+	/// @return 変換した値を返します。失敗した場合、無効値を返します。
+	template <class Type>
+	[[nodiscard]]
+	Optional<Type> Decode(const JSON& value);
+
+	template <>
+	[[nodiscard]]
+	Optional<int32> Decode<int32>(const JSON& value);
+
+	template <>
+	[[nodiscard]]
+	Optional<double> Decode<double>(const JSON& value);
+
+	template <>
+	[[nodiscard]]
+	Optional<Vec2> Decode<Vec2>(const JSON& value);
+
+	template <>
+	[[nodiscard]]
+	Optional<ColorF> Decode<ColorF>(const JSON& value);
+
+	template <>
+	[[nodiscard]]
+	Optional<String> Decode<String>(const JSON& value);
+
+	template <>
+	[[nodiscard]]
+	Optional<bool> Decode<bool>(const JSON& value);
+
+	template <>
+	[[nodiscard]]
+	Optional<Array<double>> Decode<Array<double>>(const JSON& value);
+
+	template <>
+	[[nodiscard]]
+	Optional<Array<Vec2>> Decode<Array<Vec2>>(const JSON& value);
+
+	template <>
+	[[nodiscard]]
+	Optional<Array<ColorF>> Decode<Array<ColorF>>(const JSON& value);
+
+	/// @brief `{ "type": ..., ... }`の形式の値を、JSONStreamReader から読み込んで Type に変換します。
+	/// @tparam Type int32, double, Vec2, ColorF, String, bool, Array<double>, Array<Vec2>, Array<ColorF> のいずれかです。
+	/// @param reader 値の先頭のトークンを指している JSONStreamReader を渡します。値の最後のトークンまで読み進めます。
+	/// @return 変換した値を返します。失敗した場合、無効値を返します。
+	template <class Type>
+	[[nodiscard]]
+	Optional<Type> Decode(JSONStreamReader& reader);
+
+	template <>
+	[[nodiscard]]
+	Optional<int32> Decode<int32>(JSONStreamReader& reader);
+
+	template <>
+	[[nodiscard]]
+	Optional<double> Decode<double>(JSONStreamReader& reader);
+
+	template <>
+	[[nodiscard]]
+	Optional<Vec2> Decode<Vec2>(JSONStreamReader& reader);
+
+	template <>
+	[[nodiscard]]
+	Optional<ColorF> Decode<ColorF>(JSONStreamReader& reader);
+
+	template <>
+	[[nodiscard]]
+	Optional<String> Decode<String>(JSONStreamReader& reader);
+
+	template <>
+	[[nodiscard]]
+	Optional<bool> Decode<bool>(JSONStreamReader& reader);
+
+	template <>
+	[[nodiscard]]
+	Optional<Array<double>> Decode<Array<double>>(JSONStreamReader& reader);
+
+	template <>
+	[[nodiscard]]
+	Optional<Array<Vec2>> Decode<Array<Vec2>>(JSONStreamReader& reader);
+
+	template <>
+	[[nodiscard]]
+	Optional<Array<ColorF>> Decode<Array<ColorF>>(JSONStreamReader& reader);
+
+	template <class Type>
+	Optional<Array<Type>> ReadArray(const JSON& json, const StringView key)
+	{
+		if (not json.contains(key))
+		{
+			return none;
+		}
+
+		return Decode<Array<Type>>(json[key]);
+	}
 }
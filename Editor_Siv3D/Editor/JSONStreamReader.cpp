@@ -0,0 +1,433 @@
+﻿# include "JSONStreamReader.hpp"
+# include <charconv>
+
+namespace
+{
+	/// @brief UTF-8 の BOM
+	constexpr std::string_view UTF8BOM = "\xEF\xBB\xBF";
+
+	[[nodiscard]]
+	static constexpr bool IsDigit(const char ch) noexcept
+	{
+		return (('0' <= ch) && (ch <= '9'));
+	}
+
+	/// @brief JSON の数値の文法（`-? (0 | [1-9][0-9]*) (.[0-9]+)? ([eE][+-]?[0-9]+)?`）で読める範囲の終わりを返します。
+	/// @return 数値の終わり。文法に合わない場合は nullptr
+	[[nodiscard]]
+	static const char* ScanNumber(const char* p, const char* end) noexcept
+	{
+		if ((p != end) && (*p == '-'))
+		{
+			++p;
+		}
+
+		if ((p == end) || (not IsDigit(*p)))
+		{
+			return nullptr;
+		}
+
+		// 先頭の 0 の後ろには数字を続けられません。
+		if (*p++ == '0')
+		{
+			if ((p != end) && IsDigit(*p))
+			{
+				return nullptr;
+			}
+		}
+		else
+		{
+			while ((p != end) && IsDigit(*p))
+			{
+				++p;
+			}
+		}
+
+		if ((p != end) && (*p == '.'))
+		{
+			if ((++p == end) || (not IsDigit(*p)))
+			{
+				return nullptr;
+			}
+
+			while ((p != end) && IsDigit(*p))
+			{
+				++p;
+			}
+		}
+
+		if ((p != end) && ((*p == 'e') || (*p == 'E')))
+		{
+			if ((++p != end) && ((*p == '+') || (*p == '-')))
+			{
+				++p;
+			}
+
+			if ((p == end) || (not IsDigit(*p)))
+			{
+				return nullptr;
+			}
+
+			while ((p != end) && IsDigit(*p))
+			{
+				++p;
+			}
+		}
+
+		return p;
+	}
+
+	[[nodiscard]]
+	static Optional<char32> ParseHex4(const char* p) noexcept
+	{
+		uint32 value = 0;
+
+		if (const auto result = std::from_chars(p, (p + 4), value, 16); ((result.ec != std::errc{}) || (result.ptr != (p + 4))))
+		{
+			return none;
+		}
+
+		return static_cast<char32>(value);
+	}
+
+	/// @brief エスケープを解除し、UTF-8 のまま返します。
+	[[nodiscard]]
+	static std::string Unescape(const std::string_view text)
+	{
+		std::string result;
+		result.reserve(text.size());
+
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			if (text[i] != '\\')
+			{
+				result.push_back(text[i]);
+				continue;
+			}
+
+			// readText() で、バックスラッシュの後ろに 1 文字あることを確かめています。
+			switch (const char ch = text[++i])
+			{
+			case 'b': result.push_back('\b'); break;
+			case 'f': result.push_back('\f'); break;
+			case 'n': result.push_back('\n'); break;
+			case 'r': result.push_back('\r'); break;
+			case 't': result.push_back('\t'); break;
+			case 'u':
+				{
+					if ((text.size() - i) <= 4)
+					{
+						return result;
+					}
+
+					char32 codePoint = ParseHex4(text.data() + i + 1).value_or(U'\uFFFD');
+					i += 4;
+
+					// サロゲートペアを 1 つのコードポイントにまとめます。
+					if ((0xD800 <= codePoint) && (codePoint < 0xDC00) && ((text.size() - i) > 6) && (text[i + 1] == '\\') && (text[i + 2] == 'u'))
+					{
+						if (const auto low = ParseHex4(text.data() + i + 3); (low && (0xDC00 <= *low) && (*low < 0xE000)))
+						{
+							codePoint = (0x10000 + ((codePoint - 0xD800) << 10) + (*low - 0xDC00));
+							i += 6;
+						}
+					}
+
+					result += Unicode::ToUTF8(StringView{ &codePoint, 1 });
+					break;
+				}
+			default: result.push_back(ch); break;
+			}
+		}
+
+		return result;
+	}
+}
+
+JSONStreamReader::JSONStreamReader(const void* data, const size_t size) noexcept
+	: m_current{ static_cast<const char*>(data) }
+	, m_end{ (static_cast<const char*>(data) + size) }
+{
+	if (std::string_view{ m_current, size }.starts_with(UTF8BOM))
+	{
+		m_current += UTF8BOM.size();
+	}
+}
+
+JSONStreamReader::JSONStreamReader(const Blob& blob) noexcept
+	: JSONStreamReader{ blob.data(), blob.size() } {}
+
+JSONStreamReader::Token JSONStreamReader::next()
+{
+	if ((m_token == Token::End) || (m_token == Token::Error))
+	{
+		return m_token;
+	}
+
+	skipWhitespace();
+
+	// 最初のトークン
+	if (m_token == Token::None)
+	{
+		return readValue();
+	}
+
+	// 最上位の値を読み終えた後は、空白以外があってはいけません。
+	if (not m_containers)
+	{
+		return (m_token = ((m_current == m_end) ? Token::End : Token::Error));
+	}
+
+	if (m_current == m_end)
+	{
+		return fail();
+	}
+
+	const bool inObject = (m_containers.back() == '{');
+
+	if (m_token == Token::Key)
+	{
+		if (*m_current != ':')
+		{
+			return fail();
+		}
+
+		++m_current;
+		skipWhitespace();
+		return readValue();
+	}
+
+	const char closing = (inObject ? '}' : ']');
+
+	if (*m_current == closing)
+	{
+		return close();
+	}
+
+	// オブジェクトか配列の最初の要素でなければ、区切りの `,` があるはずです。
+	if ((m_token != Token::BeginObject) && (m_token != Token::BeginArray))
+	{
+		if (*m_current != ',')
+		{
+			return fail();
+		}
+
+		++m_current;
+		skipWhitespace();
+	}
+
+	return (inObject ? readKey() : readValue());
+}
+
+JSONStreamReader::Token JSONStreamReader::token() const noexcept
+{
+	return m_token;
+}
+
+String JSONStreamReader::getString() const
+{
+	if (m_hasEscape)
+	{
+		return Unicode::FromUTF8(Unescape(m_text));
+	}
+
+	return Unicode::FromUTF8(m_text);
+}
+
+std::string_view JSONStreamReader::getRawString() const noexcept
+{
+	return m_text;
+}
+
+bool JSONStreamReader::equals(const std::string_view text) const noexcept
+{
+	return ((not m_hasEscape) && (m_text == text));
+}
+
+double JSONStreamReader::getNumber() const noexcept
+{
+	return m_number;
+}
+
+bool JSONStreamReader::getBool() const noexcept
+{
+	return m_bool;
+}
+
+bool JSONStreamReader::skipValue()
+{
+	if ((m_token != Token::BeginObject) && (m_token != Token::BeginArray))
+	{
+		return (not hasError());
+	}
+
+	const size_t depth = m_containers.size();
+
+	while (depth <= m_containers.size())
+	{
+		if (const Token token = next(); ((token == Token::Error) || (token == Token::End)))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool JSONStreamReader::hasError() const noexcept
+{
+	return (m_token == Token::Error);
+}
+
+Optional<String> JSONStreamReader::PeekDataType(const void* data, const size_t size)
+{
+	JSONStreamReader reader{ data, size };
+
+	if (reader.next() != Token::BeginObject)
+	{
+		return none;
+	}
+
+	while (reader.next() == Token::Key)
+	{
+		const bool isDataType = reader.equals("dataType");
+
+		reader.next();
+
+		if (isDataType)
+		{
+			return ((reader.token() == Token::String) ? Optional<String>{ reader.getString() } : none);
+		}
+
+		if (not reader.skipValue())
+		{
+			return none;
+		}
+	}
+
+	return none;
+}
+
+JSONStreamReader::Token JSONStreamReader::readValue()
+{
+	if (m_current == m_end)
+	{
+		return fail();
+	}
+
+	switch (*m_current)
+	{
+	case '{':
+		++m_current;
+		m_containers << '{';
+		return (m_token = Token::BeginObject);
+	case '[':
+		++m_current;
+		m_containers << '[';
+		return (m_token = Token::BeginArray);
+	case '"':
+		return (readText() ? (m_token = Token::String) : fail());
+	case 't':
+		m_bool = true;
+		return readLiteral("true", Token::Bool);
+	case 'f':
+		m_bool = false;
+		return readLiteral("false", Token::Bool);
+	case 'n':
+		return readLiteral("null", Token::Null);
+	default:
+		return readNumber();
+	}
+}
+
+JSONStreamReader::Token JSONStreamReader::readKey()
+{
+	if ((m_current == m_end) || (*m_current != '"') || (not readText()))
+	{
+		return fail();
+	}
+
+	return (m_token = Token::Key);
+}
+
+bool JSONStreamReader::readText()
+{
+	const char* begin = ++m_current;
+	m_hasEscape = false;
+
+	for (; m_current != m_end; ++m_current)
+	{
+		if (*m_current == '"')
+		{
+			m_text = std::string_view{ begin, static_cast<size_t>(m_current - begin) };
+			++m_current;
+			return true;
+		}
+
+		if (*m_current == '\\')
+		{
+			m_hasEscape = true;
+
+			// エスケープされた文字を読み飛ばします。
+			if (++m_current == m_end)
+			{
+				return false;
+			}
+		}
+	}
+
+	return false;
+}
+
+JSONStreamReader::Token JSONStreamReader::readNumber()
+{
+	// from_chars は inf や nan、先頭に 0 が続く数値も読むため、先に JSON の数値の文法で範囲を決めます。
+	const char* numberEnd = ScanNumber(m_current, m_end);
+
+	if (not numberEnd)
+	{
+		return fail();
+	}
+
+	const auto result = std::from_chars(m_current, numberEnd, m_number);
+
+	if ((result.ec != std::errc{}) || (result.ptr != numberEnd))
+	{
+		return fail();
+	}
+
+	m_current = numberEnd;
+	return (m_token = Token::Number);
+}
+
+JSONStreamReader::Token JSONStreamReader::readLiteral(const std::string_view literal, const Token token)
+{
+	if (not std::string_view{ m_current, static_cast<size_t>(m_end - m_current) }.starts_with(literal))
+	{
+		return fail();
+	}
+
+	m_current += literal.size();
+	return (m_token = token);
+}
+
+JSONStreamReader::Token JSONStreamReader::close()
+{
+	const Token token = ((m_containers.back() == '{') ? Token::EndObject : Token::EndArray);
+	m_containers.pop_back();
+	++m_current;
+	return (m_token = token);
+}
+
+void JSONStreamReader::skipWhitespace() noexcept
+{
+	while ((m_current != m_end) && ((*m_current == ' ') || (*m_current == '\t') || (*m_current == '\n') || (*m_current == '\r')))
+	{
+		++m_current;
+	}
+}
+
+JSONStreamReader::Token JSONStreamReader::fail() noexcept
+{
+	return (m_token = Token::Error);
+}
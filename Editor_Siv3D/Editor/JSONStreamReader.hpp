@@ -0,0 +1,151 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+
+/// @brief UTF-8 の JSON テキストを、DOM を作らずに先頭から 1 トークンずつ読み進めます。
+/// @remark 文字列は、getString() を呼ぶまで変換しません。読み込み元のメモリは JSONStreamReader より長く存在する必要があります。
+class JSONStreamReader
+{
+public:
+	/// @brief トークンの種類
+	enum class Token : uint8
+	{
+		/// @brief まだ読み進めていない
+		None,
+
+		/// @brief `{`
+		BeginObject,
+
+		/// @brief `}`
+		EndObject,
+
+		/// @brief `[`
+		BeginArray,
+
+		/// @brief `]`
+		EndArray,
+
+		/// @brief オブジェクトのキー
+		Key,
+
+		/// @brief 文字列
+		String,
+
+		/// @brief 数値
+		Number,
+
+		/// @brief true または false
+		Bool,
+
+		/// @brief null
+		Null,
+
+		/// @brief テキストの終端
+		End,
+
+		/// @brief 不正な JSON
+		Error,
+	};
+
+	/// @brief JSONStreamReader を作成します。
+	/// @param data UTF-8 の JSON テキストの先頭
+	/// @param size JSON テキストのサイズ（バイト）
+	JSONStreamReader(const void* data, size_t size) noexcept;
+
+	/// @brief JSONStreamReader を作成します。
+	/// @param blob UTF-8 の JSON テキスト
+	explicit JSONStreamReader(const Blob& blob) noexcept;
+
+	/// @brief 次のトークンに進みます。
+	/// @return 次のトークンの種類
+	Token next();
+
+	/// @brief 現在のトークンの種類を返します。
+	[[nodiscard]]
+	Token token() const noexcept;
+
+	/// @brief 現在のキーまたは文字列を返します。
+	/// @return エスケープを解除した文字列
+	[[nodiscard]]
+	String getString() const;
+
+	/// @brief 現在のキーまたは文字列を、エスケープを解除せずに UTF-8 のまま返します。
+	/// @return 読み込み元のメモリを指す文字列
+	[[nodiscard]]
+	std::string_view getRawString() const noexcept;
+
+	/// @brief 現在のキーまたは文字列が、ASCII 文字列と一致するかを返します。
+	/// @param text 比較する ASCII 文字列
+	/// @return 一致する場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool equals(std::string_view text) const noexcept;
+
+	/// @brief 現在の数値を返します。
+	[[nodiscard]]
+	double getNumber() const noexcept;
+
+	/// @brief 現在の真偽値を返します。
+	[[nodiscard]]
+	bool getBool() const noexcept;
+
+	/// @brief 現在のトークンから始まる値を読み飛ばします。オブジェクトや配列の場合は、対応する終わりのトークンまで進みます。
+	/// @return 読み飛ばせた場合 true, 不正な JSON の場合は false
+	bool skipValue();
+
+	/// @brief 不正な JSON を読んだかを返します。
+	[[nodiscard]]
+	bool hasError() const noexcept;
+
+	/// @brief 最上位のオブジェクトの dataType を読みます。dataType より後ろは読みません。
+	/// @param data UTF-8 の JSON テキストの先頭
+	/// @param size JSON テキストのサイズ（バイト）
+	/// @return dataType。見つからない場合は none
+	[[nodiscard]]
+	static Optional<String> PeekDataType(const void* data, size_t size);
+
+private:
+
+	/// @brief 値の先頭のトークンを読みます。
+	Token readValue();
+
+	/// @brief オブジェクトのキーを読みます。
+	Token readKey();
+
+	/// @brief `"` から始まる文字列を読み、m_text に設定します。
+	[[nodiscard]]
+	bool readText();
+
+	/// @brief 数値を読みます。
+	Token readNumber();
+
+	/// @brief リテラル（true, false, null）を読みます。
+	Token readLiteral(std::string_view literal, Token token);
+
+	/// @brief オブジェクトか配列を閉じます。
+	Token close();
+
+	void skipWhitespace() noexcept;
+
+	Token fail() noexcept;
+
+	const char* m_current = nullptr;
+
+	const char* m_end = nullptr;
+
+	/// @brief 現在のトークン
+	Token m_token = Token::None;
+
+	/// @brief 現在のキーまたは文字列（`"` を含まず、エスケープは解除していません）
+	std::string_view m_text;
+
+	/// @brief m_text がエスケープを含むか
+	bool m_hasEscape = false;
+
+	/// @brief 現在の数値
+	double m_number = 0.0;
+
+	/// @brief 現在の真偽値
+	bool m_bool = false;
+
+	/// @brief 開いているオブジェクト（`{`）と配列（`[`）
+	Array<char> m_containers;
+};
@@ -0,0 +1,223 @@
+﻿# include "LogSink.hpp"
+
+namespace
+{
+	/// @brief ログファイルに書き出す重要度の名前
+	constexpr std::array<std::string_view, 5> LevelNames{ "VERBOSE", "INFO", "SUCCESS", "WARNING", "ERROR" };
+}
+
+LogSink::~LogSink()
+{
+	close();
+}
+
+bool LogSink::open(const Options& options)
+{
+	close();
+
+	m_options = options;
+
+	if ((not FileSystem::Exists(m_options.directory)) && (not FileSystem::CreateDirectories(m_options.directory)))
+	{
+		return false;
+	}
+
+	if (not openFile())
+	{
+		return false;
+	}
+
+	{
+		std::lock_guard lock{ m_mutex };
+		m_stop = false;
+	}
+
+	m_thread = std::thread{ [this] { run(); } };
+	return true;
+}
+
+void LogSink::close()
+{
+	if (not m_thread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard lock{ m_mutex };
+		m_stop = true;
+	}
+
+	m_condition.notify_all();
+	m_thread.join();
+
+	m_writer.close();
+}
+
+bool LogSink::isOpen() const noexcept
+{
+	return m_thread.joinable();
+}
+
+void LogSink::write(const LogLevel level, const StringView message, const std::source_location& location)
+{
+	Entry entry{
+		.time = DateTime::Now(),
+		.level = level,
+		.message = String{ message },
+		.file = location.file_name(),
+		.line = location.line() };
+
+	bool batchFilled = false;
+	{
+		std::lock_guard lock{ m_mutex };
+
+		if (m_stop)
+		{
+			return;
+		}
+
+		// 書き込みが追いつかない場合は、メモリを使い続けないよう新しいログを破棄します。
+		if (m_options.maxPendingEntries <= m_pendingEntries.size())
+		{
+			++m_numDroppedEntries;
+			return;
+		}
+
+		m_pendingEntries << std::move(entry);
+		batchFilled = (m_pendingEntries.size() == m_options.batchSize);
+	}
+
+	// 一定の件数が溜まったときだけ書き込み用のスレッドを起こします。
+	if (batchFilled)
+	{
+		m_condition.notify_one();
+	}
+}
+
+void LogSink::run()
+{
+	Array<Entry> entries;
+	std::string buffer;
+
+	for (;;)
+	{
+		size_t numDroppedEntries = 0;
+		bool stop = false;
+		{
+			std::unique_lock lock{ m_mutex };
+			m_condition.wait_for(lock, std::chrono::milliseconds{ m_options.flushIntervalMillisec },
+				[this] { return (m_stop || (m_options.batchSize <= m_pendingEntries.size())); });
+
+			// 書き込み済みの配列と入れ替えることで、確保した領域を使い回します。
+			entries.swap(m_pendingEntries);
+			numDroppedEntries = std::exchange(m_numDroppedEntries, 0);
+			stop = m_stop;
+		}
+
+		buffer.clear();
+
+		if (numDroppedEntries != 0)
+		{
+			const auto location = std::source_location::current();
+			AppendEntry(buffer, Entry{ .time = DateTime::Now(), .level = LogLevel::Warning,
+				.message = U"書き込みが追いつかないため、{} 件のログを破棄しました。"_fmt(numDroppedEntries),
+				.file = location.file_name(), .line = location.line() });
+		}
+
+		for (const auto& entry : entries)
+		{
+			AppendEntry(buffer, entry);
+		}
+
+		entries.clear();
+
+		if (not buffer.empty())
+		{
+			if ((0 < m_writer.size()) && (m_options.maxFileSize < (m_writer.size() + static_cast<int64>(buffer.size()))))
+			{
+				rotate();
+			}
+
+			m_writer.write(buffer.data(), static_cast<int64>(buffer.size()));
+			m_writer.flush();
+		}
+
+		if (stop)
+		{
+			return;
+		}
+	}
+}
+
+bool LogSink::openFile()
+{
+	m_writer = BinaryWriter{ filePath(0), OpenMode::Append };
+
+	if (not m_writer)
+	{
+		return false;
+	}
+
+	if (m_options.maxFileSize <= m_writer.size())
+	{
+		rotate();
+	}
+
+	return m_writer.isOpen();
+}
+
+void LogSink::rotate()
+{
+	m_writer.close();
+
+	// 最も古いファイルを削除し、残りのファイルの番号を 1 つずつずらします。
+	if (const FilePath oldest = filePath(Max<size_t>(m_options.maxFiles, 1) - 1); FileSystem::Exists(oldest))
+	{
+		FileSystem::Remove(oldest);
+	}
+
+	for (size_t i = (Max<size_t>(m_options.maxFiles, 1) - 1); 0 < i; --i)
+	{
+		if (const FilePath from = filePath(i - 1); FileSystem::Exists(from))
+		{
+			FileSystem::Rename(from, filePath(i));
+		}
+	}
+
+	m_writer = BinaryWriter{ filePath(0), OpenMode::Append };
+}
+
+FilePath LogSink::filePath(const size_t index) const
+{
+	if (index == 0)
+	{
+		return FileSystem::PathAppend(m_options.directory, (m_options.baseName + U".log"));
+	}
+
+	return FileSystem::PathAppend(m_options.directory, U"{}.{}.log"_fmt(m_options.baseName, index));
+}
+
+void LogSink::AppendEntry(std::string& buffer, const Entry& entry)
+{
+	buffer += entry.time.format(U"yyyy-MM-dd HH:mm:ss.SSS").toUTF8();
+	buffer += '\t';
+	buffer += LevelNames[FromEnum(entry.level)];
+	buffer += '\t';
+
+	// ソースファイルはファイル名だけを残します。
+	const std::string_view file{ entry.file };
+	const size_t separator = file.find_last_of("/\\");
+	buffer += ((separator == std::string_view::npos) ? file : file.substr(separator + 1));
+	buffer += ':';
+	buffer += std::to_string(entry.line);
+	buffer += '\t';
+
+	// 1 件を 1 行に収めるため、改行は空白に置き換えます。
+	for (const char ch : entry.message.toUTF8())
+	{
+		buffer += (((ch == '\n') || (ch == '\r')) ? ' ' : ch);
+	}
+
+	buffer += '\n';
+}
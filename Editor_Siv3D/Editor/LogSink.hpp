@@ -0,0 +1,136 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include <condition_variable>
+# include <mutex>
+# include <source_location>
+# include <thread>
+
+/// @brief ログの重要度
+enum class LogLevel : uint8
+{
+	/// @brief 詳細
+	Verbose,
+
+	/// @brief 情報
+	Info,
+
+	/// @brief 成功
+	Success,
+
+	/// @brief 警告
+	Warning,
+
+	/// @brief 失敗
+	Error,
+};
+
+/// @brief ログをファイルに書き出します。書き込みはバックグラウンドのスレッドでまとめて行います。
+/// @remark 1 行に 1 件、`時刻 <TAB> 重要度 <TAB> ソースファイル:行 <TAB> メッセージ` の形式で書き出します。
+class LogSink
+{
+public:
+
+	/// @brief ログファイルの設定
+	struct Options
+	{
+		/// @brief ログファイルを置くディレクトリ
+		FilePath directory = U"logs/";
+
+		/// @brief ログファイルの名前（拡張子を除く）。古いファイルは `名前.1.log`, `名前.2.log` ... になります。
+		String baseName = U"editor";
+
+		/// @brief 1 つのログファイルの最大サイズ（バイト）。超えた場合は新しいファイルに切り替えます。
+		int64 maxFileSize = (4 << 20);
+
+		/// @brief 残すログファイルの数（書き込み中のファイルを含む）
+		size_t maxFiles = 5;
+
+		/// @brief 書き込みを待つ最長の時間（ミリ秒）
+		uint64 flushIntervalMillisec = 200;
+
+		/// @brief この件数が溜まったら、flushIntervalMillisec を待たずに書き込みます。
+		size_t batchSize = 256;
+
+		/// @brief 書き込みを待てる最大の件数。超えた分は破棄し、破棄した件数をログに残します。
+		size_t maxPendingEntries = 65536;
+	};
+
+	LogSink() = default;
+
+	~LogSink();
+
+	LogSink(const LogSink&) = delete;
+
+	LogSink& operator=(const LogSink&) = delete;
+
+	/// @brief ログファイルを開き、書き込み用のスレッドを開始します。
+	/// @param options ログファイルの設定
+	/// @return 開始に成功した場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool open(const Options& options);
+
+	/// @brief 残っているログを書き込み、スレッドを終了します。
+	void close();
+
+	/// @brief ログファイルに書き込み中かを返します。
+	/// @return 書き込み中の場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool isOpen() const noexcept;
+
+	/// @brief ログを追加します。ファイルへの書き込みは待ちません。
+	/// @param level 重要度
+	/// @param message メッセージ
+	/// @param location 呼び出し元のソースファイルの位置
+	/// @remark どのスレッドからでも呼び出せます。
+	void write(LogLevel level, StringView message, const std::source_location& location);
+
+private:
+
+	struct Entry
+	{
+		DateTime time;
+
+		LogLevel level = LogLevel::Info;
+
+		String message;
+
+		/// @brief ソースファイルのパス（静的な文字列）
+		const char* file = "";
+
+		uint32 line = 0;
+	};
+
+	Options m_options;
+
+	/// @brief 以下のメンバを保護するミューテックス
+	std::mutex m_mutex;
+
+	std::condition_variable m_condition;
+
+	/// @brief 書き込みを待っているログ
+	Array<Entry> m_pendingEntries;
+
+	/// @brief 件数の上限を超えて破棄したログの数
+	size_t m_numDroppedEntries = 0;
+
+	bool m_stop = true;
+
+	/// @brief 書き込み用のスレッドからのみアクセスします。
+	BinaryWriter m_writer;
+
+	std::thread m_thread;
+
+	/// @brief 書き込み用のスレッドの処理です。
+	void run();
+
+	/// @brief ログファイルを開きます。サイズが上限を超えている場合は切り替えます。
+	bool openFile();
+
+	/// @brief ログファイルを切り替え、古いファイルの名前をずらします。
+	void rotate();
+
+	[[nodiscard]]
+	FilePath filePath(size_t index) const;
+
+	static void AppendEntry(std::string& buffer, const Entry& entry);
+};
@@ -0,0 +1,78 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include <atomic>
+
+/// @brief 複数のスレッドから追加し、1 つのスレッドから取り出すロックフリーのキューです。
+/// @tparam Type 要素の型。デフォルト構築とムーブができる必要があります。
+/// @remark 追加は 1 回の atomic exchange で終わり、他のスレッドを待ちません。
+/// 追加の途中のスレッドがあると、それより後に追加された要素は、そのスレッドの追加が終わるまで取り出せません。
+/// 同じスレッドから追加した要素は、追加した順に取り出されます。
+template <class Type>
+class MPSCQueue
+{
+public:
+
+	MPSCQueue()
+		: m_head{ new Node{} }
+	{
+		m_tail = m_head.load(std::memory_order_relaxed);
+	}
+
+	~MPSCQueue()
+	{
+		while (m_tail)
+		{
+			delete std::exchange(m_tail, m_tail->next.load(std::memory_order_relaxed));
+		}
+	}
+
+	MPSCQueue(const MPSCQueue&) = delete;
+
+	MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+	/// @brief 要素を追加します。どのスレッドからでも呼び出せます。
+	/// @param value 追加する要素
+	void push(Type value)
+	{
+		Node* node = new Node{};
+		node->value = std::move(value);
+
+		// 末尾を入れ替えてから、前の末尾に次の要素をつなぎます。
+		Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+		previous->next.store(node, std::memory_order_release);
+	}
+
+	/// @brief 先頭の要素を取り出します。1 つのスレッドからのみ呼び出せます。
+	/// @param value 取り出した要素を書き込む変数
+	/// @return 要素を取り出した場合 true, 取り出せる要素が無い場合は false
+	[[nodiscard]]
+	bool tryPop(Type& value)
+	{
+		Node* next = m_tail->next.load(std::memory_order_acquire);
+
+		if (not next)
+		{
+			return false;
+		}
+
+		// 取り出した要素のノードを、次の取り出しの起点として残します。
+		value = std::move(next->value);
+		delete std::exchange(m_tail, next);
+		return true;
+	}
+
+private:
+
+	struct Node
+	{
+		std::atomic<Node*> next = nullptr;
+
+		Type value{};
+	};
+
+	/// @brief 最後に追加されたノード（追加するスレッドが書き換えます）
+	alignas(64) std::atomic<Node*> m_head;
+
+	/// @brief 取り出し済みの最後のノード（取り出すスレッドだけがアクセスします）
+	alignas(64) Node* m_tail = nullptr;
+};
@@ -1,5 +1,6 @@
 ﻿# pragma once
 # include <Siv3D.hpp>
+# include "MPSCQueue.hpp"
 
 /// @brief 通知を管理するアドオン
 class NotificationAddon : public IAddon
@@ -59,15 +60,27 @@ public:
 		ColorF failureColor{ 1.00, 0.32, 0.32 };
 	};
 
+	/// @brief 1 回の update() でキューから取り出す通知の最大数です。残りは次のフレームで取り出します。
+	static constexpr size_t MaxDrainPerFrame = 4096;
+
+	/// @brief 表示を待つ通知の最大数です。表示が追いつかない場合は、超えた分の新しい通知を破棄し、破棄した数を通知します。
+	static constexpr size_t MaxPendingNotifications = 65536;
+
 	/// @brief 通知を表示します。
 	/// @param message メッセージ
 	/// @param type 通知の種類
+	/// @remark どのスレッドからでも呼び出せます。ロックを取らずにキューに追加し、次の update() で表示されます。
+	/// 表示を待つ通知が MaxPendingNotifications 個ある場合は、メモリを使い続けないよう破棄します。
 	static void Show(const StringView message, const Type type = NotificationAddon::Type::Normal)
 	{
-		if (auto p = Addon::GetAddon<NotificationAddon>(U"NotificationAddon"))
+		if (MaxPendingNotifications <= s_numPendingNotifications.fetch_add(1, std::memory_order_relaxed))
 		{
-			p->show(message, type);
+			s_numPendingNotifications.fetch_sub(1, std::memory_order_relaxed);
+			s_numDroppedNotifications.fetch_add(1, std::memory_order_relaxed);
+			return;
 		}
+
+		s_pendingNotifications.push(PendingNotification{ .message = String{ message }, .type = type });
 	}
 
 	/// @brief 通知の表示時間を設定します。
@@ -94,10 +107,22 @@ private:
 
 	static constexpr StringView Icons = U" \U000F02FC\U000F02D7\U000F0E1E\U000F0029\U000F1398";
 
+	/// @brief 保持する通知の最大数です。超えた場合は、失敗と警告以外の古い通知から破棄します。
+	static constexpr size_t Capacity = 64;
+
+	/// @brief 通知 1 つ分の高さ
+	static constexpr double RowHeight = 32.0;
+
 	struct Notification
 	{
 		String message;
 
+		/// @brief message のハッシュ値
+		uint64 hash = 0;
+
+		/// @brief まとめられた通知の数
+		size_t count = 1;
+
 		double time = 0.0;
 
 		double currentIndex = 0.0;
@@ -105,11 +130,44 @@ private:
 		double velocity = 0.0;
 
 		Type type = Type::Normal;
+
+		/// @brief シェーピング済みのメッセージ。画面内に入ったときに作成します。
+		Optional<DrawableText> text;
+
+		/// @brief シェーピング済みのアイコン
+		Optional<DrawableText> icon;
+
+		/// @brief シェーピング済みの件数。count が変わったときに作り直します。
+		Optional<DrawableText> badge;
+	};
+
+	/// @brief 表示を待っている通知
+	struct PendingNotification
+	{
+		String message;
+
+		Type type = Type::Normal;
 	};
 
+	/// @brief 各スレッドから追加され、表示を待っている通知
+	inline static MPSCQueue<PendingNotification> s_pendingNotifications;
+
+	/// @brief s_pendingNotifications に追加され、まだ取り出されていない通知の数
+	inline static std::atomic<size_t> s_numPendingNotifications = 0;
+
+	/// @brief 表示を待つ通知が多すぎるため破棄した通知の数
+	inline static std::atomic<size_t> s_numDroppedNotifications = 0;
+
 	Style m_style;
 
-	Array<Notification> m_notifications;
+	/// @brief 表示中の通知のリングバッファ
+	std::array<Notification, Capacity> m_notifications;
+
+	/// @brief 最も古い通知の位置。先頭の通知を取り除くときは、要素を動かさずにこの位置を進めます。
+	size_t m_head = 0;
+
+	/// @brief 表示中の通知の数
+	size_t m_numNotifications = 0;
 
 	double m_lifeTime = 10.0;
 
@@ -117,18 +175,77 @@ private:
 	{
 		const double deltaTime = Scene::DeltaTime();
 
-		for (auto& notification : m_notifications)
+		// 大量の通知が追加されてもフレーム時間が延びすぎないよう、取り出す数を制限します。
 		{
-			notification.time += deltaTime;
+			PendingNotification pendingNotification;
+
+			for (size_t i = 0; ((i < MaxDrainPerFrame) && s_pendingNotifications.tryPop(pendingNotification)); ++i)
+			{
+				s_numPendingNotifications.fetch_sub(1, std::memory_order_relaxed);
+				show(pendingNotification.message, pendingNotification.type);
+			}
+
+			if (const size_t numDropped = s_numDroppedNotifications.exchange(0, std::memory_order_relaxed); (numDropped != 0))
+			{
+				show(U"表示が追いつかないため、{} 件の通知を破棄しました。"_fmt(numDropped), Type::Warning);
+			}
+		}
+
+		for (size_t i = 0; i < m_numNotifications; ++i)
+		{
+			at(i).time += deltaTime;
+		}
+
+		// 古い通知から続けて表示時間を過ぎたものは、m_head を進めて取り除きます。
+		while ((m_numNotifications != 0) && (m_lifeTime < at(0).time))
+		{
+			m_head = ((m_head + 1) % Capacity);
+			--m_numNotifications;
 		}
 
-		m_notifications.remove_if([lifeTime = m_lifeTime](const Notification& notification) { return (lifeTime < notification.time); });
+		// 途中に残った表示時間を過ぎた通知を取り除き、残った通知を前に詰めます。
+		size_t numAlive = 0;
+
+		for (size_t i = 0; i < m_numNotifications; ++i)
+		{
+			Notification& notification = at(i);
+
+			if (notification.time <= m_lifeTime)
+			{
+				if (numAlive != i)
+				{
+					at(numAlive) = std::move(notification);
+				}
+
+				++numAlive;
+			}
+		}
+
+		m_numNotifications = numAlive;
+
+		const Font& font = SimpleGUI::GetFont();
+		const size_t numVisibleRows = numVisible();
 
-		for (size_t i = 0; i < m_notifications.size(); ++i)
+		for (size_t i = 0; i < m_numNotifications; ++i)
 		{
-			auto& notification = m_notifications[i];
+			auto& notification = at(i);
 			notification.currentIndex = Math::SmoothDamp(notification.currentIndex,
 				static_cast<double>(i), notification.velocity, 0.15, 9999.0, deltaTime);
+
+			// 画面内の通知だけをシェーピングし、表示している間は使い回します。
+			if (i < numVisibleRows)
+			{
+				if (not notification.text)
+				{
+					notification.text = font(notification.message);
+					notification.icon = font(Icons[FromEnum(notification.type)]);
+				}
+
+				if ((1 < notification.count) && (not notification.badge))
+				{
+					notification.badge = font(U"×{}"_fmt(notification.count));
+				}
+			}
 		}
 
 		return true;
@@ -136,10 +253,15 @@ private:
 
 	void draw() const override
 	{
-		const Font& font = SimpleGUI::GetFont();
-
-		for (const auto& notification : m_notifications)
+		for (size_t i = 0; i < numVisible(); ++i)
 		{
+			const auto& notification = at(i);
+
+			if (not notification.text)
+			{
+				continue;
+			}
+
 			double xScale = 1.0;
 			double alpha = 1.0;
 
@@ -164,7 +286,7 @@ private:
 			ColorF textColor = m_style.textColor;
 			textColor.a *= alpha;
 
-			const RectF rect{ 10, (10 + notification.currentIndex * 32), (m_style.width * xScale), 31 };
+			const RectF rect{ 10, (10 + notification.currentIndex * RowHeight), (m_style.width * xScale), (RowHeight - 1) };
 			rect.rounded(3).draw(backgroundColor).drawFrame(1, 0, frameColor);
 
 			if (notification.type != Type::Normal)
@@ -176,23 +298,108 @@ private:
 					: m_style.failureColor;
 				color.a *= alpha;
 
-				font(Icons[FromEnum(notification.type)]).draw(18, Arg::leftCenter = rect.leftCenter().movedBy(8, -1), color);
+				notification.icon->draw(18, Arg::leftCenter = rect.leftCenter().movedBy(8, -1), color);
 			}
 
-			font(notification.message).draw(18, Arg::leftCenter = rect.leftCenter().movedBy(32, -1), textColor);
+			notification.text->draw(18, Arg::leftCenter = rect.leftCenter().movedBy(32, -1), textColor);
+
+			// まとめられた通知の数を右端に表示します。
+			if (notification.badge)
+			{
+				ColorF badgeColor = m_style.frameColor;
+				badgeColor.a *= (alpha * 0.5);
+
+				const RectF badgeRect = notification.badge->region(14, Arg::rightCenter = rect.rightCenter().movedBy(-10, -1));
+				badgeRect.stretched(4).rounded(8).draw(badgeColor);
+				notification.badge->draw(14, Arg::rightCenter = rect.rightCenter().movedBy(-10, -1), textColor);
+			}
 		}
 	}
 
+	[[nodiscard]]
+	Notification& at(const size_t index) noexcept
+	{
+		return m_notifications[((m_head + index) % Capacity)];
+	}
+
+	[[nodiscard]]
+	const Notification& at(const size_t index) const noexcept
+	{
+		return m_notifications[((m_head + index) % Capacity)];
+	}
+
+	/// @brief 画面内に表示される通知の数を返します。
+	[[nodiscard]]
+	size_t numVisible() const
+	{
+		return Min(m_numNotifications, (static_cast<size_t>(Scene::Height() / RowHeight) + 1));
+	}
+
 	void show(const StringView message, const Type type)
 	{
-		const double currentIndex = (m_notifications.empty() ? 0.0 : m_notifications.back().currentIndex + 1.0);
-		const double velocity = (m_notifications.empty() ? 0.0 : m_notifications.back().velocity);
+		const uint64 hash = message.hash();
 
-		m_notifications << Notification{
+		// 同じ通知が表示中の場合は、数を加えて表示時間を延ばします。
+		for (size_t i = 0; i < m_numNotifications; ++i)
+		{
+			Notification& notification = at(i);
+
+			if ((notification.hash == hash) && (notification.type == type) && (notification.message == message))
+			{
+				++notification.count;
+				notification.time = Min(notification.time, 0.2);
+				notification.badge.reset();
+				return;
+			}
+		}
+
+		// 最大数に達している場合は、失敗と警告を残すため、それ以外で最も古い通知を破棄します。全て失敗か警告の場合は最も古い通知を破棄します。
+		if (m_numNotifications == Capacity)
+		{
+			size_t evictIndex = 0;
+
+			for (size_t i = 0; i < m_numNotifications; ++i)
+			{
+				if (const Type evictType = at(i).type; ((evictType != Type::Failure) && (evictType != Type::Warning)))
+				{
+					evictIndex = i;
+					break;
+				}
+			}
+
+			// 破棄した通知の前後のうち、少ない方の通知をずらします。古い方をずらした場合は m_head を進めます。
+			if (evictIndex < (m_numNotifications / 2))
+			{
+				for (size_t i = evictIndex; 0 < i; --i)
+				{
+					at(i) = std::move(at(i - 1));
+				}
+
+				m_head = ((m_head + 1) % Capacity);
+			}
+			else
+			{
+				for (size_t i = evictIndex; (i + 1) < m_numNotifications; ++i)
+				{
+					at(i) = std::move(at(i + 1));
+				}
+			}
+
+			--m_numNotifications;
+		}
+
+		const double currentIndex = ((m_numNotifications == 0) ? 0.0 : at(m_numNotifications - 1).currentIndex + 1.0);
+		const double velocity = ((m_numNotifications == 0) ? 0.0 : at(m_numNotifications - 1).velocity);
+
+		at(m_numNotifications) = Notification{
 			.message = String{ message },
+			.hash = hash,
+			.count = 1,
 			.time = 0.0,
 			.currentIndex = currentIndex,
 			.velocity = velocity,
 			.type = type };
+
+		++m_numNotifications;
 	}
 };
@@ -0,0 +1,419 @@
+﻿# include "ReloadProfiler.hpp"
+
+namespace
+{
+	/// @brief 集計の状態
+	struct ProfilerState
+	{
+		/// @brief 以下のメンバを保護するミューテックス
+		std::mutex mutex;
+
+		/// @brief 公開を待っている計測結果
+		HashTable<FilePath, ReloadTrace> pendingTraces;
+
+		/// @brief メインスレッドに渡され、次の公開で集計する計測結果のパス
+		Array<FilePath> deliveredPaths;
+
+		/// @brief データタイプごとの分布
+		HashTable<String, ReloadStageHistograms> histograms;
+
+		/// @brief DirectoryMonitor::update の所要時間の分布
+		LatencyHistogram watcherUpdate;
+
+		/// @brief 最近公開された計測結果のリングバッファ
+		Array<ReloadTrace> recentTraces;
+
+		/// @brief recentTraces に次に書き込む位置
+		size_t nextRecentIndex = 0;
+	};
+
+	[[nodiscard]]
+	ProfilerState& GetState()
+	{
+		static ProfilerState state;
+		return state;
+	}
+
+# if SIV3D_BUILD(DEBUG)
+	std::atomic<bool> g_enabled = true;
+# else
+	std::atomic<bool> g_enabled = false;
+# endif
+
+	/// @brief 現在のスレッドで計測中の config ファイル
+	thread_local ReloadTrace* tl_currentTrace = nullptr;
+
+	[[nodiscard]]
+	uint64 Elapsed(const uint64 beginMicrosec, const uint64 endMicrosec) noexcept
+	{
+		return ((beginMicrosec < endMicrosec) ? (endMicrosec - beginMicrosec) : 0);
+	}
+
+	/// @brief recentTraces を古い順に並べて返します。
+	[[nodiscard]]
+	Array<ReloadTrace> OrderedRecentTraces(const ProfilerState& state)
+	{
+		Array<ReloadTrace> traces;
+		traces.reserve(state.recentTraces.size());
+
+		for (size_t i = 0; i < state.recentTraces.size(); ++i)
+		{
+			traces << state.recentTraces[(state.nextRecentIndex + i) % state.recentTraces.size()];
+		}
+
+		return traces;
+	}
+
+	[[nodiscard]]
+	JSON HistogramToJSON(const LatencyHistogram& histogram)
+	{
+		JSON json;
+		json[U"count"] = static_cast<int64>(histogram.count);
+		json[U"meanMicrosec"] = histogram.mean();
+		json[U"p50Microsec"] = static_cast<int64>(histogram.percentile(0.50));
+		json[U"p95Microsec"] = static_cast<int64>(histogram.percentile(0.95));
+		json[U"p99Microsec"] = static_cast<int64>(histogram.percentile(0.99));
+		json[U"maxMicrosec"] = static_cast<int64>(histogram.maxMicrosec);
+
+		// 末尾の空の区間は省きます。
+		size_t numBuckets = LatencyHistogram::NumBuckets;
+
+		while ((numBuckets != 0) && (histogram.buckets[numBuckets - 1] == 0))
+		{
+			--numBuckets;
+		}
+
+		for (size_t i = 0; i < numBuckets; ++i)
+		{
+			json[U"buckets"].push_back(static_cast<int64>(histogram.buckets[i]));
+		}
+
+		return json;
+	}
+
+	[[nodiscard]]
+	String HistogramToCSVRow(const StringView dataType, const StringView stage, const LatencyHistogram& histogram)
+	{
+		return U"{},{},{},{:.1f},{},{},{},{}"_fmt(dataType, stage, histogram.count, histogram.mean(),
+			histogram.percentile(0.50), histogram.percentile(0.95), histogram.percentile(0.99), histogram.maxMicrosec);
+	}
+}
+
+void LatencyHistogram::add(const uint64 microsec) noexcept
+{
+	++buckets[Min<size_t>(std::bit_width(microsec), (NumBuckets - 1))];
+	++count;
+	totalMicrosec += microsec;
+	maxMicrosec = Max(maxMicrosec, microsec);
+}
+
+double LatencyHistogram::mean() const noexcept
+{
+	return ((count == 0) ? 0.0 : (static_cast<double>(totalMicrosec) / count));
+}
+
+uint64 LatencyHistogram::percentile(const double percentile) const noexcept
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	const uint64 rank = Max<uint64>(static_cast<uint64>(Math::Ceil(Clamp(percentile, 0.0, 1.0) * count)), 1);
+	uint64 accumulated = 0;
+
+	for (size_t i = 0; i < NumBuckets; ++i)
+	{
+		accumulated += buckets[i];
+
+		if (rank <= accumulated)
+		{
+			return Min(((uint64{ 1 } << i) - 1), maxMicrosec);
+		}
+	}
+
+	return maxMicrosec;
+}
+
+ReloadProfiler::Scope::Scope(const FilePathView path)
+	: m_enabled{ IsEnabled() }
+{
+	if (not m_enabled)
+	{
+		return;
+	}
+
+	m_trace.path = path;
+	m_trace.loadBeginMicrosec = Time::GetMicrosec();
+
+	m_previous = std::exchange(tl_currentTrace, &m_trace);
+}
+
+ReloadProfiler::Scope::~Scope()
+{
+	if (not m_enabled)
+	{
+		return;
+	}
+
+	tl_currentTrace = m_previous;
+	m_trace.loadEndMicrosec = Time::GetMicrosec();
+
+	ProfilerState& state = GetState();
+	std::lock_guard lock{ state.mutex };
+
+	// 読み込み可能になった時刻は RecordReady で記録したものを引き継ぎます。
+	ReloadTrace& trace = state.pendingTraces[m_trace.path];
+	const uint64 readyMicrosec = trace.readyMicrosec;
+	const uint64 cooldownMicrosec = trace.stageMicrosec[FromEnum(ReloadStage::Cooldown)];
+
+	trace = std::move(m_trace);
+	trace.readyMicrosec = readyMicrosec;
+	trace.stageMicrosec[FromEnum(ReloadStage::Cooldown)] = cooldownMicrosec;
+
+	if (readyMicrosec != 0)
+	{
+		trace.stageMicrosec[FromEnum(ReloadStage::Queue)] = Elapsed(readyMicrosec, trace.loadBeginMicrosec);
+	}
+}
+
+ReloadProfiler::StageTimer::StageTimer(const ReloadStage stage) noexcept
+	: m_trace{ tl_currentTrace }
+	, m_stage{ stage }
+	, m_beginMicrosec{ m_trace ? Time::GetMicrosec() : 0 } {}
+
+ReloadProfiler::StageTimer::~StageTimer()
+{
+	if (m_trace)
+	{
+		m_trace->stageMicrosec[FromEnum(m_stage)] += Elapsed(m_beginMicrosec, Time::GetMicrosec());
+	}
+}
+
+void ReloadProfiler::SetEnabled(const bool enabled) noexcept
+{
+	g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool ReloadProfiler::IsEnabled() noexcept
+{
+	return g_enabled.load(std::memory_order_relaxed);
+}
+
+void ReloadProfiler::RecordWatcherUpdate(const uint64 microsec)
+{
+	if (not IsEnabled())
+	{
+		return;
+	}
+
+	ProfilerState& state = GetState();
+	std::lock_guard lock{ state.mutex };
+	state.watcherUpdate.add(microsec);
+}
+
+void ReloadProfiler::RecordReady(const FilePath& path, const uint64 cooldownMicrosec)
+{
+	if (not IsEnabled())
+	{
+		return;
+	}
+
+	const uint64 currentTimeMicrosec = Time::GetMicrosec();
+
+	ProfilerState& state = GetState();
+	std::lock_guard lock{ state.mutex };
+
+	// 前回の計測が公開されないまま再度変更された場合は、新しい計測で置き換えます。
+	ReloadTrace& trace = state.pendingTraces[path];
+	trace = ReloadTrace{ .path = path };
+	trace.readyMicrosec = currentTimeMicrosec;
+	trace.stageMicrosec[FromEnum(ReloadStage::Cooldown)] = cooldownMicrosec;
+}
+
+void ReloadProfiler::RecordDelivered(const FilePath& path, const StringView dataType)
+{
+	if (not IsEnabled())
+	{
+		return;
+	}
+
+	ProfilerState& state = GetState();
+	std::lock_guard lock{ state.mutex };
+
+	if (auto it = state.pendingTraces.find(path); (it != state.pendingTraces.end()))
+	{
+		it->second.dataType = dataType;
+		state.deliveredPaths << path;
+	}
+}
+
+void ReloadProfiler::RecordPublished()
+{
+	if (not IsEnabled())
+	{
+		return;
+	}
+
+	const uint64 currentTimeMicrosec = Time::GetMicrosec();
+
+	ProfilerState& state = GetState();
+	std::lock_guard lock{ state.mutex };
+
+	for (const auto& path : state.deliveredPaths)
+	{
+		auto it = state.pendingTraces.find(path);
+
+		if (it == state.pendingTraces.end())
+		{
+			continue;
+		}
+
+		ReloadTrace trace = std::move(it->second);
+		state.pendingTraces.erase(it);
+
+		auto& stages = trace.stageMicrosec;
+
+		if (trace.loadEndMicrosec != 0)
+		{
+			stages[FromEnum(ReloadStage::Apply)] = Elapsed(trace.loadEndMicrosec, currentTimeMicrosec);
+		}
+
+		// DirectoryMonitor を経由していない読み込みは、ワーカースレッドで読み込みを始めた時刻から数えます。
+		const uint64 beginMicrosec = ((trace.readyMicrosec != 0) ? trace.readyMicrosec : trace.loadBeginMicrosec);
+		stages[FromEnum(ReloadStage::Total)] = (stages[FromEnum(ReloadStage::Cooldown)] + Elapsed(beginMicrosec, currentTimeMicrosec));
+
+		auto [histogramIt, inserted] = state.histograms.try_emplace(trace.dataType);
+
+		if (inserted)
+		{
+			histogramIt->second.dataType = trace.dataType;
+		}
+
+		for (size_t i = 0; i < NumStages; ++i)
+		{
+			histogramIt->second.stages[i].add(stages[i]);
+		}
+
+		if (state.recentTraces.size() < MaxRecentTraces)
+		{
+			state.recentTraces << std::move(trace);
+		}
+		else
+		{
+			state.recentTraces[state.nextRecentIndex] = std::move(trace);
+			state.nextRecentIndex = ((state.nextRecentIndex + 1) % MaxRecentTraces);
+		}
+	}
+
+	state.deliveredPaths.clear();
+}
+
+ReloadProfile ReloadProfiler::GetProfile()
+{
+	ProfilerState& state = GetState();
+	std::lock_guard lock{ state.mutex };
+
+	ReloadProfile profile;
+	profile.watcherUpdate = state.watcherUpdate;
+	profile.recentTraces = OrderedRecentTraces(state);
+
+	for (const auto& [dataType, histograms] : state.histograms)
+	{
+		profile.dataTypes << histograms;
+	}
+
+	profile.dataTypes.sort_by([](const ReloadStageHistograms& a, const ReloadStageHistograms& b) { return (a.dataType < b.dataType); });
+
+	return profile;
+}
+
+void ReloadProfiler::Reset()
+{
+	ProfilerState& state = GetState();
+	std::lock_guard lock{ state.mutex };
+
+	state.histograms.clear();
+	state.watcherUpdate = LatencyHistogram{};
+	state.recentTraces.clear();
+	state.nextRecentIndex = 0;
+}
+
+bool ReloadProfiler::ExportCSV(const FilePathView path)
+{
+	const ReloadProfile profile = GetProfile();
+
+	TextWriter writer{ path };
+
+	if (not writer)
+	{
+		return false;
+	}
+
+	writer.writeln(U"dataType,stage,count,meanMicrosec,p50Microsec,p95Microsec,p99Microsec,maxMicrosec");
+	writer.writeln(HistogramToCSVRow(U"(watcher)", U"Update", profile.watcherUpdate));
+
+	for (const auto& histograms : profile.dataTypes)
+	{
+		for (size_t i = 0; i < NumStages; ++i)
+		{
+			writer.writeln(HistogramToCSVRow(histograms.dataType, StageName(ToEnum<ReloadStage>(static_cast<uint8>(i))), histograms.stages[i]));
+		}
+	}
+
+	return true;
+}
+
+bool ReloadProfiler::ExportJSON(const FilePathView path)
+{
+	const ReloadProfile profile = GetProfile();
+
+	JSON json;
+	json[U"date"] = DateTime::Now().format(U"yyyy-MM-ddTHH:mm:ss");
+	json[U"watcherUpdate"] = HistogramToJSON(profile.watcherUpdate);
+
+	for (const auto& histograms : profile.dataTypes)
+	{
+		for (size_t i = 0; i < NumStages; ++i)
+		{
+			json[U"dataTypes"][histograms.dataType][StageName(ToEnum<ReloadStage>(static_cast<uint8>(i)))] = HistogramToJSON(histograms.stages[i]);
+		}
+	}
+
+	for (const auto& trace : profile.recentTraces)
+	{
+		JSON item;
+		item[U"path"] = FileSystem::RelativePath(trace.path);
+		item[U"dataType"] = trace.dataType;
+
+		for (size_t i = 0; i < NumStages; ++i)
+		{
+			item[U"stageMicrosec"][StageName(ToEnum<ReloadStage>(static_cast<uint8>(i)))] = static_cast<int64>(trace.stageMicrosec[i]);
+		}
+
+		json[U"recentTraces"].push_back(item);
+	}
+
+	return json.save(path);
+}
+
+StringView ReloadProfiler::StageName(const ReloadStage stage) noexcept
+{
+	switch (stage)
+	{
+	case ReloadStage::Cooldown:
+		return U"Cooldown";
+	case ReloadStage::Queue:
+		return U"Queue";
+	case ReloadStage::Read:
+		return U"Read";
+	case ReloadStage::Load:
+		return U"Load";
+	case ReloadStage::Parse:
+		return U"Parse";
+	case ReloadStage::Apply:
+		return U"Apply";
+	default:
+		return U"Total";
+	}
+}
@@ -0,0 +1,211 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+
+/// @brief config ファイルの変更から反映までの段階
+enum class ReloadStage : uint8
+{
+	/// @brief 変更が通知されてから、書き込みの完了を待って読み込み可能になるまで
+	Cooldown,
+
+	/// @brief 読み込み可能になってから、ワーカースレッドで読み込みを始めるまで
+	Queue,
+
+	/// @brief ファイルの読み込み
+	Read,
+
+	/// @brief JSON や表のロード（include の解決を含む）
+	Load,
+
+	/// @brief パーサーによる config の作成、またはキャッシュからの復元
+	Parse,
+
+	/// @brief 読み込みが完了してから、ConfigStore のスナップショットとして公開されるまで
+	Apply,
+
+	/// @brief 変更の通知から公開までの全体
+	Total,
+};
+
+/// @brief 所要時間の分布です。i 番目の区間に [2^(i-1), 2^i) マイクロ秒の計測値を数えます。
+struct LatencyHistogram
+{
+	/// @brief 区間の数
+	static constexpr size_t NumBuckets = 32;
+
+	/// @brief 区間ごとの計測回数
+	std::array<uint64, NumBuckets> buckets{};
+
+	/// @brief 計測回数
+	uint64 count = 0;
+
+	/// @brief 計測値の合計（マイクロ秒）
+	uint64 totalMicrosec = 0;
+
+	/// @brief 計測値の最大（マイクロ秒）
+	uint64 maxMicrosec = 0;
+
+	/// @brief 計測値を追加します。
+	/// @param microsec 所要時間（マイクロ秒）
+	void add(uint64 microsec) noexcept;
+
+	/// @brief 平均を返します。
+	/// @return 平均（マイクロ秒）。計測値が無い場合は 0
+	[[nodiscard]]
+	double mean() const noexcept;
+
+	/// @brief パーセンタイルを返します。
+	/// @param percentile 0.0 から 1.0 の割合
+	/// @return 該当する区間の上限（マイクロ秒）。最大値を超えることはありません。
+	[[nodiscard]]
+	uint64 percentile(double percentile) const noexcept;
+};
+
+/// @brief 1 つの config ファイルの読み込みを段階ごとに計測した結果です。
+struct ReloadTrace
+{
+	/// @brief config ファイルの絶対パス
+	FilePath path;
+
+	/// @brief 読み込んだ config のデータタイプ。config を作らなかった場合は `(none)`、削除された場合は `(removed)` です。
+	String dataType;
+
+	/// @brief 段階ごとの所要時間（マイクロ秒）
+	std::array<uint64, (FromEnum(ReloadStage::Total) + 1)> stageMicrosec{};
+
+	/// @brief retrieveChangedFiles で読み込み可能になった時刻（マイクロ秒）。DirectoryMonitor を経由していない場合は 0
+	uint64 readyMicrosec = 0;
+
+	/// @brief ワーカースレッドで読み込みを始めた時刻（マイクロ秒）
+	uint64 loadBeginMicrosec = 0;
+
+	/// @brief ワーカースレッドで読み込みを終えた時刻（マイクロ秒）
+	uint64 loadEndMicrosec = 0;
+};
+
+/// @brief データタイプごとの段階別の所要時間の分布です。
+struct ReloadStageHistograms
+{
+	/// @brief データタイプ
+	String dataType;
+
+	/// @brief 段階ごとの分布
+	std::array<LatencyHistogram, (FromEnum(ReloadStage::Total) + 1)> stages;
+};
+
+/// @brief ReloadProfiler が集計した結果のコピーです。
+struct ReloadProfile
+{
+	/// @brief データタイプ順に並べた分布
+	Array<ReloadStageHistograms> dataTypes;
+
+	/// @brief DirectoryMonitor::update の所要時間の分布
+	LatencyHistogram watcherUpdate;
+
+	/// @brief 最近公開された config ファイルの計測結果（古い順）
+	Array<ReloadTrace> recentTraces;
+};
+
+/// @brief config ファイルの変更が ConfigStore に反映されるまでの時間を、段階ごと・データタイプごとに集計します。
+/// @remark どのスレッドからでも呼び出せます。計測が無効の場合、各関数は何もしません。
+class ReloadProfiler
+{
+public:
+
+	/// @brief 段階の数
+	static constexpr size_t NumStages = (FromEnum(ReloadStage::Total) + 1);
+
+	/// @brief 保持する最近の計測結果の数
+	static constexpr size_t MaxRecentTraces = 256;
+
+	/// @brief ワーカースレッドで 1 つの config ファイルを読み込む間、StageTimer の計測をそのファイルに記録します。
+	/// @remark 破棄したときに計測結果を登録するため、読み込みの結果をメインスレッドに渡す前に破棄してください。
+	class Scope
+	{
+	public:
+
+		explicit Scope(FilePathView path);
+
+		~Scope();
+
+		Scope(const Scope&) = delete;
+
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+
+		ReloadTrace m_trace;
+
+		ReloadTrace* m_previous = nullptr;
+
+		bool m_enabled = false;
+	};
+
+	/// @brief 現在のスレッドの Scope に、段階の所要時間を加算します。
+	class StageTimer
+	{
+	public:
+
+		explicit StageTimer(ReloadStage stage) noexcept;
+
+		~StageTimer();
+
+		StageTimer(const StageTimer&) = delete;
+
+		StageTimer& operator=(const StageTimer&) = delete;
+
+	private:
+
+		ReloadTrace* m_trace = nullptr;
+
+		ReloadStage m_stage;
+
+		uint64 m_beginMicrosec = 0;
+	};
+
+	/// @brief 計測の有効・無効を設定します。
+	/// @param enabled 計測する場合 true
+	static void SetEnabled(bool enabled) noexcept;
+
+	/// @brief 計測が有効かを返します。
+	/// @return 計測が有効な場合 true, それ以外の場合は false
+	[[nodiscard]]
+	static bool IsEnabled() noexcept;
+
+	/// @brief DirectoryMonitor::update の所要時間を記録します。
+	/// @param microsec 所要時間（マイクロ秒）
+	static void RecordWatcherUpdate(uint64 microsec);
+
+	/// @brief ファイルが読み込み可能になったことを記録します。
+	/// @param path ファイルの絶対パス
+	/// @param cooldownMicrosec 最初に変更が通知されてからの時間（マイクロ秒）
+	static void RecordReady(const FilePath& path, uint64 cooldownMicrosec);
+
+	/// @brief 読み込みの結果がメインスレッドに渡されたことを記録します。次の RecordPublished で集計されます。
+	/// @param path ファイルの絶対パス
+	/// @param dataType 読み込んだ config のデータタイプ
+	static void RecordDelivered(const FilePath& path, StringView dataType);
+
+	/// @brief メインスレッドに渡された読み込みの結果が公開されたことを記録し、分布に加えます。
+	static void RecordPublished();
+
+	/// @brief 集計した結果のコピーを返します。
+	[[nodiscard]]
+	static ReloadProfile GetProfile();
+
+	/// @brief 集計した結果を消去します。
+	static void Reset();
+
+	/// @brief データタイプ・段階ごとの集計を CSV で保存します。
+	/// @param path 保存先のパス
+	/// @return 保存に成功した場合 true, それ以外の場合は false
+	static bool ExportCSV(FilePathView path);
+
+	/// @brief 分布と最近の計測結果を JSON で保存します。
+	/// @param path 保存先のパス
+	/// @return 保存に成功した場合 true, それ以外の場合は false
+	static bool ExportJSON(FilePathView path);
+
+	/// @brief 段階の名前を返します。
+	[[nodiscard]]
+	static StringView StageName(ReloadStage stage) noexcept;
+};
@@ -0,0 +1,146 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include "ReloadProfiler.hpp"
+
+/// @brief ReloadProfiler の集計を、通知の下に表で表示するアドオン
+class ReloadProfilerAddon : public IAddon
+{
+public:
+
+	/// @brief 表示するかを設定します。
+	/// @param visible 表示する場合 true
+	static void SetVisible(const bool visible)
+	{
+		if (auto p = Addon::GetAddon<ReloadProfilerAddon>(U"ReloadProfilerAddon"))
+		{
+			p->m_visible = visible;
+			p->m_refreshTime = RefreshInterval;
+		}
+	}
+
+	/// @brief 表示しているかを返します。
+	/// @return 表示している場合 true, それ以外の場合は false
+	[[nodiscard]]
+	static bool IsVisible()
+	{
+		if (auto p = Addon::GetAddon<ReloadProfilerAddon>(U"ReloadProfilerAddon"))
+		{
+			return p->m_visible;
+		}
+
+		return false;
+	}
+
+private:
+
+	/// @brief 集計を取り直す間隔（秒）
+	static constexpr double RefreshInterval = 0.25;
+
+	/// @brief 表示するデータタイプの最大数
+	static constexpr size_t MaxRows = 12;
+
+	static constexpr double RowHeight = 20.0;
+
+	static constexpr double NameColumnWidth = 180.0;
+
+	static constexpr double CountColumnWidth = 50.0;
+
+	static constexpr double StageColumnWidth = 92.0;
+
+	/// @brief 表示中の集計
+	ReloadProfile m_profile;
+
+	/// @brief 前回集計を取り直してからの時間（秒）
+	double m_refreshTime = 0.0;
+
+	bool m_visible = false;
+
+	bool update() override
+	{
+		if (not m_visible)
+		{
+			return true;
+		}
+
+		// 集計のコピーにはロックが必要なため、毎フレームではなく一定の間隔で取り直します。
+		m_refreshTime += Scene::DeltaTime();
+
+		if (RefreshInterval <= m_refreshTime)
+		{
+			m_refreshTime = 0.0;
+			m_profile = ReloadProfiler::GetProfile();
+		}
+
+		return true;
+	}
+
+	void draw() const override
+	{
+		if (not m_visible)
+		{
+			return;
+		}
+
+		const Font& font = SimpleGUI::GetFont();
+		const size_t numRows = Min(m_profile.dataTypes.size(), MaxRows);
+		const double width = (NameColumnWidth + CountColumnWidth + StageColumnWidth * ReloadProfiler::NumStages + 16);
+		const double height = (RowHeight * (numRows + 3) + 16);
+
+		const RectF rect{ 10, (Scene::Height() - height - 10), width, height };
+		rect.rounded(3).draw(ColorF{ 0.0, 0.8 }).drawFrame(1, 0, ColorF{ 0.75 });
+
+		Vec2 pos = rect.tl().movedBy(8, 8);
+
+		// 見出し
+		font(U"p50 / p95 (ms)").draw(14, pos, ColorF{ 0.75 });
+		font(U"n").draw(14, pos.movedBy(NameColumnWidth, 0), ColorF{ 0.75 });
+
+		for (size_t i = 0; i < ReloadProfiler::NumStages; ++i)
+		{
+			font(ReloadProfiler::StageName(ToEnum<ReloadStage>(static_cast<uint8>(i))))
+				.draw(14, pos.movedBy((NameColumnWidth + CountColumnWidth + StageColumnWidth * i), 0), ColorF{ 0.75 });
+		}
+
+		pos.y += RowHeight;
+
+		// DirectoryMonitor::update の所要時間
+		DrawRow(font, pos, U"(watcher update)", m_profile.watcherUpdate.count, {});
+		font(FormatLatency(m_profile.watcherUpdate)).draw(14, pos.movedBy((NameColumnWidth + CountColumnWidth), 0), ColorF{ 1.0 });
+
+		pos.y += RowHeight;
+
+		for (size_t row = 0; row < numRows; ++row)
+		{
+			const auto& histograms = m_profile.dataTypes[row];
+			DrawRow(font, pos, histograms.dataType, histograms.stages.front().count, histograms.stages);
+			pos.y += RowHeight;
+		}
+
+		if (MaxRows < m_profile.dataTypes.size())
+		{
+			font(U"... {} more"_fmt(m_profile.dataTypes.size() - MaxRows)).draw(14, pos, ColorF{ 0.75 });
+		}
+	}
+
+	static void DrawRow(const Font& font, const Vec2& pos, const StringView name, const uint64 count, const std::array<LatencyHistogram, ReloadProfiler::NumStages>& stages)
+	{
+		font(name).draw(14, pos, ColorF{ 1.0 });
+		font(count).draw(14, pos.movedBy(NameColumnWidth, 0), ColorF{ 1.0 });
+
+		for (size_t i = 0; i < stages.size(); ++i)
+		{
+			if (stages[i].count != 0)
+			{
+				// 全体の列は強調します。
+				const ColorF color = ((i == FromEnum(ReloadStage::Total)) ? ColorF{ 1.0, 0.85, 0.4 } : ColorF{ 1.0 });
+				font(FormatLatency(stages[i])).draw(14, pos.movedBy((NameColumnWidth + CountColumnWidth + StageColumnWidth * i), 0), color);
+			}
+		}
+	}
+
+	[[nodiscard]]
+	static String FormatLatency(const LatencyHistogram& histogram)
+	{
+		return U"{:.1f} / {:.1f}"_fmt((histogram.percentile(0.50) / 1000.0), (histogram.percentile(0.95) / 1000.0));
+	}
+};
@@ -0,0 +1,281 @@
+﻿# include "ReloadScheduler.hpp"
+
+ReloadScheduler::ReloadScheduler(ConfigLoader& configLoader, ConfigStore& configs, const Options& options)
+	: m_configLoader{ configLoader }
+	, m_configs{ configs }
+	, m_options{ options }
+{
+	if (m_options.lazy)
+	{
+		// データタイプが初めて参照されたときに、そのデータタイプの config ファイルをまとめてスレッドプールでパースします。
+		m_configs.setDeferredLoader([this](const Array<String>& keys) { return m_configLoader.loadNow(keys); });
+	}
+}
+
+ReloadScheduler::ReloadScheduler(ConfigLoader& configLoader, ConfigStore& configs)
+	: ReloadScheduler{ configLoader, configs, Options{} } {}
+
+ReloadScheduler::~ReloadScheduler()
+{
+	if (m_options.lazy)
+	{
+		m_configs.setDeferredLoader(nullptr);
+	}
+}
+
+void ReloadScheduler::enqueue(const Array<FilePath>& paths)
+{
+	Array<FilePath> peekPaths;
+
+	for (const auto& path : paths)
+	{
+		if (m_options.lazy && shouldPeek(path))
+		{
+			// データタイプを読んでいる途中に再度変更された場合は、読み終えてからもう一度読みます。
+			if (m_peekingPaths.emplace(path).second)
+			{
+				peekPaths << path;
+			}
+			else
+			{
+				m_repeekPaths.emplace(path);
+			}
+
+			continue;
+		}
+
+		addWaiting(path);
+	}
+
+	// ファイルを開くのはワーカースレッドで行い、メインスレッドでは結果だけを受け取ります。
+	m_configLoader.requestPeek(peekPaths);
+}
+
+uint64 ReloadScheduler::update()
+{
+	const uint64 deadlineMicrosec = (Time::GetMicrosec() + static_cast<uint64>(m_options.frameBudgetMillisec * 1000.0));
+
+	++m_frameCount;
+
+	// 参照されているデータタイプが変わった場合は、読み込み待ちのファイルを並べ直します。
+	if (updateTypeAccesses() && (not m_waitingPaths.empty()))
+	{
+		reprioritize();
+	}
+
+	for (auto& loadedConfig : m_configLoader.retrieveLoadedConfigs())
+	{
+		m_loadedConfigs.push_back(std::move(loadedConfig));
+	}
+
+	// データタイプを読み終えたファイルは、パースせずに記録するか、通常どおり読み込み待ちに加えます。
+	for (const auto& peekedConfig : m_configLoader.retrievePeekedConfigs())
+	{
+		m_peekingPaths.erase(peekedConfig.path);
+
+		if (m_repeekPaths.erase(peekedConfig.path))
+		{
+			m_peekingPaths.emplace(peekedConfig.path);
+			m_configLoader.requestPeek({ peekedConfig.path });
+			continue;
+		}
+
+		if (not defer(peekedConfig))
+		{
+			addWaiting(peekedConfig.path);
+		}
+	}
+
+	// 読み込みの依頼は少しずつ行うため、予算に関わらず毎フレーム行い、ワーカースレッドを空けないようにします。
+	dispatch();
+
+	apply(deadlineMicrosec);
+
+	// include しているファイルが後から読み込まれる場合があるため、パースしていないファイルが無くなってから判定します。
+	if ((numPending() == 0) && (m_configs.numDeferred() == 0))
+	{
+		m_configLoader.reportUnincludedFiles();
+	}
+
+	// このフレームに反映した変更をまとめて公開します。
+	return m_configs.publish();
+}
+
+void ReloadScheduler::setFrameBudget(const double frameBudgetMillisec) noexcept
+{
+	m_options.frameBudgetMillisec = frameBudgetMillisec;
+}
+
+size_t ReloadScheduler::numPending() const noexcept
+{
+	return (m_peekingPaths.size() + m_waitingPaths.size() + m_configLoader.numPending() + m_loadedConfigs.size());
+}
+
+ReloadPriority ReloadScheduler::priorityOf(const FilePath& path) const
+{
+	const Optional<StringView> dataType = m_configs.dataTypeOf(path);
+
+	if (not dataType)
+	{
+		return ReloadPriority::Normal;
+	}
+
+	if (auto it = m_typeAccesses.find(String{ *dataType }); ((it != m_typeAccesses.end()) && isHot(it->second)))
+	{
+		return ReloadPriority::High;
+	}
+
+	return ReloadPriority::Low;
+}
+
+bool ReloadScheduler::updateTypeAccesses()
+{
+	bool changed = false;
+
+	for (const auto& [dataType, numAccesses] : m_configs.numAccessesByType())
+	{
+		auto [it, inserted] = m_typeAccesses.try_emplace(String{ dataType });
+		TypeAccess& access = it->second;
+
+		const bool wasHot = isHot(access);
+
+		if (access.numAccesses != numAccesses)
+		{
+			access.numAccesses = numAccesses;
+			access.lastAccessFrame = m_frameCount;
+		}
+
+		changed |= (wasHot != isHot(access));
+	}
+
+	return changed;
+}
+
+void ReloadScheduler::addWaiting(const FilePath& path)
+{
+	if (m_waitingPaths.emplace(path).second)
+	{
+		m_waitingFiles[FromEnum(priorityOf(path))].push_back(path);
+	}
+}
+
+bool ReloadScheduler::shouldPeek(const FilePath& path) const
+{
+	// パース済みの config ファイルや、読み込み中・読み込み待ちのファイルは、読み込み直す必要があるため通常どおり読み込みます。
+	if (m_configLoader.isLoading(path) || m_waitingPaths.contains(path))
+	{
+		return false;
+	}
+
+	return (m_configs.isDeferred(path) || (not m_configs.dataTypeOf(path)));
+}
+
+bool ReloadScheduler::defer(const PeekedConfig& peekedConfig)
+{
+	const FilePath& path = peekedConfig.path;
+
+	// データタイプを読んでいる間に読み込みが始まった場合は、通常どおり読み込みます。
+	if (m_configLoader.isLoading(path) || m_waitingPaths.contains(path))
+	{
+		return false;
+	}
+
+	// まだパースしていない config ファイルが削除された場合は、記録を取り除くだけです。
+	if (peekedConfig.removed)
+	{
+		return (m_configs.isDeferred(path) && m_configs.erase(path));
+	}
+
+	// データタイプが読めないファイル（include されるファイルなど）は、通常どおり読み込みます。
+	if ((not peekedConfig.dataType) || (not m_configs.defer(path, *peekedConfig.dataType)))
+	{
+		return false;
+	}
+
+	if (m_options.prefetch)
+	{
+		m_prefetchFiles.push_back(path);
+	}
+
+	return true;
+}
+
+void ReloadScheduler::reprioritize()
+{
+	std::array<std::deque<FilePath>, NumPriorities> waitingFiles;
+
+	// 同じ優先度のファイルは、読み込み待ちに加えた順を保ちます。
+	for (auto& files : m_waitingFiles)
+	{
+		for (auto& path : files)
+		{
+			const ReloadPriority priority = priorityOf(path);
+			waitingFiles[FromEnum(priority)].push_back(std::move(path));
+		}
+	}
+
+	m_waitingFiles = std::move(waitingFiles);
+}
+
+void ReloadScheduler::dispatch()
+{
+	const size_t maxInFlight = ((m_options.maxInFlight != 0) ? m_options.maxInFlight : (Max<size_t>(m_configLoader.numThreads(), 1) * 4));
+	const size_t numInFlight = m_configLoader.numPending();
+
+	if (maxInFlight <= numInFlight)
+	{
+		return;
+	}
+
+	Array<FilePath> paths;
+
+	for (auto& files : m_waitingFiles)
+	{
+		while ((not files.empty()) && ((numInFlight + paths.size()) < maxInFlight))
+		{
+			m_waitingPaths.erase(files.front());
+			paths << std::move(files.front());
+			files.pop_front();
+		}
+	}
+
+	// 読み込み待ちのファイルを全て依頼しても空きがある場合だけ、まだパースしていない config ファイルを読み込んでおきます。
+	while ((not m_prefetchFiles.empty()) && ((numInFlight + paths.size()) < maxInFlight))
+	{
+		FilePath path = std::move(m_prefetchFiles.front());
+		m_prefetchFiles.pop_front();
+
+		// 既にパースされたファイルや、同じファイルが重ねて加えられた場合は読み込みません。
+		if (m_configs.isDeferred(path) && (not m_configLoader.isLoading(path)) && (not paths.contains(path)))
+		{
+			paths << std::move(path);
+		}
+	}
+
+	m_configLoader.request(paths);
+}
+
+void ReloadScheduler::apply(const uint64 deadlineMicrosec)
+{
+	// 予算を超えていても、毎フレーム少なくとも 1 つは反映します。
+	for (size_t numApplied = 0; ((not m_loadedConfigs.empty()) && ((numApplied == 0) || (Time::GetMicrosec() < deadlineMicrosec))); ++numApplied)
+	{
+		LoadedConfig& loadedConfig = m_loadedConfigs.front();
+
+		if (loadedConfig.removed)
+		{
+			m_configs.erase(loadedConfig.path);
+		}
+		else
+		{
+			m_configs.insertOrAssign(loadedConfig.path, std::move(loadedConfig.config));
+		}
+
+		m_loadedConfigs.pop_front();
+	}
+}
+
+bool ReloadScheduler::isHot(const TypeAccess& access) const noexcept
+{
+	return ((access.lastAccessFrame != 0) && ((m_frameCount - access.lastAccessFrame) <= m_options.hotFrames));
+}
@@ -0,0 +1,156 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include <deque>
+# include "ConfigLoader.hpp"
+# include "ConfigStore.hpp"
+
+/// @brief config ファイルの読み込みの優先度
+enum class ReloadPriority : uint8
+{
+	/// @brief 最近参照されたデータタイプの config ファイル
+	High,
+
+	/// @brief まだ読み込んだことがなく、データタイプが分からない config ファイル
+	Normal,
+
+	/// @brief 最近参照されていないデータタイプの config ファイル
+	Low,
+};
+
+/// @brief 変更された config ファイルの読み込みと ConfigStore への反映を、1 フレームあたりの時間の予算内で行います。
+/// @remark 予算内に終わらなかったファイルは次のフレームに持ち越します。参照されているデータタイプの config ファイルから先に読み込みます。
+/// @remark メインスレッドから呼び出します。
+class ReloadScheduler
+{
+public:
+
+	/// @brief スケジューラの設定
+	struct Options
+	{
+		/// @brief 1 フレームで読み込みの依頼と反映に使う時間（ミリ秒）
+		double frameBudgetMillisec = 2.0;
+
+		/// @brief 同時に読み込む config ファイルの最大数です。0 の場合はワーカースレッドの数の 4 倍にします。
+		/// @remark 読み込み待ちのファイルを全てワーカースレッドに渡すと優先度が効かなくなるため、少しずつ渡します。
+		size_t maxInFlight = 0;
+
+		/// @brief 最後に参照されてから、このフレーム数の間は参照されているデータタイプとみなします。
+		uint64 hotFrames = 60;
+
+		/// @brief true の場合、まだ参照も購読もされていないデータタイプの config ファイルはデータタイプだけを読んでおき、初めて参照されたときにパースします。
+		/// @remark 多くの config ファイルのうち一部しか使わない場合に、起動時の読み込みの時間とメモリを減らせます。
+		bool lazy = false;
+
+		/// @brief lazy が true の場合に、読み込み待ちのファイルが無いフレームで、まだパースしていない config ファイルをワーカースレッドで読み込んでおきます。
+		bool prefetch = false;
+	};
+
+	/// @brief ReloadScheduler を作成します。
+	/// @param configLoader 読み込みに使う ConfigLoader
+	/// @param configs 読み込んだ config を格納する ConfigStore
+	/// @param options 設定
+	ReloadScheduler(ConfigLoader& configLoader, ConfigStore& configs, const Options& options);
+
+	ReloadScheduler(ConfigLoader& configLoader, ConfigStore& configs);
+
+	~ReloadScheduler();
+
+	ReloadScheduler(const ReloadScheduler&) = delete;
+
+	ReloadScheduler& operator=(const ReloadScheduler&) = delete;
+
+	/// @brief 変更された config ファイルを読み込み待ちに加えます。
+	/// @param paths 変更のあった config ファイルの絶対パス
+	/// @remark 読み込み待ちのファイルが再度変更された場合は、1 回だけ読み込みます。
+	/// lazy が true の場合、まだパースしていない config ファイルはワーカースレッドでデータタイプだけを読み、まだ参照されていないデータタイプであれば ConfigStore に記録だけします。
+	void enqueue(const Array<FilePath>& paths);
+
+	/// @brief 予算内で読み込みを依頼し、読み込みが完了した config を ConfigStore に反映して公開します。毎フレーム 1 回呼び出します。
+	/// @return 公開したスナップショットの世代
+	uint64 update();
+
+	/// @brief 1 フレームで使う時間を設定します。
+	/// @param frameBudgetMillisec 時間（ミリ秒）
+	void setFrameBudget(double frameBudgetMillisec) noexcept;
+
+	/// @brief データタイプの読み取り中、読み込み待ち、読み込み中、反映待ちの config ファイルの数を返します。
+	[[nodiscard]]
+	size_t numPending() const noexcept;
+
+	/// @brief config ファイルの読み込みの優先度を返します。
+	/// @param path config ファイルの絶対パス
+	[[nodiscard]]
+	ReloadPriority priorityOf(const FilePath& path) const;
+
+private:
+
+	/// @brief 優先度の数
+	static constexpr size_t NumPriorities = (FromEnum(ReloadPriority::Low) + 1);
+
+	ConfigLoader& m_configLoader;
+
+	ConfigStore& m_configs;
+
+	Options m_options;
+
+	/// @brief 優先度ごとの読み込み待ちのファイル
+	std::array<std::deque<FilePath>, NumPriorities> m_waitingFiles;
+
+	/// @brief 読み込み待ちのファイル（重複を防ぐため）
+	HashSet<FilePath> m_waitingPaths;
+
+	/// @brief 読み込みが完了し、反映を待っている config
+	std::deque<LoadedConfig> m_loadedConfigs;
+
+	/// @brief 先に読み込んでおく、まだパースしていない config ファイル
+	std::deque<FilePath> m_prefetchFiles;
+
+	/// @brief ワーカースレッドでデータタイプを読んでいる途中のファイル
+	HashSet<FilePath> m_peekingPaths;
+
+	/// @brief データタイプを読んでいる途中に再度変更され、読み終えた後にもう一度読むファイル
+	HashSet<FilePath> m_repeekPaths;
+
+	/// @brief データタイプの参照の記録
+	struct TypeAccess
+	{
+		/// @brief 前回確認したときの参照回数
+		uint64 numAccesses = 0;
+
+		/// @brief 最後に参照されたフレーム
+		uint64 lastAccessFrame = 0;
+	};
+
+	/// @brief データタイプごとの参照の記録
+	HashTable<String, TypeAccess> m_typeAccesses;
+
+	/// @brief update() を呼んだ回数
+	uint64 m_frameCount = 0;
+
+	/// @brief データタイプの参照回数を確認し、参照されているデータタイプが変わった場合 true を返します。
+	bool updateTypeAccesses();
+
+	/// @brief ファイルを読み込み待ちに加えます。既に読み込み待ちの場合は何もしません。
+	void addWaiting(const FilePath& path);
+
+	/// @brief パースせずにデータタイプだけを読むファイルかを返します。
+	[[nodiscard]]
+	bool shouldPeek(const FilePath& path) const;
+
+	/// @brief データタイプを読んだ config ファイルを、パースせずに ConfigStore に記録します。
+	/// @return 記録した場合 true, 通常どおり読み込む場合は false
+	bool defer(const PeekedConfig& peekedConfig);
+
+	/// @brief 読み込み待ちのファイルの優先度を付け直します。
+	void reprioritize();
+
+	/// @brief 同時に読み込む数の上限まで、優先度の高いファイルから読み込みを依頼します。読み込み待ちのファイルが無い場合は、先に読み込んでおくファイルを依頼します。
+	void dispatch();
+
+	/// @brief 予算内で、読み込みが完了した config を反映します。
+	void apply(uint64 deadlineMicrosec);
+
+	/// @brief 最近参照されたデータタイプかを返します。
+	[[nodiscard]]
+	bool isHot(const TypeAccess& access) const noexcept;
+};
@@ -0,0 +1,91 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+
+/// @brief ConfigSchema と TableSchema に共通する、フィールドごとの比較と、フィールドの構成の比較を行います。
+/// @remark フィールドの宣言は、メンバ変数へのポインタ member を持つ構造体の std::tuple です。
+namespace SchemaDiff
+{
+	namespace detail
+	{
+		template <class ConfigType, class Fields, size_t... Indices>
+		[[nodiscard]]
+		uint64 Diff(const Fields& fields, const ConfigType& a, const ConfigType& b, std::index_sequence<Indices...>)
+		{
+			uint64 mask = 0;
+			((mask |= ((a.*(std::get<Indices>(fields).member) == b.*(std::get<Indices>(fields).member)) ? 0 : (uint64{ 1 } << Indices))), ...);
+			return mask;
+		}
+
+		template <class ConfigType, class FieldType, class MemberType>
+		[[nodiscard]]
+		constexpr bool IsSameMember(FieldType ConfigType::* fieldMember, MemberType ConfigType::* member) noexcept
+		{
+			if constexpr (std::is_same_v<FieldType, MemberType>)
+			{
+				return (fieldMember == member);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		/// @brief メンバ変数の型の名前を返します。
+		template <class ConfigType, class FieldType>
+		[[nodiscard]]
+		String MemberTypeName(FieldType ConfigType::*)
+		{
+			return Unicode::Widen(typeid(FieldType).name());
+		}
+
+		template <class ConfigType, class Fields, class MemberType, size_t... Indices>
+		[[nodiscard]]
+		constexpr uint64 FieldMask(const Fields& fields, MemberType ConfigType::* member, std::index_sequence<Indices...>) noexcept
+		{
+			uint64 mask = 0;
+			((mask |= (IsSameMember(std::get<Indices>(fields).member, member) ? (uint64{ 1 } << Indices) : 0)), ...);
+			return mask;
+		}
+	}
+
+	/// @brief 2 つの config をフィールドごとに比較します。
+	/// @param fields フィールドの宣言
+	/// @param a 比較する config
+	/// @param b 比較する config
+	/// @return 値が異なるフィールドのビットマスクです。i 番目のフィールドが異なる場合、i 番目のビットが 1 になります。
+	template <class ConfigType, class... Fields>
+	[[nodiscard]]
+	uint64 Diff(const std::tuple<Fields...>& fields, const ConfigType& a, const ConfigType& b)
+	{
+		return detail::Diff(fields, a, b, std::index_sequence_for<Fields...>{});
+	}
+
+	/// @brief メンバ変数に対応するフィールドのビットマスクを返します。
+	/// @param fields フィールドの宣言
+	/// @param member メンバ変数
+	/// @return フィールドのビットマスク。フィールドに含まれないメンバ変数の場合は 0
+	template <class ConfigType, class MemberType, class... Fields>
+	[[nodiscard]]
+	constexpr uint64 FieldMask(const std::tuple<Fields...>& fields, MemberType ConfigType::* member) noexcept
+	{
+		return detail::FieldMask(fields, member, std::index_sequence_for<Fields...>{});
+	}
+
+	/// @brief フィールドの名前、メンバ変数の型、required を並べた文字列を返します。
+	/// @param fields フィールドの宣言
+	/// @return フィールドの構成を表す文字列です。フィールドを追加・削除・並べ替えたり、型を変えたりすると変わります。
+	/// @remark 型の名前に typeid を使うため、キャッシュの検証など、頻繁に呼ばれない処理で使います。
+	template <class... Fields>
+	[[nodiscard]]
+	String Signature(const std::tuple<Fields...>& fields)
+	{
+		String signature;
+
+		std::apply([&](const auto&... field)
+			{
+				((signature += U"/{}:{}:{}"_fmt(field.name, detail::MemberTypeName(field.member), field.required)), ...);
+			}, fields);
+
+		return signature;
+	}
+}
@@ -0,0 +1,410 @@
+﻿# include "TableConfig.hpp"
+# include <charconv>
+
+namespace
+{
+	/// @brief UTF-8 の BOM
+	constexpr std::string_view UTF8BOM = "\xEF\xBB\xBF";
+
+	/// @brief Blob の内容を文字列として返します。BOM は取り除きます。
+	[[nodiscard]]
+	static std::string_view ToText(const Blob& blob) noexcept
+	{
+		std::string_view text{ static_cast<const char*>(static_cast<const void*>(blob.data())), blob.size() };
+
+		if (text.starts_with(UTF8BOM))
+		{
+			text.remove_prefix(UTF8BOM.size());
+		}
+
+		return text;
+	}
+
+	[[nodiscard]]
+	static std::string_view Trim(std::string_view text) noexcept
+	{
+		constexpr std::string_view Whitespace = " \t\r\n";
+
+		if (const size_t begin = text.find_first_not_of(Whitespace); (begin == std::string_view::npos))
+		{
+			return{};
+		}
+		else
+		{
+			text.remove_prefix(begin);
+		}
+
+		return text.substr(0, (text.find_last_not_of(Whitespace) + 1));
+	}
+
+	/// @brief CSV の 1 行を読み込みます。
+	/// @param text 読み込む位置から始まる CSV です。読み込んだ行の次の行の先頭まで進めます。
+	/// @param cells 読み込んだセルを追加します。
+	/// @param unescapedCells `""` を含むセルの文字列を格納します。
+	/// @return 読み込めた場合 true, 引用符が閉じていない場合は false
+	[[nodiscard]]
+	static bool ReadCSVRow(std::string_view& text, Array<std::string_view>& cells, std::deque<std::string>& unescapedCells)
+	{
+		for (;;)
+		{
+			if (text.starts_with('"'))
+			{
+				// 引用符で囲まれたセル
+				size_t end = 1;
+				bool hasEscape = false;
+
+				for (;; ++end)
+				{
+					end = text.find('"', end);
+
+					if (end == std::string_view::npos)
+					{
+						return false;
+					}
+
+					if ((end + 1) < text.size() && (text[end + 1] == '"'))
+					{
+						hasEscape = true;
+						++end;
+						continue;
+					}
+
+					break;
+				}
+
+				const std::string_view cell = text.substr(1, (end - 1));
+
+				if (hasEscape)
+				{
+					std::string& unescaped = unescapedCells.emplace_back();
+					unescaped.reserve(cell.size());
+
+					for (size_t i = 0; i < cell.size(); ++i)
+					{
+						unescaped.push_back(cell[i]);
+						i += ((cell[i] == '"') ? 1 : 0);
+					}
+
+					cells << std::string_view{ unescaped };
+				}
+				else
+				{
+					cells << cell;
+				}
+
+				text.remove_prefix(end + 1);
+			}
+			else
+			{
+				const size_t end = text.find_first_of(",\r\n");
+				cells << text.substr(0, end);
+				text.remove_prefix((end == std::string_view::npos) ? text.size() : end);
+			}
+
+			if (text.starts_with(','))
+			{
+				text.remove_prefix(1);
+				continue;
+			}
+
+			// 行末
+			if (text.starts_with("\r\n"))
+			{
+				text.remove_prefix(2);
+			}
+			else if (text.starts_with('\r') || text.starts_with('\n'))
+			{
+				text.remove_prefix(1);
+			}
+			else if (not text.empty())
+			{
+				// 引用符の後ろに余分な文字がある
+				return false;
+			}
+
+			return true;
+		}
+	}
+}
+
+Optional<size_t> TableText::indexOf(const StringView name) const
+{
+	for (size_t i = 0; i < columnNames.size(); ++i)
+	{
+		if (columnNames[i] == name)
+		{
+			return i;
+		}
+	}
+
+	return none;
+}
+
+Optional<TableText> TableText::LoadCSV(const Blob& blob)
+{
+	std::string_view text = ToText(blob);
+
+	TableText table;
+	Array<std::string_view> cells;
+
+	// 1 行目: dataType,データタイプ
+	if ((not ReadCSVRow(text, cells, table.unescapedCells)) || (cells.size() < 2) || (Trim(cells[0]) != "dataType"))
+	{
+		return none;
+	}
+
+	table.dataType = Unicode::FromUTF8(Trim(cells[1]));
+
+	// 2 行目: 列の名前
+	cells.clear();
+
+	if (not ReadCSVRow(text, cells, table.unescapedCells))
+	{
+		return none;
+	}
+
+	for (const auto& cell : cells)
+	{
+		table.columnNames << Unicode::FromUTF8(Trim(cell));
+	}
+
+	const size_t numColumns = table.columnNames.size();
+	table.columns.resize(numColumns);
+
+	// 行数の目安として改行の数だけ確保します。
+	const size_t estimatedRows = static_cast<size_t>(std::count(text.begin(), text.end(), '\n') + 1);
+
+	for (auto& column : table.columns)
+	{
+		column.reserve(estimatedRows);
+	}
+
+	while (not text.empty())
+	{
+		cells.clear();
+
+		if (not ReadCSVRow(text, cells, table.unescapedCells))
+		{
+			return none;
+		}
+
+		// 空行は読み飛ばします。
+		if ((cells.size() == 1) && cells[0].empty())
+		{
+			continue;
+		}
+
+		if (numColumns < cells.size())
+		{
+			return none;
+		}
+
+		for (size_t i = 0; i < numColumns; ++i)
+		{
+			table.columns[i] << ((i < cells.size()) ? cells[i] : std::string_view{});
+		}
+
+		++table.numRows;
+	}
+
+	return table;
+}
+
+Optional<TableText> TableText::LoadINI(const Blob& blob)
+{
+	std::string_view text = ToText(blob);
+
+	TableText table;
+	HashTable<String, size_t> columnIndices;
+	bool inSection = false;
+
+	while (not text.empty())
+	{
+		const size_t lineEnd = text.find('\n');
+		const std::string_view line = Trim(text.substr(0, lineEnd));
+		text.remove_prefix((lineEnd == std::string_view::npos) ? text.size() : (lineEnd + 1));
+
+		if (line.empty() || line.starts_with(';') || line.starts_with('#'))
+		{
+			continue;
+		}
+
+		// セクションごとに 1 行を追加します。
+		if (line.starts_with('['))
+		{
+			if (not line.ends_with(']'))
+			{
+				return none;
+			}
+
+			for (auto& column : table.columns)
+			{
+				column.emplace_back();
+			}
+
+			++table.numRows;
+			inSection = true;
+			continue;
+		}
+
+		const size_t separator = line.find('=');
+
+		if (separator == std::string_view::npos)
+		{
+			return none;
+		}
+
+		const std::string_view key = Trim(line.substr(0, separator));
+		std::string_view value = Trim(line.substr(separator + 1));
+
+		if ((2 <= value.size()) && value.starts_with('"') && value.ends_with('"'))
+		{
+			value = value.substr(1, (value.size() - 2));
+		}
+
+		if (not inSection)
+		{
+			if (key == "dataType")
+			{
+				table.dataType = Unicode::FromUTF8(value);
+			}
+
+			continue;
+		}
+
+		String name = Unicode::FromUTF8(key);
+		auto it = columnIndices.find(name);
+
+		// 初めて現れたキーは列として追加し、それまでの行は空のセルにします。
+		if (it == columnIndices.end())
+		{
+			it = columnIndices.emplace(name, table.columnNames.size()).first;
+			table.columnNames << std::move(name);
+			table.columns << Array<std::string_view>(table.numRows);
+		}
+
+		table.columns[it->second].back() = value;
+	}
+
+	if (table.dataType.isEmpty())
+	{
+		return none;
+	}
+
+	return table;
+}
+
+Optional<String> TableText::PeekDataTypeCSV(const Blob& blob)
+{
+	std::string_view text = ToText(blob);
+
+	Array<std::string_view> cells;
+	std::deque<std::string> unescapedCells;
+
+	if ((not ReadCSVRow(text, cells, unescapedCells)) || (cells.size() < 2) || (Trim(cells[0]) != "dataType"))
+	{
+		return none;
+	}
+
+	return Unicode::FromUTF8(Trim(cells[1]));
+}
+
+Optional<String> TableText::PeekDataTypeINI(const Blob& blob)
+{
+	std::string_view text = ToText(blob);
+
+	while (not text.empty())
+	{
+		const size_t lineEnd = text.find('\n');
+		const std::string_view line = Trim(text.substr(0, lineEnd));
+		text.remove_prefix((lineEnd == std::string_view::npos) ? text.size() : (lineEnd + 1));
+
+		// dataType はセクションの外に書くため、最初のセクションで打ち切ります。
+		if (line.starts_with('['))
+		{
+			return none;
+		}
+
+		const size_t separator = line.find('=');
+
+		if (line.starts_with(';') || line.starts_with('#') || (separator == std::string_view::npos))
+		{
+			continue;
+		}
+
+		if (Trim(line.substr(0, separator)) != "dataType")
+		{
+			continue;
+		}
+
+		std::string_view value = Trim(line.substr(separator + 1));
+
+		if ((2 <= value.size()) && value.starts_with('"') && value.ends_with('"'))
+		{
+			value = value.substr(1, (value.size() - 2));
+		}
+
+		if (value.empty())
+		{
+			return none;
+		}
+
+		return Unicode::FromUTF8(value);
+	}
+
+	return none;
+}
+
+namespace TableParser
+{
+	template <>
+	bool ParseCell<int32>(std::string_view cell, int32& value)
+	{
+		cell = Trim(cell);
+		const auto result = std::from_chars(cell.data(), (cell.data() + cell.size()), value);
+		return ((result.ec == std::errc{}) && (result.ptr == (cell.data() + cell.size())));
+	}
+
+	template <>
+	bool ParseCell<int64>(std::string_view cell, int64& value)
+	{
+		cell = Trim(cell);
+		const auto result = std::from_chars(cell.data(), (cell.data() + cell.size()), value);
+		return ((result.ec == std::errc{}) && (result.ptr == (cell.data() + cell.size())));
+	}
+
+	template <>
+	bool ParseCell<double>(std::string_view cell, double& value)
+	{
+		cell = Trim(cell);
+		const auto result = std::from_chars(cell.data(), (cell.data() + cell.size()), value);
+		return ((result.ec == std::errc{}) && (result.ptr == (cell.data() + cell.size())));
+	}
+
+	template <>
+	bool ParseCell<bool>(std::string_view cell, bool& value)
+	{
+		cell = Trim(cell);
+
+		if ((cell == "true") || (cell == "1"))
+		{
+			value = true;
+			return true;
+		}
+
+		if ((cell == "false") || (cell == "0"))
+		{
+			value = false;
+			return true;
+		}
+
+		return false;
+	}
+
+	template <>
+	bool ParseCell<String>(const std::string_view cell, String& value)
+	{
+		value = Unicode::FromUTF8(cell);
+		return true;
+	}
+}
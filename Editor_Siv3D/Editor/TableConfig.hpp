@@ -0,0 +1,287 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include <deque>
+# include "SchemaDiff.hpp"
+# include "ThreadPool.hpp"
+
+/// @brief CSV または INI ファイルから読み込んだ、型に変換する前の表です。
+/// @remark セルはファイルの内容を指す std::string_view です。読み込み元の Blob は TableText より長く存在する必要があります。
+struct TableText
+{
+	/// @brief データタイプ
+	String dataType;
+
+	/// @brief 列の名前
+	Array<String> columnNames;
+
+	/// @brief 列ごとのセル（UTF-8）です。columns[列][行] の順に並びます。値が無いセルは空です。
+	Array<Array<std::string_view>> columns;
+
+	/// @brief 行の数
+	size_t numRows = 0;
+
+	/// @brief エスケープを解除したセルの文字列（セルから参照されます）
+	std::deque<std::string> unescapedCells;
+
+	/// @brief 名前が一致する列のインデックスを返します。
+	/// @param name 列の名前
+	/// @return 列のインデックス。見つからない場合は none
+	[[nodiscard]]
+	Optional<size_t> indexOf(StringView name) const;
+
+	/// @brief CSV を読み込みます。
+	/// @param blob UTF-8 の CSV です。1 行目は `dataType,データタイプ`, 2 行目は列の名前、3 行目以降がデータです。
+	/// @return 読み込んだ表。形式が不正な場合は none
+	[[nodiscard]]
+	static Optional<TableText> LoadCSV(const Blob& blob);
+
+	/// @brief INI を読み込みます。
+	/// @param blob UTF-8 の INI です。セクションの外に `dataType = データタイプ` を書き、各セクションを 1 行、各キーを列として読み込みます。
+	/// @return 読み込んだ表。形式が不正な場合は none
+	[[nodiscard]]
+	static Optional<TableText> LoadINI(const Blob& blob);
+
+	/// @brief CSV の 1 行目から dataType だけを読みます。2 行目より後ろは読みません。
+	/// @param blob UTF-8 の CSV の先頭です。ファイルの一部の場合は、行の途中で終わらないようにしてください。
+	/// @return dataType。1 行目が `dataType,データタイプ` でない場合は none
+	[[nodiscard]]
+	static Optional<String> PeekDataTypeCSV(const Blob& blob);
+
+	/// @brief INI の最初のセクションより前から dataType だけを読みます。セクションより後ろは読みません。
+	/// @param blob UTF-8 の INI の先頭です。ファイルの一部の場合は、行の途中で終わらないようにしてください。
+	/// @return dataType。見つからない場合は none
+	[[nodiscard]]
+	static Optional<String> PeekDataTypeINI(const Blob& blob);
+};
+
+/// @brief 表のセルを型ごとに変換します。
+namespace TableParser
+{
+	/// @brief セルを Type に変換します。
+	/// @tparam Type int32, int64, double, bool, String のいずれかです。
+	/// @param cell UTF-8 のセルです。数値と真偽値は前後の空白を無視します。
+	/// @param value 変換した値を書き込みます。
+	/// @return 変換できた場合 true, それ以外の場合は false
+	template <class Type>
+	[[nodiscard]]
+	bool ParseCell(std::string_view cell, Type& value);
+
+	template <>
+	[[nodiscard]]
+	bool ParseCell<int32>(std::string_view cell, int32& value);
+
+	template <>
+	[[nodiscard]]
+	bool ParseCell<int64>(std::string_view cell, int64& value);
+
+	template <>
+	[[nodiscard]]
+	bool ParseCell<double>(std::string_view cell, double& value);
+
+	template <>
+	[[nodiscard]]
+	bool ParseCell<bool>(std::string_view cell, bool& value);
+
+	template <>
+	[[nodiscard]]
+	bool ParseCell<String>(std::string_view cell, String& value);
+}
+
+/// @brief 表の列の宣言です。列の名前と、値を格納する配列のメンバ変数を結び付けます。
+/// @tparam ConfigType config の型
+/// @tparam ValueType 値の型です。int32, int64, double, bool, String のいずれかです。
+template <class ConfigType, class ValueType>
+struct TableColumn
+{
+	/// @brief 列の名前
+	StringView name;
+
+	/// @brief 値を格納する配列のメンバ変数
+	Array<ValueType> ConfigType::* member;
+
+	/// @brief 表に列が無い場合にパースを失敗とするか。false の場合は全ての行が ValueType{} になります。
+	bool required = true;
+};
+
+/// @brief 表の列をまとめた宣言です。1 列を 1 つの連続した配列に変換します。
+/// @tparam ConfigType config の型
+/// @tparam ValueTypes 各列の値の型
+/// @remark 以下のように constexpr で宣言します。空のセルは ValueType{} になります。
+/// @code
+/// [[nodiscard]]
+/// static constexpr auto Schema()
+/// {
+///		return TableSchema{ TableColumn{ U"name", &EnemyTable::names }, TableColumn{ U"hp", &EnemyTable::hps } };
+/// }
+/// @endcode
+template <class ConfigType, class... ValueTypes>
+class TableSchema
+{
+public:
+	/// @brief 列の数
+	static constexpr size_t NumFields = sizeof...(ValueTypes);
+
+	static_assert((NumFields <= 64), "TableSchema supports up to 64 columns");
+
+	/// @brief 1 つのタスクで変換する行の数です。Array<bool> のビットが複数のタスクで同じワードに書き込まれないよう、64 の倍数にします。
+	static constexpr size_t RowsPerTask = 4096;
+
+	constexpr explicit TableSchema(const TableColumn<ConfigType, ValueTypes>&... columns) noexcept
+		: m_columns{ columns... } {}
+
+	/// @brief 表を config に変換します。
+	/// @param table 表
+	/// @param threadPool 変換に使うスレッドプールです。nullptr の場合は呼び出したスレッドだけで変換します。
+	/// @return 変換した config。必要な列が無いか、変換できないセルがある場合は nullptr
+	[[nodiscard]]
+	std::unique_ptr<ConfigType> parse(const TableText& table, ThreadPool* threadPool = nullptr) const
+	{
+		auto pConfig = std::make_unique<ConfigType>();
+
+		struct Task
+		{
+			size_t field;
+
+			size_t column;
+
+			size_t beginRow;
+		};
+
+		Array<Task> tasks;
+
+		if (not prepare(table, *pConfig, tasks, std::index_sequence_for<ValueTypes...>{}))
+		{
+			return nullptr;
+		}
+
+		std::atomic<bool> succeeded = true;
+
+		const auto parseTask = [&](const size_t i)
+			{
+				const Task& task = tasks[i];
+
+				if (not parseRows(table, *pConfig, task.field, task.column, task.beginRow, std::index_sequence_for<ValueTypes...>{}))
+				{
+					succeeded = false;
+				}
+			};
+
+		if (threadPool && (1 < tasks.size()))
+		{
+			threadPool->parallelFor(tasks.size(), parseTask);
+		}
+		else
+		{
+			for (size_t i = 0; i < tasks.size(); ++i)
+			{
+				parseTask(i);
+			}
+		}
+
+		if (not succeeded)
+		{
+			return nullptr;
+		}
+
+		return pConfig;
+	}
+
+	/// @brief 2 つの config を列ごとに比較します。
+	/// @return 値が異なる列のビットマスクです。i 番目の列が異なる場合、i 番目のビットが 1 になります。
+	[[nodiscard]]
+	uint64 diff(const ConfigType& a, const ConfigType& b) const
+	{
+		return SchemaDiff::Diff(m_columns, a, b);
+	}
+
+	/// @brief メンバ変数に対応する列のビットマスクを返します。
+	/// @param member メンバ変数
+	/// @return 列のビットマスク。スキーマに含まれないメンバ変数の場合は 0
+	template <class ValueType>
+	[[nodiscard]]
+	constexpr uint64 fieldMask(Array<ValueType> ConfigType::* member) const noexcept
+	{
+		return SchemaDiff::FieldMask(m_columns, member);
+	}
+
+	/// @brief 列の構成を表す文字列を返します。
+	/// @return 列の名前、値の型、required を並べた文字列
+	[[nodiscard]]
+	String signature() const
+	{
+		return SchemaDiff::Signature(m_columns);
+	}
+
+private:
+
+	std::tuple<TableColumn<ConfigType, ValueTypes>...> m_columns;
+
+	/// @brief 各列の配列を行の数に合わせ、変換のタスクを作ります。
+	template <class Task, size_t... Indices>
+	[[nodiscard]]
+	bool prepare(const TableText& table, ConfigType& config, Array<Task>& tasks, std::index_sequence<Indices...>) const
+	{
+		return (prepareColumn<Indices>(table, config, tasks) && ...);
+	}
+
+	template <size_t Index, class Task>
+	[[nodiscard]]
+	bool prepareColumn(const TableText& table, ConfigType& config, Array<Task>& tasks) const
+	{
+		const auto& column = std::get<Index>(m_columns);
+		auto& values = (config.*(column.member));
+		values.assign(table.numRows, {});
+
+		const auto columnIndex = table.indexOf(column.name);
+
+		if (not columnIndex)
+		{
+			return (not column.required);
+		}
+
+		for (size_t row = 0; row < table.numRows; row += RowsPerTask)
+		{
+			tasks << Task{ Index, *columnIndex, row };
+		}
+
+		return true;
+	}
+
+	template <size_t... Indices>
+	[[nodiscard]]
+	bool parseRows(const TableText& table, ConfigType& config, const size_t field, const size_t column, const size_t beginRow, std::index_sequence<Indices...>) const
+	{
+		bool succeeded = true;
+		(void)(((field == Indices) && ((succeeded = parseRows<Indices>(table, config, column, beginRow)), true)) || ...);
+		return succeeded;
+	}
+
+	template <size_t Index>
+	[[nodiscard]]
+	bool parseRows(const TableText& table, ConfigType& config, const size_t column, const size_t beginRow) const
+	{
+		auto& values = (config.*(std::get<Index>(m_columns).member));
+		const auto& cells = table.columns[column];
+		const size_t endRow = Min((beginRow + RowsPerTask), table.numRows);
+
+		for (size_t row = beginRow; row < endRow; ++row)
+		{
+			if (cells[row].empty())
+			{
+				continue;
+			}
+
+			using ValueType = typename std::remove_cvref_t<decltype(values)>::value_type;
+			ValueType value{};
+
+			if (not TableParser::ParseCell<ValueType>(cells[row], value))
+			{
+				return false;
+			}
+
+			values[row] = std::move(value);
+		}
+
+		return true;
+	}
+};
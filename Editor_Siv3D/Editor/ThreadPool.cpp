@@ -0,0 +1,193 @@
+﻿# include "ThreadPool.hpp"
+
+namespace
+{
+	/// @brief 現在のスレッドが属するスレッドプール
+	thread_local const ThreadPool* tl_currentPool = nullptr;
+
+	/// @brief 現在のスレッドのワーカースレッドの番号
+	thread_local size_t tl_workerIndex = 0;
+}
+
+ThreadPool::ThreadPool(size_t numThreads)
+{
+	if (numThreads == 0)
+	{
+		// メインスレッドの分を残します。
+		numThreads = Max<size_t>(std::thread::hardware_concurrency(), 2) - 1;
+	}
+
+	for (size_t i = 0; i < numThreads; ++i)
+	{
+		m_queues << std::make_unique<WorkQueue>();
+	}
+
+	for (size_t i = 0; i < numThreads; ++i)
+	{
+		m_threads.emplace_back([this, i] { run(i); });
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock{ m_sleepMutex };
+		m_stop = true;
+	}
+
+	// 未実行のタスクを破棄します。
+	for (auto& queue : m_queues)
+	{
+		std::lock_guard lock{ queue->mutex };
+		m_numQueuedTasks -= queue->tasks.size();
+		queue->tasks.clear();
+	}
+
+	m_condition.notify_all();
+
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::push(std::function<void()> task)
+{
+	const size_t index = ((tl_currentPool == this) ? tl_workerIndex : (m_nextQueue++ % m_queues.size()));
+
+	{
+		WorkQueue& queue = *m_queues[index];
+		std::lock_guard lock{ queue.mutex };
+		queue.tasks.push_back(std::move(task));
+	}
+
+	++m_numQueuedTasks;
+
+	{
+		// 待機に入る直前のワーカースレッドが通知を取りこぼさないよう、ロックを取ってから通知します。
+		std::lock_guard lock{ m_sleepMutex };
+	}
+
+	m_condition.notify_one();
+}
+
+void ThreadPool::parallelFor(const size_t count, const std::function<void(size_t)>& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// 遅れて開始したタスクが参照しても安全なように、共有する状態はヒープに置きます。
+	struct State
+	{
+		std::function<void(size_t)> function;
+
+		size_t count = 0;
+
+		std::atomic<size_t> nextIndex = 0;
+
+		std::atomic<size_t> numCompleted = 0;
+
+		std::mutex mutex;
+
+		std::condition_variable condition;
+
+		void work()
+		{
+			for (size_t i = nextIndex++; i < count; i = nextIndex++)
+			{
+				function(i);
+
+				if (++numCompleted == count)
+				{
+					std::lock_guard lock{ mutex };
+					condition.notify_all();
+				}
+			}
+		}
+	};
+
+	const auto state = std::make_shared<State>();
+	state->function = function;
+	state->count = count;
+
+	for (size_t i = 0; i < Min(numThreads(), (count - 1)); ++i)
+	{
+		push([state] { state->work(); });
+	}
+
+	state->work();
+
+	std::unique_lock lock{ state->mutex };
+	state->condition.wait(lock, [&] { return (state->numCompleted == count); });
+}
+
+size_t ThreadPool::numThreads() const noexcept
+{
+	return m_threads.size();
+}
+
+void ThreadPool::run(const size_t index)
+{
+	tl_currentPool = this;
+	tl_workerIndex = index;
+
+	for (;;)
+	{
+		if (m_stop)
+		{
+			return;
+		}
+
+		std::function<void()> task;
+
+		if (tryPop(index, task))
+		{
+			task();
+			continue;
+		}
+
+		std::unique_lock lock{ m_sleepMutex };
+		m_condition.wait(lock, [this] { return (m_stop || (m_numQueuedTasks != 0)); });
+
+		if (m_stop)
+		{
+			return;
+		}
+	}
+}
+
+bool ThreadPool::tryPop(const size_t index, std::function<void()>& task)
+{
+	const size_t numQueues = m_queues.size();
+
+	for (size_t i = 0; i < numQueues; ++i)
+	{
+		WorkQueue& queue = *m_queues[(index + i) % numQueues];
+		std::lock_guard lock{ queue.mutex };
+
+		if (queue.tasks.empty())
+		{
+			continue;
+		}
+
+		if (i == 0)
+		{
+			// 自分のキューからは、直前に追加したタスクを取り出します。
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			// 他のキューからは、最も古いタスクを盗みます。
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+
+		--m_numQueuedTasks;
+		return true;
+	}
+
+	return false;
+}
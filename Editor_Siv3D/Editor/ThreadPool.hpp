@@ -0,0 +1,81 @@
+﻿# pragma once
+# include <Siv3D.hpp>
+# include <condition_variable>
+# include <deque>
+# include <mutex>
+# include <thread>
+
+/// @brief タスクをワーカースレッドで実行するスレッドプールです。
+/// @remark ワーカースレッドごとにタスクのキューを持ち、自分のキューが空になったワーカースレッドは他のキューからタスクを盗みます。
+class ThreadPool
+{
+public:
+	/// @brief スレッドプールを作成します。
+	/// @param numThreads ワーカースレッドの数です。0 の場合は論理コア数から自動で決定します。
+	explicit ThreadPool(size_t numThreads = 0);
+
+	/// @brief 未実行のタスクを破棄し、全てのワーカースレッドの終了を待ちます。
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/// @brief タスクを追加します。
+	/// @param task ワーカースレッドで実行する関数です。
+	/// @remark ワーカースレッドから呼び出した場合は、そのワーカースレッドのキューに追加されます。
+	void push(std::function<void()> task);
+
+	/// @brief 0 から count - 1 までの各インデックスについて関数を並列に実行し、全て完了するまで待ちます。
+	/// @param count 実行する回数
+	/// @param function 各インデックスについて実行する関数です。
+	/// @remark 呼び出したスレッドも処理に加わります。
+	void parallelFor(size_t count, const std::function<void(size_t)>& function);
+
+	/// @brief ワーカースレッドの数を返します。
+	/// @return ワーカースレッドの数
+	[[nodiscard]]
+	size_t numThreads() const noexcept;
+
+private:
+
+	/// @brief ワーカースレッドごとのタスクのキュー
+	struct WorkQueue
+	{
+		std::mutex mutex;
+
+		std::deque<std::function<void()>> tasks;
+	};
+
+	/// @brief ワーカースレッドの処理です。
+	/// @param index ワーカースレッドの番号
+	void run(size_t index);
+
+	/// @brief タスクを 1 つ取り出します。自分のキューは後ろから、他のキューは前から取り出します。
+	/// @param index ワーカースレッドの番号
+	/// @param task 取り出したタスク
+	/// @return 取り出せた場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool tryPop(size_t index, std::function<void()>& task);
+
+	/// @brief ワーカースレッドごとのタスクのキュー
+	Array<std::unique_ptr<WorkQueue>> m_queues;
+
+	/// @brief ワーカースレッド以外から追加されたタスクを入れるキューの番号
+	std::atomic<size_t> m_nextQueue = 0;
+
+	/// @brief 全てのキューに入っているタスクの数
+	std::atomic<size_t> m_numQueuedTasks = 0;
+
+	/// @brief 待機中のワーカースレッドを起こすためのミューテックス
+	std::mutex m_sleepMutex;
+
+	/// @brief タスクの追加と終了を通知する条件変数
+	std::condition_variable m_condition;
+
+	/// @brief 終了要求
+	std::atomic<bool> m_stop = false;
+
+	/// @brief ワーカースレッド
+	Array<std::thread> m_threads;
+};
@@ -2,7 +2,14 @@
 # include "Editor/Editor.hpp"
 # include "Editor/JSONParser.hpp"
 # include "Editor/IConfig.hpp"
+# include "Editor/ConfigSchema.hpp"
 # include "Editor/ConfigParser.hpp"
+# include "Editor/ConfigLoader.hpp"
+# include "Editor/ConfigStore.hpp"
+# include "Editor/ConfigBundle.hpp"
+# include "Editor/ReloadScheduler.hpp"
+# include "Editor/ReloadProfiler.hpp"
+# include "Editor/ReloadProfilerAddon.hpp"
 
 struct SolidColorBackground : IConfig
 {
@@ -21,17 +28,22 @@ struct SolidColorBackground : IConfig
 		return DataType;
 	}
 
+	[[nodiscard]]
+	static constexpr auto Schema()
+	{
+		return ConfigSchema{ ConfigField{ U"color", &SolidColorBackground::color } };
+	}
+
 	[[nodiscard]]
 	static std::unique_ptr<SolidColorBackground> Parse(const JSON& json)
 	{
-		if (const auto color = JSONParser::ReadColorF(json, U"color"))
-		{
-			return std::make_unique<SolidColorBackground>(*color);
-		}
-		else
-		{
-			return nullptr;
-		}
+		return Schema().parse(json);
+	}
+
+	template <class Archive>
+	void SIV3D_SERIALIZE(Archive& archive)
+	{
+		archive(color);
 	}
 };
 
@@ -54,20 +66,24 @@ struct CircleObject :IConfig
 		return DataType;
 	}
 
+	[[nodiscard]]
+	static constexpr auto Schema()
+	{
+		return ConfigSchema{
+			ConfigField{ U"center", &CircleObject::center },
+			ConfigField{ U"radius", &CircleObject::radius } };
+	}
+
 	[[nodiscard]]
 	static std::unique_ptr<CircleObject> Parse(const JSON& json)
 	{
-		const auto center = JSONParser::ReadVec2(json, U"center");
-		const auto radius = JSONParser::ReadDouble(json, U"radius");
+		return Schema().parse(json);
+	}
 
-		if (center && radius)
-		{
-			return std::make_unique<CircleObject>(*center, *radius);
-		}
-		else
-		{
-			return nullptr;
-		}
+	template <class Archive>
+	void SIV3D_SERIALIZE(Archive& archive)
+	{
+		archive(center, radius);
 	}
 };
 
@@ -92,22 +108,58 @@ struct TestParsePrint :IConfig
 		return DataType;
 	}
 
+	[[nodiscard]]
+	static constexpr auto Schema()
+	{
+		return ConfigSchema{
+			ConfigField{ U"count", &TestParsePrint::loopCount },
+			ConfigField{ U"print", &TestParsePrint::text },
+			ConfigField{ U"displayable", &TestParsePrint::isPrinted } };
+	}
+
 	[[nodiscard]]
 	static std::unique_ptr<TestParsePrint> Parse(const JSON& json)
 	{
-		const auto loopCount = JSONParser::ReadInt32(json, U"count");
-		const auto text = JSONParser::ReadString(json, U"print");
-		const auto isPrinted = JSONParser::ReadBool(json, U"displayable");
+		return Schema().parse(json);
+	}
 
-		// 全ての値が取得できた場合を書きたいが、boolの場合はfalseの場合もあるので、isPrintedがfalseの場合は無視する
-		if (loopCount && text && isPrinted)
-		{
-			return std::make_unique<TestParsePrint>(*loopCount, *text, *isPrinted);
-		}
-		else
-		{
-			return nullptr;
-		}
+	template <class Archive>
+	void SIV3D_SERIALIZE(Archive& archive)
+	{
+		archive(loopCount, text, isPrinted);
+	}
+};
+
+// 表の config は、列ごとに 1 つの配列に読み込みます。
+struct CircleTable : IConfig
+{
+	static constexpr StringView DataType = U"circleTable";
+
+	Array<double> x;
+
+	Array<double> y;
+
+	Array<double> radius;
+
+	[[nodiscard]]
+	StringView dataType() const override
+	{
+		return DataType;
+	}
+
+	[[nodiscard]]
+	static constexpr auto Schema()
+	{
+		return TableSchema{
+			TableColumn{ U"x", &CircleTable::x },
+			TableColumn{ U"y", &CircleTable::y },
+			TableColumn{ U"radius", &CircleTable::radius } };
+	}
+
+	template <class Archive>
+	void SIV3D_SERIALIZE(Archive& archive)
+	{
+		archive(x, y, radius);
 	}
 };
 
@@ -125,58 +177,99 @@ void Main()
 		throw Error{ U"Editorの初期化に失敗しました" };
 	}
 
-	if (not editor.prepareConfigDirectory())
-	{
-		throw Error{ U"configディレクトリの準備に失敗しました" };
-	}
-
 	Scene::SetBackground(ColorF{ 0.6, 0.8, 0.7 });
 
-	// 読み込んだ config ファイルを格納するための HashTable を用意します。[データタイプ, データのポインタ]
-	HashTable<String, std::unique_ptr<IConfig>> configs;
+	// 読み込んだ config を格納する ConfigStore を用意します。config ファイルごとに 1 つの config を格納します。
+	ConfigStore configs;
+	configs.addType<SolidColorBackground>();
+	configs.addType<CircleObject>();
+	configs.addType<TestParsePrint>();
+	configs.addType<CircleTable>();
 
 	// ConfigParser に JSONParser を登録します。
 	ConfigParser configParser;
-	configParser.addJSONParser(SolidColorBackground::DataType, &SolidColorBackground::Parse);
-	configParser.addJSONParser(CircleObject::DataType, &CircleObject::Parse);
-	configParser.addJSONParser(TestParsePrint::DataType, &TestParsePrint::Parse);
+	configParser.addJSONParser<SolidColorBackground>();
+	// CircleObject は数が多いため、DOM を作らないストリームパーサーでパースします。
+	configParser.addJSONStreamParser<CircleObject>();
+	configParser.addJSONParser<TestParsePrint>();
 
-	
-	while (System::Update())
-	{
-		editor.update();
+	// CSV と INI の表は addTableParser で登録します。
+	configParser.addTableParser<CircleTable>();
 
-		//変更のあった config ディレクトリを全て調べます。
-		for (const auto& changedConfigFile : editor.retrieveChangedConfigFiles())
-		{
-			// ファイルパスを相対パスに変換します。
-			const FilePath friendlyPath = FileSystem::RelativePath(changedConfigFile);
-			Editor::ShowInfo(U"configファイル`{}`が更新されました。"_fmt(friendlyPath));
+	// 前回の起動時から変更のない config ファイルは、キャッシュから復元します。
+	configParser.enableCache(U"cache/config/");
 
-			// 拡張子が .json の場合、JSON ファイルとして読み込みます。
-			if (const String extension = FileSystem::Extension(changedConfigFile); (extension == U"json"))
+	// config ファイルのロードとパースはワーカースレッドで行います。
+	ConfigLoader configLoader{ configParser };
+
+	// 大量のファイルが変更されても 1 フレームが長くならないよう、読み込んだ config の反映は 1 フレーム 2 ms までにして残りは次のフレームに持ち越します。
+	// 毎フレーム参照しているデータタイプの config ファイルから先に読み込みます。
+	// 一部のデータタイプしか使わない場合は .lazy = true にすると、config ファイルはデータタイプが初めて参照されたときにパースされます（.prefetch = true で空いているワーカースレッドで先に読み込みます）。
+	ReloadScheduler reloadScheduler{ configLoader, configs, ReloadScheduler::Options{ .frameBudgetMillisec = 2.0 } };
+
+	// 背景色は、config の color が変わったときだけ設定し直します。
+	configs.subscribe(&SolidColorBackground::color, [](const ConfigChange<SolidColorBackground>& change)
+		{
+			if (change.current)
 			{
-				// パースが失敗（nullptr）なら何もしません。
-				if (auto pConfig = configParser.parseJSON(changedConfigFile, friendlyPath))
-				{
-					// パースに成功した場合、configs に追加します。
-					configs[pConfig->dataType()] = std::move(pConfig);
-				}
+				Scene::SetBackground(change.current->color);
 			}
-		}
+		});
 
-		// configs に格納されたデータを使った処理を行います。
-		if (auto p = GetConfig<SolidColorBackground>(configs))
-		{
-			Scene::SetBackground(p->color);
-		}
+	// 毎フレーム参照する config は、ハンドルを作っておくとハッシュ計算なしで参照できます。
+	const auto testParsePrint = configs.handle<TestParsePrint>();
+
+	bool loadedFromBundle = false;
 
-		if (auto p = GetConfig<CircleObject>(configs))
+# if SIV3D_BUILD(RELEASE)
+
+	// Release ビルドでは、bake した bundle があれば JSON をパースせずに config を復元します。
+	if (ConfigBundle bundle; bundle.open(U"config.bundle"))
+	{
+		for (auto& loadedConfig : bundle.load(configParser, U"config/"))
 		{
-			Circle{ p->center,p->radius }.draw();
+			configs.insertOrAssign(loadedConfig.path, std::move(loadedConfig.config));
 		}
 
-		if (auto p = GetConfig<TestParsePrint>(configs))
+		configs.publish();
+		loadedFromBundle = true;
+	}
+
+# endif
+
+	// bundle を使わない場合は config ディレクトリを監視し、JSON ファイルをホットリロードします。
+	if ((not loadedFromBundle) && (not editor.prepareConfigDirectory()))
+	{
+		throw Error{ U"configディレクトリの準備に失敗しました" };
+	}
+
+	while (System::Update())
+	{
+		editor.update();
+
+		//変更のあった config ファイルを読み込み待ちに加えます。
+		reloadScheduler.enqueue(editor.retrieveChangedConfigFiles());
+
+		// 読み込みが完了した config を予算内で configs に追加し、削除された config ファイルの config を取り除きます。
+		// このフレームの変更はまとめて公開されます。他のスレッドは configs.snapshot() で、変更の途中ではない config を参照できます。
+		reloadScheduler.update();
+
+		// configs に格納されたデータを使った処理を行います。
+		// 同じデータタイプの config が複数ある場合は forEach でまとめて処理します。
+		configs.forEach<CircleObject>([](const CircleObject& circle)
+			{
+				Circle{ circle.center, circle.radius }.draw();
+			});
+
+		configs.forEach<CircleTable>([](const CircleTable& table)
+			{
+				for (size_t i = 0; i < table.x.size(); ++i)
+				{
+					Circle{ table.x[i], table.y[i], table.radius[i] }.draw(ColorF{ 0.2, 0.4, 0.8 });
+				}
+			});
+
+		if (auto p = testParsePrint.get())
 		{
 			if (MouseR.down() && p->isPrinted)
 			{
@@ -212,5 +305,41 @@ void Main()
 		{
 			Editor::ShowError(U"error");
 		}
+
+		// config の変更から反映までの時間の表を表示します。
+		if (SimpleGUI::Button(U"profiler", Vec2{ 1100, 320 }, 160))
+		{
+			ReloadProfiler::SetEnabled(true);
+			ReloadProfilerAddon::SetVisible(not ReloadProfilerAddon::IsVisible());
+		}
+
+		// 集計した時間を CSV と JSON に書き出します。
+		if (SimpleGUI::Button(U"export profile", Vec2{ 1100, 360 }, 160))
+		{
+			if (ReloadProfiler::ExportCSV(U"profile/reload.csv") && ReloadProfiler::ExportJSON(U"profile/reload.json"))
+			{
+				Editor::ShowSuccess(U"読み込み時間の集計を profile/ に書き出しました。");
+			}
+			else
+			{
+				Editor::ShowError(U"読み込み時間の集計の書き出しに失敗しました。");
+			}
+		}
+
+		// 詳細な通知とログの出力を切り替えます。Release ビルドでも有効にできます。
+		if (bool verbose = Editor::IsVerbose(); SimpleGUI::CheckBox(verbose, U"verbose log", Vec2{ 1100, 400 }, 160))
+		{
+			Editor::SetVerbose(verbose);
+		}
+
+# if SIV3D_BUILD(DEBUG)
+
+		// config ディレクトリの JSON ファイルを、Release ビルドで使う bundle に書き出します。
+		if (SimpleGUI::Button(U"bake", Vec2{ 1100, 260 }, 160))
+		{
+			ConfigBundle::Bake(configParser, U"config/", U"config.bundle");
+		}
+
+# endif
 	}
 }